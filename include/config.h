@@ -86,4 +86,123 @@
 //22000 should work fine for a 2x extended stage, the vanilla value is 7000
 #define SURFACE_NODE_POOL_SIZE 7000
 
+/*
+    Static collision index (PC only):
+    0: The level's floors and ceilings are only split into the collision cells set above.
+    1: Cells with many floors or ceilings are further split into a quadtree, down to squares
+        of 64 units. Queries return the same surfaces as mode 0, but look through shorter lists.
+        Uses more RAM, mostly worth it for extended bounds modes with big cells.
+*/
+#define STATIC_PARTITION_MODE 0
+
+/*
+    Static floor query cache (PC only):
+    Remembers where find_floor landed in the level geometry for recently queried points, so the
+    same point queried again (in this frame or a later one) skips the static floor search.
+    Object floors are always searched. The cache is cleared when an area is loaded.
+*/
+// #define FLOOR_QUERY_CACHE
+
+/*
+    Collision profiler (PC only):
+    Times every floor, ceiling, wall and ray query and charges it to the function that made it
+    and the behavior of the object being updated. Writes a per-frame report and, for each area
+    that is left, its most expensive call sites and a heat map of its collision cells to
+    collision_profile.txt. Adds some overhead to each query, so leave it off for normal builds.
+*/
+// #define COLLISION_PROFILER
+
+/*
+    C-Up exit raycast (PC only):
+    When the camera zooms out of C-Up mode, each direction of its search for an opening is
+    checked with one ray out to the zoomed out distance, instead of wall, floor and ceiling
+    checks every 20 units along the way. The ray is thin where the old checks reached 50 units
+    to the side and 150 up and down, so the camera can pick an opening that only grazes a wall
+    and zoom out in a different direction than the original game. This is the only caller of
+    raycast. The search only runs when C-Up mode is left, and none of the per-frame probes can
+    use a ray without changing what they find or gain from one: the camera's wall checks push
+    spheres out of walls, and the floor and ceiling checks already only look straight down or
+    up in one cell.
+*/
+// #define C_UP_EXIT_RAYCAST
+
+/*
+    Behavior profiler (PC only):
+    Times every object update and CALL_NATIVE and charges them to the object's behavior and the
+    function called, along with the objects each behavior spawns and the phases of
+    update_objects. The totals are written to behavior_profile.txt at exit and when F9 is
+    pressed, and F11 shows the behaviors that take the most time on screen. Adds a few clock
+    reads to each object update, so leave it off for normal builds.
+*/
+// #define BEHAVIOR_PROFILER
+
+/*
+    Object update LOD (PC only):
+    Objects whose behavior allows it (OBJ_FLAG_ALLOW_UPDATE_LOD) are updated every 2nd frame
+    beyond the first distance from Mario, every 4th frame beyond the second, and not at all
+    beyond the third. Their timers still advance by the frames that were skipped. Objects are
+    always updated every frame within their drawing distance. Behaviors should only allow it if
+    they do nothing that can be seen from further away and draw no random numbers there, as
+    fewer draws would change the numbers every other object gets. tools/count_lod_updates.py
+    counts the updates it skips in a level.
+*/
+// #define OBJECT_UPDATE_LOD
+#define OBJECT_UPDATE_LOD_HALF_RATE_DIST    3000.0f
+#define OBJECT_UPDATE_LOD_QUARTER_RATE_DIST 6000.0f
+#define OBJECT_UPDATE_LOD_SUSPEND_DIST      10000.0f
+
+/*
+    Parallel object updates (PC only, needs GCC or Clang):
+    Objects whose behavior sets OBJ_FLAG_PARALLEL_UPDATE are updated together on the worker
+    threads (worker_threads in the config file) at the start of their list, and put back as
+    they were. Each one takes its result when the list's update gets to it, so the other objects
+    see them change in the original order, and is updated again there if an object before it
+    changed it. Such a behavior may only read the world and write its own object, and must not
+    depend on the objects updated before it in its list. Anything else it does, like spawning an
+    object or pushing Mario, goes through cur_obj_defer, which runs it when the object takes its
+    result. It must not use random numbers, collision queries or sounds. Copying the objects back
+    and forth costs about 0.2 microseconds per object, more than most behaviors take, so only
+    flag behaviors that take well over that in the behavior profiler. No behavior of the original
+    game sets the flag. With PARALLEL_OBJECT_UPDATE_CHECK, each object is also updated at its
+    place in the list as in the original game, and writes to other objects, Mario or the random
+    seed and results that differ from the parallel run are reported on stderr. The check is slow,
+    leave it off for normal builds.
+*/
+// #define PARALLEL_OBJECT_UPDATES
+// #define PARALLEL_OBJECT_UPDATE_CHECK
+
+/*
+    Particle system (PC only):
+    The puffs of cur_obj_spawn_particles, the sparkles of bhvSparkleSpawn and Mario's dust and
+    sparkles are kept in packed arrays outside the object pool instead of being objects. They
+    move and look the same and draw the game's random numbers in the same order as the objects
+    they replace, but are drawn after the objects.
+*/
+// #define PARTICLE_SYSTEM
+
+/*
+    Animation pose cache (PC only):
+    The joints of each animation are decoded once per frame for each frame of it that is drawn,
+    and objects drawn later in the frame with the same animation at the same frame (a group of
+    Goombas walking in step, Mario and his reflection) reuse them instead of decoding their own.
+    The joint matrices are multiplied with SSE2 in the same order as mtxf_mul, so they only
+    differ in the last bit when the compiler fuses mtxf_mul's multiply-adds (e.g. -march=native
+    with FMA). With debug text on, the number of poses decoded and the percentage of animated
+    objects that reused one are shown in the corner.
+*/
+// #define ANIMATION_POSE_CACHE
+
+/*
+    Model graph cache (PC only, needs NO_SEGMENTED_MEMORY):
+    The graph built from a model's geo layout is kept when its level is unloaded, and reused
+    by later levels that load the same model from the same geo layout (Mario, coins, stars and
+    the other common actors) instead of parsing the layout again. Every model of the game ends
+    up built once, the graphs are never freed.
+    LEVEL_LOAD_REPORT prints to stderr how long each level took to load, from ALLOC_LEVEL_POOL
+    to FREE_LEVEL_POOL, and how many geo layouts were parsed and reused, with or without the
+    cache. tools/count_geo_layouts.py counts the graph nodes each level builds either way.
+*/
+// #define MODEL_GRAPH_CACHE
+// #define LEVEL_LOAD_REPORT
+
 #endif // CONFIG_H
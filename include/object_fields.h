@@ -36,6 +36,8 @@
 #define OBJECT_FIELD_VPTR(index)          rawData.asVoidPtr[index]
 #define OBJECT_FIELD_CVPTR(index)         rawData.asConstVoidPtr[index]
 #else
+// New objects only clear the ptrData entries listed in sObjectPointerFields (spawn_object.c),
+// add the index there when giving a field a pointer type.
 #define OBJECT_FIELD_S16P(index)          ptrData.asS16P[index]
 #define OBJECT_FIELD_S32P(index)          ptrData.asS32P[index]
 #define OBJECT_FIELD_ANIMS(index)         ptrData.asAnims[index]
@@ -204,6 +204,15 @@ struct Object
     /*0x218*/ void *collisionData;
     /*0x21C*/ Mat4 transform;
     /*0x25C*/ void *respawnInfo;
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+    // The object update frame the object was last updated on, 0 before its first update.
+    u32 lastUpdateFrame;
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+    // The object's slot in its list's parallel phase plus 1, until the rest of the list's
+    // update gets to it, 0 otherwise.
+    s32 parallelUpdateSlot;
+#endif
 };
 
 struct ObjectHitbox
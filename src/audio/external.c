@@ -392,6 +392,26 @@ u8 sCurrentSound[SOUND_BANK_COUNT][MAX_CHANNELS_PER_SOUND_BANK]; // index into s
  */
 struct SoundCharacteristics sSoundBanks[SOUND_BANK_COUNT][40];
 
+#ifndef TARGET_N64
+#define SOUND_SOURCE_TABLE_BITS 6
+#define SOUND_SOURCE_TABLE_SIZE (1 << SOUND_SOURCE_TABLE_BITS)
+
+/**
+ * For each sound bank, an open-addressed hash table mapping a source position pointer to the
+ * index of the sound from that source in sSoundBanks. A bank never holds two sounds from the
+ * same source, so sound requests and stop_sound can find the existing sound without walking
+ * the used list. Index 0 (the used list header) marks an empty entry.
+ */
+static u8 sSoundSourceTable[SOUND_BANK_COUNT][SOUND_SOURCE_TABLE_SIZE];
+
+// Scratch space for update_sound_distances, one entry per sound slot in every bank
+static struct SoundCharacteristics *sSoundDistanceTargets[SOUND_BANK_COUNT * 40];
+static f32 sSoundSourceX[SOUND_BANK_COUNT * 40];
+static f32 sSoundSourceY[SOUND_BANK_COUNT * 40];
+static f32 sSoundSourceZ[SOUND_BANK_COUNT * 40];
+static f32 sSoundSourceDistance[SOUND_BANK_COUNT * 40];
+#endif
+
 u8 sSoundMovingSpeed[SOUND_BANK_COUNT];
 u8 sBackgroundMusicTargetVolume;
 static u8 sLowerBackgroundMusicVolume;
@@ -836,6 +856,108 @@ void play_sound(s32 soundBits, f32 *pos) {
     sSoundRequestCount++;
 }
 
+#ifndef TARGET_N64
+static u32 sound_source_hash(f32 *pos) {
+    return ((u32)((uintptr_t) pos >> 2) * 0x9E3779B1) >> (32 - SOUND_SOURCE_TABLE_BITS);
+}
+
+/**
+ * Return the index of the sound from the given source in the bank, or 0xff if there is none.
+ */
+static u8 sound_source_find(u8 bank, f32 *pos) {
+    u32 slot = sound_source_hash(pos);
+    u8 soundIndex;
+
+    while ((soundIndex = sSoundSourceTable[bank][slot]) != 0) {
+        if (sSoundBanks[bank][soundIndex].x == pos) {
+            return soundIndex;
+        }
+        slot = (slot + 1) & (SOUND_SOURCE_TABLE_SIZE - 1);
+    }
+    return 0xff;
+}
+
+static void sound_source_insert(u8 bank, u8 soundIndex) {
+    u32 slot = sound_source_hash(sSoundBanks[bank][soundIndex].x);
+
+    while (sSoundSourceTable[bank][slot] != 0) {
+        slot = (slot + 1) & (SOUND_SOURCE_TABLE_SIZE - 1);
+    }
+    sSoundSourceTable[bank][slot] = soundIndex;
+}
+
+/**
+ * Remove a sound from the source table. Later entries in the probe chain are shifted back
+ * into the hole so that lookups never need tombstones.
+ */
+static void sound_source_remove(u8 bank, u8 soundIndex) {
+    u32 hole = sound_source_hash(sSoundBanks[bank][soundIndex].x);
+    u32 slot;
+    u32 home;
+
+    while (sSoundSourceTable[bank][hole] != soundIndex) {
+        if (sSoundSourceTable[bank][hole] == 0) {
+            return;
+        }
+        hole = (hole + 1) & (SOUND_SOURCE_TABLE_SIZE - 1);
+    }
+
+    slot = hole;
+    for (;;) {
+        slot = (slot + 1) & (SOUND_SOURCE_TABLE_SIZE - 1);
+        if (sSoundSourceTable[bank][slot] == 0) {
+            break;
+        }
+
+        // An entry may fill the hole only if its home slot does not lie cyclically
+        // within (hole, slot]
+        home = sound_source_hash(sSoundBanks[bank][sSoundSourceTable[bank][slot]].x);
+        if (((slot - home) & (SOUND_SOURCE_TABLE_SIZE - 1))
+            >= ((slot - hole) & (SOUND_SOURCE_TABLE_SIZE - 1))) {
+            sSoundSourceTable[bank][hole] = sSoundSourceTable[bank][slot];
+            hole = slot;
+        }
+    }
+    sSoundSourceTable[bank][hole] = 0;
+}
+
+/**
+ * Recompute the distance of every live sound in one pass. The source positions are gathered
+ * into flat arrays first so that the distance loop itself is a straight run over contiguous
+ * floats rather than a pointer chase through each bank's used list.
+ */
+static void update_sound_distances(void) {
+    struct SoundCharacteristics *sound;
+    s32 count = 0;
+    s32 i;
+    u8 bank;
+    u8 soundIndex;
+
+    for (bank = 0; bank < SOUND_BANK_COUNT; bank++) {
+        soundIndex = sSoundBanks[bank][0].next;
+        while (soundIndex != 0xff) {
+            sound = &sSoundBanks[bank][soundIndex];
+            sSoundDistanceTargets[count] = sound;
+            sSoundSourceX[count] = *sound->x;
+            sSoundSourceY[count] = *sound->y;
+            sSoundSourceZ[count] = *sound->z;
+            count++;
+            soundIndex = sound->next;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        sSoundSourceDistance[i] = sqrtf(sSoundSourceX[i] * sSoundSourceX[i]
+                                        + sSoundSourceY[i] * sSoundSourceY[i]
+                                        + sSoundSourceZ[i] * sSoundSourceZ[i]);
+    }
+
+    for (i = 0; i < count; i++) {
+        sSoundDistanceTargets[i]->distance = sSoundSourceDistance[i];
+    }
+}
+#endif
+
 /**
  * Called from threads: thread4_sound, thread5_game_loop (EU only)
  */
@@ -854,7 +976,14 @@ static void process_sound_request(u32 bits, f32 *pos) {
         return;
     }
 
+#ifndef TARGET_N64
+    // Go straight to the existing sound from this source, if any, so the loop below runs at
+    // most once. counter still only ends up 0 when the used list is empty.
+    soundIndex = sound_source_find(bank, pos);
+    counter = sSoundBanks[bank][0].next != 0xff ? 1 : 0;
+#else
     soundIndex = sSoundBanks[bank][0].next;
+#endif
     while (soundIndex != 0xff && soundIndex != 0) {
         // If an existing sound from the same source exists in the bank, then we should either
         // interrupt that sound and replace it with the new sound, or we should drop the new sound.
@@ -912,6 +1041,9 @@ static void process_sound_request(u32 bits, f32 *pos) {
         // In practice, the starting status is always WAITING
         sSoundBanks[bank][soundIndex].soundStatus = bits & SOUNDARGS_MASK_STATUS;
         sSoundBanks[bank][soundIndex].freshness = SOUND_MAX_FRESHNESS;
+#ifndef TARGET_N64
+        sound_source_insert(bank, soundIndex);
+#endif
 
         // Append to end of used list and pop from front of free list
         sSoundBanks[bank][soundIndex].prev = sSoundBankUsedListBack[bank];
@@ -942,6 +1074,10 @@ static void process_all_sound_requests(void) {
  * Called from threads: thread4_sound, thread5_game_loop (EU only)
  */
 static void delete_sound_from_bank(u8 bank, u8 soundIndex) {
+#ifndef TARGET_N64
+    sound_source_remove(bank, soundIndex);
+#endif
+
     if (sSoundBankUsedListBack[bank] == soundIndex) {
         // Remove from end of used list
         sSoundBankUsedListBack[bank] = sSoundBanks[bank][soundIndex].prev;
@@ -1029,12 +1165,15 @@ static void select_current_sounds(u8 bank) {
         if (sSoundBanks[bank][soundIndex].soundStatus != SOUND_STATUS_STOPPED
             && soundIndex == latestSoundIndex) {
 
+#ifdef TARGET_N64
             // Recompute distance each frame since the sound's position may have changed
+            // (done for every bank at once by update_sound_distances otherwise)
             sSoundBanks[bank][soundIndex].distance =
                 sqrtf((*sSoundBanks[bank][soundIndex].x * *sSoundBanks[bank][soundIndex].x)
                       + (*sSoundBanks[bank][soundIndex].y * *sSoundBanks[bank][soundIndex].y)
                       + (*sSoundBanks[bank][soundIndex].z * *sSoundBanks[bank][soundIndex].z))
                 * 1;
+#endif
 
             requestedPriority = (sSoundBanks[bank][soundIndex].soundBits & SOUNDARGS_MASK_PRIORITY)
                                 >> SOUNDARGS_SHIFT_PRIORITY;
@@ -1360,6 +1499,10 @@ static void update_game_sound(void) {
         return;
     }
 
+#ifndef TARGET_N64
+    update_sound_distances();
+#endif
+
     for (bank = 0; bank < SOUND_BANK_COUNT; bank++) {
         select_current_sounds(bank);
 
@@ -2128,6 +2271,13 @@ void sound_init(void) {
         sSoundBankUsedListBack[i] = 0;
         sSoundBankFreeListFront[i] = 1;
         sNumSoundsInBank[i] = 0;
+
+#ifndef TARGET_N64
+        // Clear the source table
+        for (j = 0; j < SOUND_SOURCE_TABLE_SIZE; j++) {
+            sSoundSourceTable[i][j] = 0;
+        }
+#endif
     }
 
     for (i = 0; i < SOUND_BANK_COUNT; i++) {
@@ -2197,6 +2347,17 @@ void get_currently_playing_sound(u8 bank, u8 *numPlayingSounds, u8 *numSoundsInB
  */
 void stop_sound(u32 soundBits, f32 *pos) {
     u8 bank = (soundBits & SOUNDARGS_MASK_BANK) >> SOUNDARGS_SHIFT_BANK;
+#ifndef TARGET_N64
+    u8 soundIndex = sound_source_find(bank, pos);
+
+    // There is at most one sound per source in a bank
+    if (soundIndex != 0xff
+        && (u16)(soundBits >> SOUNDARGS_SHIFT_SOUNDID)
+               == (u16)(sSoundBanks[bank][soundIndex].soundBits >> SOUNDARGS_SHIFT_SOUNDID)) {
+        update_background_music_after_sound(bank, soundIndex);
+        sSoundBanks[bank][soundIndex].soundBits = NO_SOUND;
+    }
+#else
     u8 soundIndex = sSoundBanks[bank][0].next;
 
     while (soundIndex != 0xff) {
@@ -2213,6 +2374,7 @@ void stop_sound(u32 soundBits, f32 *pos) {
             soundIndex = sSoundBanks[bank][soundIndex].next;
         }
     }
+#endif
 }
 
 /**
@@ -2223,6 +2385,13 @@ void stop_sounds_from_source(f32 *pos) {
     u8 soundIndex;
 
     for (bank = 0; bank < SOUND_BANK_COUNT; bank++) {
+#ifndef TARGET_N64
+        soundIndex = sound_source_find(bank, pos);
+        if (soundIndex != 0xff) {
+            update_background_music_after_sound(bank, soundIndex);
+            sSoundBanks[bank][soundIndex].soundBits = NO_SOUND;
+        }
+#else
         soundIndex = sSoundBanks[bank][0].next;
         while (soundIndex != 0xff) {
             if (sSoundBanks[bank][soundIndex].x == pos) {
@@ -2231,6 +2400,7 @@ void stop_sounds_from_source(f32 *pos) {
             }
             soundIndex = sSoundBanks[bank][soundIndex].next;
         }
+#endif
     }
 }
 
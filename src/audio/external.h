@@ -24,6 +24,12 @@ extern f32 gGlobalSoundSource[3];
 // defined in data.c, used by the game
 extern u32 gAudioRandom;
 
+#ifndef TARGET_N64
+// Number of voices to allocate at the next session reset, overriding the
+// session preset (0 keeps the preset's count). Clamped to AUDIO_MAX_VOICES.
+extern s32 gAudioVoiceCount;
+#endif
+
 extern u8 gAudioSPTaskYieldBuffer[]; // ucode yield data ptr; only used in JP
 
 struct SPTask *create_next_audio_frame_task(void);
@@ -1,4 +1,7 @@
 #include <ultra64.h>
+#ifndef TARGET_N64
+#include <stdlib.h>
+#endif
 
 #include "heap.h"
 #include "data.h"
@@ -35,6 +38,17 @@ struct SoundAllocPool gSeqAndBankPool;
 struct SoundAllocPool gPersistentCommonPool;
 struct SoundAllocPool gTemporaryCommonPool;
 
+#ifndef TARGET_N64
+// Pool that notes, their synthesis buffers and the audio command lists are
+// allocated from; normally a part of gNotesAndBuffersPool.
+struct SoundAllocPool *gVoiceAllocPool = &gNotesAndBuffersPool;
+
+s32 gAudioVoiceCount = 0;
+static struct SoundAllocPool sHostVoicePool;
+static u8 *sHostVoicePoolMemory;
+static u32 sHostVoicePoolMemorySize;
+#endif
+
 struct SoundMultiPool gSeqLoadedPool;
 struct SoundMultiPool gBankLoadedPool;
 struct SoundMultiPool gUnusedLoadedPool;
@@ -334,6 +348,53 @@ void unused_803160F8(struct SoundAllocPool *pool) {
     pool->cur = pool->start;
 }
 
+#ifndef TARGET_N64
+/**
+ * Returns the voice count to use for a session whose preset asks for
+ * 'presetNotes' notes, honoring gAudioVoiceCount if it has been set.
+ */
+s32 session_voice_count(s32 presetNotes) {
+    if (gAudioVoiceCount <= 0) {
+        return presetNotes;
+    }
+    return gAudioVoiceCount < AUDIO_MAX_VOICES ? gAudioVoiceCount : AUDIO_MAX_VOICES;
+}
+
+/**
+ * Picks the pool voices are allocated from. If a voice count has been
+ * requested, the notes, their synthesis buffers and the command lists (whose
+ * length scales with the voice count) go in a host allocation sized for it,
+ * instead of competing for the notes-and-buffers pool the preset sized for
+ * its own voice count.
+ */
+void voice_pool_init(void) {
+    u32 size;
+
+    if (gAudioVoiceCount <= 0) {
+        gVoiceAllocPool = &gNotesAndBuffersPool;
+        return;
+    }
+
+    size = gMaxSimultaneousNotes * (ALIGN16(sizeof(struct Note)) + ALIGN16(sizeof(struct NoteSynthesisBuffers)));
+#if defined(VERSION_EU) || defined(VERSION_SH)
+    size += ALIGN16(gAudioBufferParameters.updatesPerFrame * gMaxSimultaneousNotes * sizeof(struct NoteSubEu));
+#endif
+    size += 2 * ALIGN16(gMaxAudioCmds * sizeof(u64));
+    size += 0x10; // room for aligning the start
+
+    if (size > sHostVoicePoolMemorySize) {
+        free(sHostVoicePoolMemory);
+        sHostVoicePoolMemory = malloc(size);
+        if (sHostVoicePoolMemory == NULL) {
+            abort();
+        }
+        sHostVoicePoolMemorySize = size;
+    }
+    sound_alloc_pool_init(&sHostVoicePool, sHostVoicePoolMemory, size - 0x10);
+    gVoiceAllocPool = &sHostVoicePool;
+}
+#endif
+
 extern s32 D_SH_80315EE8;
 void sound_init_main_pools(s32 sizeForAudioInitPool) {
     sound_alloc_pool_init(&gAudioInitPool, gAudioHeap, sizeForAudioInitPool);
@@ -1205,6 +1266,9 @@ void audio_reset_session(void) {
     gAudioBufferParameters.updatesPerFrameInv = 1.0f / gAudioBufferParameters.updatesPerFrame;
 
     gMaxSimultaneousNotes = preset->maxSimultaneousNotes;
+#ifndef TARGET_N64
+    gMaxSimultaneousNotes = session_voice_count(gMaxSimultaneousNotes);
+#endif
     gVolume = preset->volume;
     gTempoInternalToExternal = (u32) (gAudioBufferParameters.updatesPerFrame * 2880000.0f / gTatumsPerBeat / D_EU_802298D0);
 
@@ -1226,6 +1290,9 @@ void audio_reset_session(void) {
     reverbWindowSize = preset->reverbWindowSize;
     gAiFrequency = osAiSetFrequency(preset->frequency);
     gMaxSimultaneousNotes = preset->maxSimultaneousNotes;
+#ifndef TARGET_N64
+    gMaxSimultaneousNotes = session_voice_count(gMaxSimultaneousNotes);
+#endif
     gSamplesPerFrameTarget = ALIGN16(gAiFrequency / 60);
     gReverbDownsampleRate = preset->reverbDownsampleRate;
 
@@ -1265,6 +1332,9 @@ void audio_reset_session(void) {
 #endif
     gMaxAudioCmds = gMaxSimultaneousNotes * 20 * updatesPerFrame + 320;
 #endif
+#ifndef TARGET_N64
+    voice_pool_init();
+#endif
 
 #if defined(VERSION_SH)
     persistentMem = DOUBLE_SIZE_ON_64_BIT(preset->persistentSeqMem + preset->persistentBankMem + preset->unk18 + preset->unkMem28 + 0x10);
@@ -1307,19 +1377,19 @@ void audio_reset_session(void) {
 
 #if defined(VERSION_JP) || defined(VERSION_US)
     for (j = 0; j < 2; j++) {
-        gAudioCmdBuffers[j] = soundAlloc(&gNotesAndBuffersPool, gMaxAudioCmds * sizeof(u64));
+        gAudioCmdBuffers[j] = soundAlloc(gVoiceAllocPool, gMaxAudioCmds * sizeof(u64));
     }
 #endif
 
-    gNotes = soundAlloc(&gNotesAndBuffersPool, gMaxSimultaneousNotes * sizeof(struct Note));
+    gNotes = soundAlloc(gVoiceAllocPool, gMaxSimultaneousNotes * sizeof(struct Note));
     note_init_all();
     init_note_free_list();
 
 #if defined(VERSION_EU) || defined(VERSION_SH)
-    gNoteSubsEu = soundAlloc(&gNotesAndBuffersPool, (gAudioBufferParameters.updatesPerFrame * gMaxSimultaneousNotes) * sizeof(struct NoteSubEu));
+    gNoteSubsEu = soundAlloc(gVoiceAllocPool, (gAudioBufferParameters.updatesPerFrame * gMaxSimultaneousNotes) * sizeof(struct NoteSubEu));
 
     for (j = 0; j != 2; j++) {
-        gAudioCmdBuffers[j] = soundAlloc(&gNotesAndBuffersPool, gMaxAudioCmds * sizeof(u64));
+        gAudioCmdBuffers[j] = soundAlloc(gVoiceAllocPool, gMaxAudioCmds * sizeof(u64));
     }
 
     for (j = 0; j < 4; j++) {
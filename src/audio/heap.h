@@ -96,6 +96,12 @@ extern s16 gVolume;
 extern s8 gReverbDownsampleRate;
 extern struct SoundAllocPool gAudioInitPool;
 extern struct SoundAllocPool gNotesAndBuffersPool;
+#ifndef TARGET_N64
+extern struct SoundAllocPool *gVoiceAllocPool;
+#else
+// Voices always come from the notes-and-buffers pool
+#define gVoiceAllocPool (&gNotesAndBuffersPool)
+#endif
 extern struct SoundAllocPool gPersistentCommonPool;
 extern struct SoundAllocPool gTemporaryCommonPool;
 extern struct SoundMultiPool gSeqLoadedPool;
@@ -132,6 +138,10 @@ void audio_reset_session(void);
 void audio_reset_session(struct AudioSessionSettings *preset);
 #endif
 void discard_bank(s32 bankId);
+#ifndef TARGET_N64
+s32 session_voice_count(s32 presetNotes);
+void voice_pool_init(void);
+#endif
 
 #ifdef VERSION_SH
 void fill_filter(s16 filter[8], s32 arg1, s32 arg2);
@@ -22,6 +22,24 @@
 #define LAYERS_MAX       4
 #define CHANNELS_MAX     16
 
+#ifndef TARGET_N64
+// On PC the layer pool is sized so that every channel can hold all of its
+// layers at once; otherwise the layer pool, not the voice count, would cap
+// how many notes can play when a larger voice count is configured.
+#undef SEQUENCE_LAYERS
+#define SEQUENCE_LAYERS (SEQUENCE_CHANNELS * LAYERS_MAX)
+
+// Upper bound for the voice count that may be requested at session init.
+#define AUDIO_MAX_VOICES 256
+
+// Notes in the active and releasing lists of a NotePool are additionally
+// bucketed by priority, so that voice stealing can find the lowest priority
+// note without walking the list. Priorities at or above the last bucket share
+// it (and are searched linearly within it); in practice sequences only use
+// small priorities.
+#define NOTE_PRIORITY_BUCKETS 16
+#endif
+
 #define NO_LAYER ((struct SequenceChannelLayer *)(-1))
 
 #define MUTE_BEHAVIOR_STOP_SCRIPT 0x80 // stop processing sequence/channel scripts
@@ -111,12 +129,28 @@ struct AudioListItem
     struct NotePool *pool;
 }; // size = 0x10
 
+#ifndef TARGET_N64
+struct NotePriorityIndex
+{
+    u16 occupied; // bit n is set while bucket n is non-empty
+    // Next list positions handed out at the front and back of the list
+    u32 frontOrder;
+    u32 backOrder;
+    struct Note *head[NOTE_PRIORITY_BUCKETS];
+    struct Note *tail[NOTE_PRIORITY_BUCKETS];
+};
+#endif
+
 struct NotePool
 {
     struct AudioListItem disabled;
     struct AudioListItem decaying;
     struct AudioListItem releasing;
     struct AudioListItem active;
+#ifndef TARGET_N64
+    struct NotePriorityIndex releasingIndex;
+    struct NotePriorityIndex activeIndex;
+#endif
 };
 
 struct VibratoState {
@@ -662,6 +696,13 @@ struct Note
     /*0x84, 0x8C*/ struct VibratoState vibratoState;
     u8 pad3[8];
     /*    , 0xB0, 0xB4*/ struct NoteSubEu noteSubEu;
+#ifndef TARGET_N64
+    struct NotePriorityIndex *priorityIndex; // index of the list this note is in, or NULL
+    struct Note *priorityPrev;
+    struct Note *priorityNext;
+    u32 priorityOrder; // position in the list, increasing from front to back
+    u8 priorityBucket;
+#endif
 }; // size = 0xC0, known to be 0xC8 on SH
 #else
 // volatile Note, needed in synthesis_process_notes
@@ -719,6 +760,13 @@ struct Note
     /*0xA2*/ s16 unused2; // never read, set to 0
     /*0xA4, 0x00*/ struct AudioListItem listItem;
     /*          */ u8 pad2[0xc];
+#ifndef TARGET_N64
+    struct NotePriorityIndex *priorityIndex; // index of the list this note is in, or NULL
+    struct Note *priorityPrev;
+    struct Note *priorityNext;
+    u32 priorityOrder; // position in the list, increasing from front to back
+    u8 priorityBucket;
+#endif
 }; // size = 0xC0
 #endif
 
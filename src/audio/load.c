@@ -207,6 +207,12 @@ void *dma_sample_data(uintptr_t devAddr, u32 size, s32 arg2, u8 *dmaIndexRef) {
     ssize_t bufferPos;
     UNUSED u32 pad;
 
+#ifndef TARGET_N64
+    // Sample data already lives in host memory, so it can be read in place.
+    // This also means the number of voices isn't bound by sSampleDmas.
+    return (void *) devAddr;
+#endif
+
     if (arg2 != 0 || *dmaIndexRef >= sSampleDmaListSize1) {
         for (i = sSampleDmaListSize1; i < gSampleDmaNumListItems; i++) {
 #if defined(VERSION_EU)
@@ -319,6 +325,13 @@ void init_sample_dma_buffers(UNUSED s32 arg0) {
     s32 j;
 #endif
 
+#ifndef TARGET_N64
+    // dma_sample_data reads samples in place, no DMA buffers are needed.
+    gSampleDmaNumListItems = 0;
+    sSampleDmaListSize1 = 0;
+    return;
+#endif
+
 #if defined(VERSION_EU)
     sDmaBufSize = 0x400;
 #else
@@ -323,6 +323,7 @@ void note_disable(struct Note *note) {
     }
 #endif
     note->priority = NOTE_PRIORITY_DISABLED;
+    note_priority_changed(note);
 #ifdef VERSION_SH
     note->unkSH34 = 0;
 #endif
@@ -381,11 +382,13 @@ void process_notes(void) {
     ((it = (item), it->prev != NULL)                                                                   \
          ? it                                                                                          \
          : (it->prev = (head_arg), it->next = (head_arg)->next, (head_arg)->next->prev = it,           \
-            (head_arg)->next = it, (head_arg)->u.count++, it->pool = (head_arg)->pool, it))
+            (head_arg)->next = it, (head_arg)->u.count++, it->pool = (head_arg)->pool,                 \
+            note_priority_index_insert((head_arg), it, TRUE), it))
 #define POP(item)                                                                                      \
     ((it = (item), it->prev == NULL)                                                                   \
          ? it                                                                                          \
-         : (it->prev->next = it->next, it->next->prev = it->prev, it->prev = NULL, it))
+         : (note_priority_index_remove(it), it->prev->next = it->next, it->next->prev = it->prev,      \
+            it->prev = NULL, it))
 
     for (i = 0; i < gMaxSimultaneousNotes; i++) {
         note = &gNotes[i];
@@ -402,6 +405,7 @@ void process_notes(void) {
                 playbackState->adsr.action |= ADSR_ACTION_RELEASE;
                 playbackState->adsr.fadeOutVel = gAudioBufferParameters.updatesPerFrameInv;
                 playbackState->priority = 1;
+                note_priority_changed(note);
                 playbackState->unkSH34 = 2;
                 goto d;
             } else if (!playbackState->parentLayer->enabled && playbackState->unkSH34 == 0 &&
@@ -410,6 +414,7 @@ void process_notes(void) {
             } else if (playbackState->parentLayer->seqChannel->seqPlayer == NULL) {
                 sequence_channel_disable(playbackState->parentLayer->seqChannel);
                 playbackState->priority = 1;
+                note_priority_changed(note);
                 playbackState->unkSH34 = 1;
                 continue;
             } else if (playbackState->parentLayer->seqChannel->seqPlayer->muted &&
@@ -435,6 +440,7 @@ void process_notes(void) {
                 eu_stubbed_printf_0("CAUTION:SUB IS SEPARATED FROM GROUP");
                 sequence_channel_disable(playbackState->parentLayer->seqChannel);
                 playbackState->priority = NOTE_PRIORITY_STOPPING;
+                note_priority_changed(note);
                 continue;
             } else if (playbackState->parentLayer->seqChannel->seqPlayer->muted) {
                 if ((playbackState->parentLayer->seqChannel->muteBehavior
@@ -449,6 +455,7 @@ void process_notes(void) {
                 audio_list_remove(&note->listItem);
                 audio_list_push_front(&note->listItem.pool->decaying, &note->listItem);
                 playbackState->priority = NOTE_PRIORITY_STOPPING;
+                note_priority_changed(note);
             }
         } else if (playbackState->priority >= NOTE_PRIORITY_MIN) {
             continue;
@@ -755,12 +762,14 @@ void seq_channel_layer_decay_release_internal(struct SequenceChannelLayer *seqLa
                 note->noteSubEu.finished = TRUE;
             }
             note->priority = seqLayer->seqChannel->unkSH06;
+            note_priority_changed(note);
 #endif
         }
 #ifdef VERSION_SH
         else {
 #endif
             note->priority = NOTE_PRIORITY_STOPPING;
+            note_priority_changed(note);
 #ifdef VERSION_SH
         }
 #endif
@@ -941,11 +950,29 @@ void init_note_list(struct AudioListItem *list) {
     list->u.count = 0;
 }
 
+#ifndef TARGET_N64
+static void init_note_priority_index(struct NotePriorityIndex *index) {
+    s32 i;
+
+    index->occupied = 0;
+    index->frontOrder = 0;
+    index->backOrder = 1;
+    for (i = 0; i < NOTE_PRIORITY_BUCKETS; i++) {
+        index->head[i] = NULL;
+        index->tail[i] = NULL;
+    }
+}
+#endif
+
 void init_note_lists(struct NotePool *pool) {
     init_note_list(&pool->disabled);
     init_note_list(&pool->decaying);
     init_note_list(&pool->releasing);
     init_note_list(&pool->active);
+#ifndef TARGET_N64
+    init_note_priority_index(&pool->releasingIndex);
+    init_note_priority_index(&pool->activeIndex);
+#endif
     pool->disabled.pool = pool;
     pool->decaying.pool = pool;
     pool->releasing.pool = pool;
@@ -959,6 +986,9 @@ void init_note_free_list(void) {
     for (i = 0; i < gMaxSimultaneousNotes; i++) {
         gNotes[i].listItem.u.value = &gNotes[i];
         gNotes[i].listItem.prev = NULL;
+#ifndef TARGET_N64
+        gNotes[i].priorityIndex = NULL;
+#endif
         audio_list_push_back(&gNoteFreeLists.disabled, &gNotes[i].listItem);
     }
 }
@@ -1069,6 +1099,152 @@ void note_pool_fill(struct NotePool *pool, s32 count) {
     }
 }
 
+#ifndef TARGET_N64
+/**
+ * Returns the priority index kept for a note list head, or NULL if the list
+ * is not indexed (free lists of layers, and the disabled/decaying note lists).
+ */
+static struct NotePriorityIndex *note_list_priority_index(struct AudioListItem *list) {
+    struct NotePool *pool = list->pool;
+
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (list == &pool->active) {
+        return &pool->activeIndex;
+    }
+    if (list == &pool->releasing) {
+        return &pool->releasingIndex;
+    }
+    return NULL;
+}
+
+/**
+ * Links 'note' into the bucket for its priority, after the last note in the
+ * bucket that comes before it in the list, so that each bucket stays in list
+ * order. No note stays in a list for anywhere near 2^31 insertions, so
+ * comparing list positions through their difference survives wrapping.
+ */
+static void note_priority_index_link(struct NotePriorityIndex *index, struct Note *note) {
+    s32 bucket = note->priority < NOTE_PRIORITY_BUCKETS ? note->priority : NOTE_PRIORITY_BUCKETS - 1;
+    struct Note *prev = index->tail[bucket];
+
+    if (prev != NULL && (s32) (index->head[bucket]->priorityOrder - note->priorityOrder) > 0) {
+        prev = NULL;
+    }
+    while (prev != NULL && (s32) (prev->priorityOrder - note->priorityOrder) > 0) {
+        prev = prev->priorityPrev;
+    }
+
+    note->priorityIndex = index;
+    note->priorityBucket = bucket;
+    note->priorityPrev = prev;
+    if (prev != NULL) {
+        note->priorityNext = prev->priorityNext;
+        prev->priorityNext = note;
+    } else {
+        note->priorityNext = index->head[bucket];
+        index->head[bucket] = note;
+    }
+    if (note->priorityNext != NULL) {
+        note->priorityNext->priorityPrev = note;
+    } else {
+        index->tail[bucket] = note;
+    }
+    index->occupied |= 1 << bucket;
+}
+
+static void note_priority_index_unlink(struct Note *note) {
+    struct NotePriorityIndex *index = note->priorityIndex;
+    s32 bucket = note->priorityBucket;
+
+    if (note->priorityPrev != NULL) {
+        note->priorityPrev->priorityNext = note->priorityNext;
+    } else {
+        index->head[bucket] = note->priorityNext;
+    }
+    if (note->priorityNext != NULL) {
+        note->priorityNext->priorityPrev = note->priorityPrev;
+    } else {
+        index->tail[bucket] = note->priorityPrev;
+    }
+    if (index->head[bucket] == NULL) {
+        index->occupied &= ~(1 << bucket);
+    }
+    note->priorityIndex = NULL;
+}
+
+/**
+ * Called when 'item' has been linked into the front or back of 'list'. Within
+ * a bucket, notes are kept in the same relative order as in the list itself.
+ */
+void note_priority_index_insert(struct AudioListItem *list, struct AudioListItem *item, s32 atFront) {
+    struct NotePriorityIndex *index = note_list_priority_index(list);
+    struct Note *note;
+
+    if (index != NULL) {
+        note = item->u.value;
+        note->priorityOrder = atFront ? index->frontOrder-- : index->backOrder++;
+        note_priority_index_link(index, note);
+    }
+}
+
+/**
+ * Called when 'item' is about to be unlinked from the list it's in.
+ */
+void note_priority_index_remove(struct AudioListItem *item) {
+    struct Note *note;
+
+    if (item->pool == NULL) {
+        return;
+    }
+    note = item->u.value;
+    if (note->priorityIndex != NULL) {
+        note_priority_index_unlink(note);
+    }
+}
+
+/**
+ * Must be called after a note's priority is changed while it may be in an
+ * indexed list. A note that changes buckets keeps its place in the list, so
+ * ties still resolve to the last such note in list order.
+ */
+void note_priority_changed(struct Note *note) {
+    struct NotePriorityIndex *index = note->priorityIndex;
+    s32 bucket = note->priority < NOTE_PRIORITY_BUCKETS ? note->priority : NOTE_PRIORITY_BUCKETS - 1;
+
+    if (index != NULL && bucket != note->priorityBucket) {
+        note_priority_index_unlink(note);
+        note_priority_index_link(index, note);
+    }
+}
+
+/**
+ * Returns the list item of the last note with the lowest priority, using the
+ * priority index instead of walking the whole list.
+ */
+static struct AudioListItem *note_priority_index_lowest(struct NotePriorityIndex *index) {
+    struct Note *best;
+    struct Note *cur;
+    s32 bucket;
+
+    for (bucket = 0; bucket < NOTE_PRIORITY_BUCKETS - 1; bucket++) {
+        if (index->occupied & (1 << bucket)) {
+            return &index->tail[bucket]->listItem;
+        }
+    }
+
+    // The last bucket holds all remaining priorities, so it needs a scan.
+    best = index->head[NOTE_PRIORITY_BUCKETS - 1];
+    for (cur = best; cur != NULL; cur = cur->priorityNext) {
+        if (best->priority >= cur->priority) {
+            best = cur;
+        }
+    }
+    return best != NULL ? &best->listItem : NULL;
+}
+#endif
+
 void audio_list_push_front(struct AudioListItem *list, struct AudioListItem *item) {
     // add 'item' to the front of the list given by 'list', if it's not in any list
     if (item->prev != NULL) {
@@ -1080,6 +1256,7 @@ void audio_list_push_front(struct AudioListItem *list, struct AudioListItem *ite
         list->next = item;
         list->u.count++;
         item->pool = list->pool;
+        note_priority_index_insert(list, item, TRUE);
     }
 }
 
@@ -1088,6 +1265,7 @@ void audio_list_remove(struct AudioListItem *item) {
     if (item->prev == NULL) {
         eu_stubbed_printf_0("Already Cut\n");
     } else {
+        note_priority_index_remove(item);
         item->prev->next = item->next;
         item->next->prev = item->prev;
         item->prev = NULL;
@@ -1097,16 +1275,32 @@ void audio_list_remove(struct AudioListItem *item) {
 struct Note *pop_node_with_lower_prio(struct AudioListItem *list, s32 limit) {
     struct AudioListItem *cur = list->next;
     struct AudioListItem *best;
+#ifndef TARGET_N64
+    struct NotePriorityIndex *index;
+#endif
 
     if (cur == list) {
         return NULL;
     }
 
+#ifndef TARGET_N64
+    index = note_list_priority_index(list);
+    if (index != NULL) {
+        best = note_priority_index_lowest(index);
+    } else {
+        for (best = cur; cur != list; cur = cur->next) {
+            if (((struct Note *) best->u.value)->priority >= ((struct Note *) cur->u.value)->priority) {
+                best = cur;
+            }
+        }
+    }
+#else
     for (best = cur; cur != list; cur = cur->next) {
         if (((struct Note *) best->u.value)->priority >= ((struct Note *) cur->u.value)->priority) {
             best = cur;
         }
     }
+#endif
 
 #if defined(VERSION_EU) || defined(VERSION_SH)
     if (best == NULL) {
@@ -1137,6 +1331,7 @@ void note_init_for_layer(struct Note *note, struct SequenceChannelLayer *seqLaye
     note->prevParentLayer = NO_LAYER;
     note->parentLayer = seqLayer;
     note->priority = seqLayer->seqChannel->notePriority;
+    note_priority_changed(note);
     seqLayer->notePropertiesNeedInit = TRUE;
     seqLayer->status = SOUND_LOAD_STATUS_DISCARDABLE; // "loaded"
     seqLayer->note = note;
@@ -1172,6 +1367,7 @@ s32 note_init_for_layer(struct Note *note, struct SequenceChannelLayer *seqLayer
     note->prevParentLayer = NO_LAYER;
     note->parentLayer = seqLayer;
     note->priority = seqLayer->seqChannel->notePriority;
+    note_priority_changed(note);
     if (IS_BANK_LOAD_COMPLETE(seqLayer->seqChannel->bankId) == FALSE) {
         return TRUE;
     }
@@ -1200,8 +1396,10 @@ void note_release_and_take_ownership(struct Note *note, struct SequenceChannelLa
     note->wantedParentLayer = seqLayer;
 #ifdef VERSION_SH
     note->priority = seqLayer->seqChannel->notePriority;
+    note_priority_changed(note);
 #else
     note->priority = NOTE_PRIORITY_STOPPING;
+    note_priority_changed(note);
 #endif
 
 #if defined(VERSION_EU) || defined(VERSION_SH)
@@ -1276,10 +1474,12 @@ struct Note *alloc_note_from_active(struct NotePool *pool, struct SequenceChanne
         func_80319728(aNote, seqLayer);
         audio_list_push_back(&pool->releasing, &aNote->listItem);
         aNote->priority = seqLayer->seqChannel->notePriority;
+        note_priority_changed(aNote);
         return aNote;
     }
     rNote->wantedParentLayer = seqLayer;
     rNote->priority = seqLayer->seqChannel->notePriority;
+    note_priority_changed(rNote);
     return rNote;
 #else
     return aNote;
@@ -1398,9 +1598,11 @@ void reclaim_notes(void) {
                 audio_list_push_back(&gLayerFreeList, &note->parentLayer->listItem);
                 seq_channel_layer_disable(note->parentLayer);
                 note->priority = NOTE_PRIORITY_STOPPING;
+                note_priority_changed(note);
             } else if (note->parentLayer->seqChannel->seqPlayer == NULL) {
                 sequence_channel_disable(note->parentLayer->seqChannel);
                 note->priority = NOTE_PRIORITY_STOPPING;
+                note_priority_changed(note);
             } else if (note->parentLayer->seqChannel->seqPlayer->muted) {
                 if (note->parentLayer->seqChannel->muteBehavior
                     & (MUTE_BEHAVIOR_STOP_SCRIPT | MUTE_BEHAVIOR_STOP_NOTES)) {
@@ -1462,11 +1664,11 @@ void note_init_all(void) {
         note->portamento.cur = 0.0f;
         note->portamento.speed = 0.0f;
 #if defined(VERSION_SH)
-        note->synthesisState.synthesisBuffers = sound_alloc_uninitialized(&gNotesAndBuffersPool, sizeof(struct NoteSynthesisBuffers));
+        note->synthesisState.synthesisBuffers = sound_alloc_uninitialized(gVoiceAllocPool, sizeof(struct NoteSynthesisBuffers));
 #elif defined(VERSION_EU)
-        note->synthesisState.synthesisBuffers = soundAlloc(&gNotesAndBuffersPool, sizeof(struct NoteSynthesisBuffers));
+        note->synthesisState.synthesisBuffers = soundAlloc(gVoiceAllocPool, sizeof(struct NoteSynthesisBuffers));
 #else
-        note->synthesisBuffers = soundAlloc(&gNotesAndBuffersPool, sizeof(struct NoteSynthesisBuffers));
+        note->synthesisBuffers = soundAlloc(gVoiceAllocPool, sizeof(struct NoteSynthesisBuffers));
 #endif
     }
 }
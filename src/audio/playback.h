@@ -26,6 +26,16 @@ void note_pool_clear(struct NotePool *pool);
 void note_pool_fill(struct NotePool *pool, s32 count);
 void audio_list_push_front(struct AudioListItem *list, struct AudioListItem *item);
 void audio_list_remove(struct AudioListItem *item);
+#ifndef TARGET_N64
+void note_priority_index_insert(struct AudioListItem *list, struct AudioListItem *item, s32 atFront);
+void note_priority_index_remove(struct AudioListItem *item);
+void note_priority_changed(struct Note *note);
+#else
+// The note lists are only indexed by priority on PC
+#define note_priority_index_insert(list, item, atFront) ((void) 0)
+#define note_priority_index_remove(item) ((void) 0)
+#define note_priority_changed(note) ((void) 0)
+#endif
 struct Note *alloc_note(struct SequenceChannelLayer *seqLayer);
 void reclaim_notes(void);
 void note_init_all(void);
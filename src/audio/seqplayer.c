@@ -360,6 +360,7 @@ void audio_list_push_back(struct AudioListItem *list, struct AudioListItem *item
         list->prev = item;
         list->u.count++;
         item->pool = list->pool;
+        note_priority_index_insert(list, item, FALSE);
     }
 }
 
@@ -371,6 +372,7 @@ void *audio_list_pop_back(struct AudioListItem *list) {
     if (item == list) {
         return NULL;
     }
+    note_priority_index_remove(item);
     item->prev->next = list;
     list->prev = item->prev;
     item->prev = NULL;
@@ -378,8 +378,13 @@ u64 *synthesis_resample_and_mix_reverb(u64 *cmd, s32 bufLen, s16 reverbIndex, s1
             cmd = synthesis_load_reverb_ring_buffer(cmd, DMEM_ADDR_WET_LEFT_CH + item->lengthA, 0, item->lengthB, reverbIndex);
         }
         aSetBuffer(cmd++, 0, 0, 0, DEFAULT_LEN_2CH);
+#ifndef TARGET_N64
+        aReverbMix(cmd++, 0x8000 + gSynthesisReverbs[reverbIndex].reverbGain, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH,
+                   REVERB_MIX_ADD_TO_DRY, DEFAULT_LEN_2CH);
+#else
         aMix(cmd++, 0, 0x7fff, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH);
         aMix(cmd++, 0, 0x8000 + gSynthesisReverbs[reverbIndex].reverbGain, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_WET_LEFT_CH);
+#endif
     } else {
         startPad = (item->startPos % 8u) * 2;
         paddedLengthA = ALIGN(startPad + item->lengthA, 4);
@@ -396,8 +401,13 @@ u64 *synthesis_resample_and_mix_reverb(u64 *cmd, s32 bufLen, s16 reverbIndex, s1
         aResample(cmd++, gSynthesisReverbs[reverbIndex].resampleFlags, gSynthesisReverbs[reverbIndex].resampleRate, VIRTUAL_TO_PHYSICAL2(gSynthesisReverbs[reverbIndex].resampleStateRight));
 
         aSetBuffer(cmd++, 0, 0, 0, DEFAULT_LEN_2CH);
+#ifndef TARGET_N64
+        aReverbMix(cmd++, 0x8000 + gSynthesisReverbs[reverbIndex].reverbGain, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH,
+                   REVERB_MIX_ADD_TO_DRY, DEFAULT_LEN_2CH);
+#else
         aMix(cmd++, 0, 0x7fff, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH);
         aMix(cmd++, 0, 0x8000 + gSynthesisReverbs[reverbIndex].reverbGain, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_WET_LEFT_CH);
+#endif
     }
     return cmd;
 }
@@ -529,6 +539,12 @@ u64 *synthesis_do_one_audio_update(s16 *aiBuf, s32 bufLen, u64 *cmd, s32 updateI
                 temp = 0;
             }
 
+#ifndef TARGET_N64
+            // Both steps below in one pass
+            aSetBuffer(cmd++, 0, 0, 0, DEFAULT_LEN_2CH);
+            aReverbMix(cmd++, 0x8000 + gSynthesisReverb.reverbGain, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH,
+                       REVERB_MIX_COPY_TO_DRY, DEFAULT_LEN_2CH);
+#else
             // Use the reverb sound as initial sound for this audio update
             aDMEMMove(cmd++, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH, DEFAULT_LEN_2CH);
 
@@ -538,6 +554,7 @@ u64 *synthesis_do_one_audio_update(s16 *aiBuf, s32 bufLen, u64 *cmd, s32 updateI
             // 0x8000 here is -100%
             aMix(cmd++, 0, /*gain*/ 0x8000 + gSynthesisReverb.reverbGain, /*in*/ DMEM_ADDR_WET_LEFT_CH,
                  /*out*/ DMEM_ADDR_WET_LEFT_CH);
+#endif
         } else {
             // Same as above but upsample the previously downsampled samples used for reverb first
             temp = 0; //! jesus christ
@@ -558,8 +575,13 @@ u64 *synthesis_do_one_audio_update(s16 *aiBuf, s32 bufLen, u64 *cmd, s32 updateI
             aSetBuffer(cmd++, 0, t4 + DMEM_ADDR_WET_RIGHT_CH, DMEM_ADDR_RIGHT_CH, bufLen << 1);
             aResample(cmd++, gSynthesisReverb.resampleFlags, (u16) gSynthesisReverb.resampleRate, VIRTUAL_TO_PHYSICAL2(gSynthesisReverb.resampleStateRight));
             aSetBuffer(cmd++, 0, 0, 0, DEFAULT_LEN_2CH);
+#ifndef TARGET_N64
+            aReverbMix(cmd++, 0x8000 + gSynthesisReverb.reverbGain, DMEM_ADDR_WET_LEFT_CH, DMEM_ADDR_LEFT_CH,
+                       REVERB_MIX_COPY_FROM_DRY, DEFAULT_LEN_2CH);
+#else
             aMix(cmd++, 0, /*gain*/ 0x8000 + gSynthesisReverb.reverbGain, /*in*/ DMEM_ADDR_LEFT_CH, /*out*/ DMEM_ADDR_LEFT_CH);
             aDMEMMove(cmd++, DMEM_ADDR_LEFT_CH, DMEM_ADDR_WET_LEFT_CH, DEFAULT_LEN_2CH);
+#endif
         }
         cmd = synthesis_process_notes(aiBuf, bufLen, cmd);
         if (gReverbDownsampleRate == 1) {
@@ -1531,6 +1553,7 @@ void note_disable(struct Note *note) {
         note_set_vel_pan_reverb(note, 0, .5, 0);
     }
     note->priority = NOTE_PRIORITY_DISABLED;
+    note_priority_changed(note);
     note->enabled = FALSE;
     note->finished = FALSE;
     note->parentLayer = NO_LAYER;
@@ -13,6 +13,9 @@
 #include "game/object_list_processor.h"
 #include "graph_node.h"
 #include "surface_collision.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+#include "../pc/behavior_profiler.h"
+#endif
 
 // Macros for retrieving arguments from behavior scripts.
 #define BHV_CMD_GET_1ST_U8(index)  (u8)((gCurBhvCommand[index] >> 24) & 0xFF) // unused
@@ -65,6 +68,13 @@ u16 random_u16(void) {
     return gRandomSeed16;
 }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATE_CHECK)
+// For checking that objects updated in parallel leave the seed alone.
+u16 get_random_seed(void) {
+    return gRandomSeed16;
+}
+#endif
+
 // Generate a pseudorandom float in the range [0, 1).
 f32 random_float(void) {
     f32 rnd = random_u16();
@@ -358,10 +368,17 @@ static s32 bhv_cmd_end_loop(void) {
 // Command 0x0C: Executes a native game function. Function must not take or return any values.
 // Usage: CALL_NATIVE(func)
 typedef void (*NativeBhvFunc)(void);
+
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+#define CALL_NATIVE_BHV_FUNC(func) behavior_profiler_call_native(func)
+#else
+#define CALL_NATIVE_BHV_FUNC(func) (func)()
+#endif
+
 static s32 bhv_cmd_call_native(void) {
     NativeBhvFunc behaviorFunc = BHV_CMD_GET_VPTR(1);
 
-    behaviorFunc();
+    CALL_NATIVE_BHV_FUNC(behaviorFunc);
 
     gCurBhvCommand += 2;
     return BHV_PROC_CONTINUE;
@@ -910,6 +927,13 @@ void cur_obj_update(void) {
     f32 distanceFromMario;
     BhvCommandProc bhvCmdProc;
     s32 bhvProcResult;
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+    s32 i;
+#endif
+
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+    behavior_profiler_begin_update(gCurrentObject->behavior);
+#endif
 
     // Calculate the distance from the object to Mario.
     if (objFlags & OBJ_FLAG_COMPUTE_DIST_TO_MARIO) {
@@ -941,9 +965,19 @@ void cur_obj_update(void) {
     gCurrentObject->curBhvCommand = gCurBhvCommand;
 
     // Increment the object's timer.
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+    // An object updated less often advances its timer by all the frames since its last update.
+    if (gCurrentObject->oTimer < 0x3FFFFFFF) {
+        gCurrentObject->oTimer += gCurrentObjectUpdateFrames;
+        if (gCurrentObject->oTimer > 0x3FFFFFFF) {
+            gCurrentObject->oTimer = 0x3FFFFFFF;
+        }
+    }
+#else
     if (gCurrentObject->oTimer < 0x3FFFFFFF) {
         gCurrentObject->oTimer++;
     }
+#endif
 
     // If the object's action has changed, reset the action timer.
     if (gCurrentObject->oAction != gCurrentObject->oPrevAction) {
@@ -962,6 +996,18 @@ void cur_obj_update(void) {
         gCurrentObject->oFaceAngleYaw = gCurrentObject->oMoveAngleYaw;
     }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+    // Likewise, it moves as far as it would have in those frames.
+    for (i = 0; i < gCurrentObjectUpdateFrames; i++) {
+        if (objFlags & OBJ_FLAG_MOVE_XZ_USING_FVEL) {
+            cur_obj_move_xz_using_fvel_and_yaw();
+        }
+
+        if (objFlags & OBJ_FLAG_MOVE_Y_WITH_TERMINAL_VEL) {
+            cur_obj_move_y_with_terminal_vel();
+        }
+    }
+#else
     if (objFlags & OBJ_FLAG_MOVE_XZ_USING_FVEL) {
         cur_obj_move_xz_using_fvel_and_yaw();
     }
@@ -969,6 +1015,7 @@ void cur_obj_update(void) {
     if (objFlags & OBJ_FLAG_MOVE_Y_WITH_TERMINAL_VEL) {
         cur_obj_move_y_with_terminal_vel();
     }
+#endif
 
     if (objFlags & OBJ_FLAG_TRANSFORM_RELATIVE_TO_PARENT) {
         obj_build_transform_relative_to_parent(gCurrentObject);
@@ -1000,4 +1047,8 @@ void cur_obj_update(void) {
             }
         }
     }
+
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+    behavior_profiler_end_update();
+#endif
 }
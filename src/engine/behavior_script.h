@@ -20,6 +20,9 @@
 #define obj_and_int(object, offset, value) object->OBJECT_FIELD_S32(offset) &= (s32)(value)
 
 u16 random_u16(void);
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATE_CHECK)
+u16 get_random_seed(void);
+#endif
 float random_float(void);
 s32 random_sign(void);
 
@@ -23,6 +23,10 @@
 #include "math_util.h"
 #include "surface_collision.h"
 #include "surface_load.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(LEVEL_LOAD_REPORT)
+#include <stdio.h>
+#include <time.h>
+#endif
 
 #define CMD_GET(type, offset) (*(type *) (CMD_PROCESS_OFFSET(offset) + (u8 *) sCurrentCmd))
 
@@ -58,6 +62,44 @@ static struct LevelCommand *sCurrentCmd;
 static struct MemoryPool *sMemPoolForGoddard;
 #endif
 
+#if defined(USE_SYSTEM_MALLOC) && defined(MODEL_GRAPH_CACHE)
+#ifndef NO_SEGMENTED_MEMORY
+// With segments, the same address holds another level's geo layouts after a level change
+#error MODEL_GRAPH_CACHE needs NO_SEGMENTED_MEMORY
+#endif
+#define MODEL_GRAPH_CACHE_SIZE 1024
+
+/**
+ * A model graph built from a geo layout by an earlier level. Model graphs are only read while
+ * drawing, apart from state their functions set before it's used, so every object with the
+ * model already shares one; the cache shares them between levels too. The model ID is part of
+ * the key so that two models loaded from the same geo layout still have different graphs, as
+ * objects tell their models apart by graph.
+ */
+struct CachedModelGraph {
+    void *geoLayout;
+    s16 model;
+    struct GraphNode *graph;
+};
+
+static struct CachedModelGraph sModelGraphCache[MODEL_GRAPH_CACHE_SIZE];
+static struct AllocOnlyPool *sModelGraphPool = NULL;
+#endif
+
+#if defined(USE_SYSTEM_MALLOC) && defined(LEVEL_LOAD_REPORT)
+static f64 sLevelLoadStart;
+static s32 sGeoLayoutsParsed;
+static s32 sGeoLayoutsReused;
+
+// Wall clock time in milliseconds. clock() would only count the CPU time of this process.
+static f64 get_time_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+#endif
+
 static s32 eval_script_op(s8 op, s32 arg) {
     s32 result = 0;
 
@@ -321,6 +363,11 @@ static void level_cmd_clear_level(void) {
 }
 
 static void level_cmd_alloc_level_pool(void) {
+#if defined(USE_SYSTEM_MALLOC) && defined(LEVEL_LOAD_REPORT)
+    sLevelLoadStart = get_time_ms();
+    sGeoLayoutsParsed = 0;
+    sGeoLayoutsReused = 0;
+#endif
     if (sLevelPool == NULL) {
 #ifdef USE_SYSTEM_MALLOC
         sLevelPool = alloc_only_pool_init();
@@ -348,6 +395,12 @@ static void level_cmd_free_level_pool(void) {
         }
     }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(LEVEL_LOAD_REPORT)
+    fprintf(stderr, "level %d loaded in %.2f ms, %d geo layouts parsed, %d reused\n", gCurrLevelNum,
+            get_time_ms() - sLevelLoadStart, sGeoLayoutsParsed,
+            sGeoLayoutsReused);
+#endif
+
     sCurrentCmd = CMD_NEXT;
 }
 
@@ -392,12 +445,60 @@ static void level_cmd_load_model_from_dl(void) {
     sCurrentCmd = CMD_NEXT;
 }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(MODEL_GRAPH_CACHE)
+/**
+ * Return the graph of the model built from the geo layout, building it in the persistent pool
+ * the first time the model is loaded from it.
+ */
+static struct GraphNode *get_cached_model_graph(s16 model, void *geoLayout) {
+    u32 hash = (u32) (((uintptr_t) geoLayout >> 3) * 31 + model);
+    struct CachedModelGraph *entry;
+    s32 i;
+
+    for (i = 0; i < MODEL_GRAPH_CACHE_SIZE; i++) {
+        entry = &sModelGraphCache[(hash + i) & (MODEL_GRAPH_CACHE_SIZE - 1)];
+        if (entry->graph == NULL) {
+            break;
+        }
+        if (entry->geoLayout == geoLayout && entry->model == model) {
+#ifdef LEVEL_LOAD_REPORT
+            sGeoLayoutsReused++;
+#endif
+            return entry->graph;
+        }
+    }
+
+#ifdef LEVEL_LOAD_REPORT
+    sGeoLayoutsParsed++;
+#endif
+    // The cache is full, build it for this level only
+    if (i == MODEL_GRAPH_CACHE_SIZE) {
+        return process_geo_layout(sLevelPool, geoLayout);
+    }
+
+    if (sModelGraphPool == NULL) {
+        sModelGraphPool = alloc_only_pool_init_persistent();
+    }
+    entry->geoLayout = geoLayout;
+    entry->model = model;
+    entry->graph = process_geo_layout(sModelGraphPool, geoLayout);
+    return entry->graph;
+}
+#endif
+
 static void level_cmd_load_model_from_geo(void) {
     s16 arg0 = CMD_GET(s16, 2);
     void *arg1 = CMD_GET(void *, 4);
 
     if (arg0 < 256) {
+#if defined(USE_SYSTEM_MALLOC) && defined(MODEL_GRAPH_CACHE)
+        gLoadedGraphNodes[arg0] = get_cached_model_graph(arg0, arg1);
+#else
         gLoadedGraphNodes[arg0] = process_geo_layout(sLevelPool, arg1);
+#if defined(USE_SYSTEM_MALLOC) && defined(LEVEL_LOAD_REPORT)
+        sGeoLayoutsParsed++;
+#endif
+#endif
     }
 
     sCurrentCmd = CMD_NEXT;
@@ -1,4 +1,7 @@
 #include <PR/ultratypes.h>
+#ifndef TARGET_N64
+#include <math.h>
+#endif
 
 #include "sm64.h"
 #include "game/debug.h"
@@ -8,10 +11,312 @@
 #include "surface_collision.h"
 #include "surface_load.h"
 
+#if defined(USE_SYSTEM_MALLOC) && defined(COLLISION_PROFILER)
+#include "../pc/collision_profiler.h"
+
+// The public queries are timed and charged to their caller, and the list searches count the
+// surfaces they look at.
+#define PROFILE_BEGIN(type) collision_profiler_begin(type, __builtin_return_address(0))
+#define PROFILE_CELL(cellX, cellZ) collision_profiler_cell(cellX, cellZ)
+#define PROFILE_SCANNED(count) (gCollisionProfilerScanned += (count))
+#define PROFILE_END() collision_profiler_end()
+#else
+#define PROFILE_BEGIN(type)
+#define PROFILE_CELL(cellX, cellZ)
+#define PROFILE_SCANNED(count)
+#define PROFILE_END()
+#endif
+
+#ifdef USE_SYSTEM_MALLOC
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PACKED_LANES 8
+#elif defined(__SSE4_1__)
+#include <immintrin.h>
+#define PACKED_LANES 4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PACKED_LANES 4
+#else
+#define PACKED_LANES 1
+#endif
+
+/**
+ * Lane mask for the packed surfaces [i, i + PACKED_LANES) that actually exist.
+ */
+static u32 packed_count_mask(struct PackedSurfaceList *list, s32 i) {
+    s32 left = list->count - i;
+
+    return left >= PACKED_LANES ? (1U << PACKED_LANES) - 1 : (1U << left) - 1;
+}
+
+/**
+ * Return a lane mask of the packed surfaces starting at index i that contain (x, z) laterally.
+ * These are the same s32 edge functions the list searches use, so a lane is set exactly when
+ * the scalar code would not have skipped the surface. Floors need every edge to be >= 0 and
+ * ceilings every edge to be <= 0.
+ */
+static u32 packed_edge_mask(struct PackedSurfaceList *list, s32 i, s32 x, s32 z, s32 isCeil) {
+#if defined(__AVX2__)
+    __m256i xv = _mm256_set1_epi32(x);
+    __m256i zv = _mm256_set1_epi32(z);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i x1 = _mm256_loadu_si256((const __m256i *) &list->x1[i]);
+    __m256i z1 = _mm256_loadu_si256((const __m256i *) &list->z1[i]);
+    __m256i x2 = _mm256_loadu_si256((const __m256i *) &list->x2[i]);
+    __m256i z2 = _mm256_loadu_si256((const __m256i *) &list->z2[i]);
+    __m256i x3 = _mm256_loadu_si256((const __m256i *) &list->x3[i]);
+    __m256i z3 = _mm256_loadu_si256((const __m256i *) &list->z3[i]);
+    __m256i e1, e2, e3, fail;
+
+#define EDGE(xa, za, xb, zb)                                                                   \
+    _mm256_sub_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(za, zv), _mm256_sub_epi32(xb, xa)),   \
+                     _mm256_mullo_epi32(_mm256_sub_epi32(xa, xv), _mm256_sub_epi32(zb, za)))
+    e1 = EDGE(x1, z1, x2, z2);
+    e2 = EDGE(x2, z2, x3, z3);
+    e3 = EDGE(x3, z3, x1, z1);
+#undef EDGE
+
+    if (isCeil) {
+        fail = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(e1, zero), _mm256_cmpgt_epi32(e2, zero)),
+                               _mm256_cmpgt_epi32(e3, zero));
+    } else {
+        fail = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(zero, e1), _mm256_cmpgt_epi32(zero, e2)),
+                               _mm256_cmpgt_epi32(zero, e3));
+    }
+    return ~_mm256_movemask_ps(_mm256_castsi256_ps(fail)) & packed_count_mask(list, i);
+#elif defined(__SSE4_1__)
+    __m128i xv = _mm_set1_epi32(x);
+    __m128i zv = _mm_set1_epi32(z);
+    __m128i zero = _mm_setzero_si128();
+    __m128i x1 = _mm_loadu_si128((const __m128i *) &list->x1[i]);
+    __m128i z1 = _mm_loadu_si128((const __m128i *) &list->z1[i]);
+    __m128i x2 = _mm_loadu_si128((const __m128i *) &list->x2[i]);
+    __m128i z2 = _mm_loadu_si128((const __m128i *) &list->z2[i]);
+    __m128i x3 = _mm_loadu_si128((const __m128i *) &list->x3[i]);
+    __m128i z3 = _mm_loadu_si128((const __m128i *) &list->z3[i]);
+    __m128i e1, e2, e3, fail;
+
+#define EDGE(xa, za, xb, zb)                                                          \
+    _mm_sub_epi32(_mm_mullo_epi32(_mm_sub_epi32(za, zv), _mm_sub_epi32(xb, xa)),      \
+                  _mm_mullo_epi32(_mm_sub_epi32(xa, xv), _mm_sub_epi32(zb, za)))
+    e1 = EDGE(x1, z1, x2, z2);
+    e2 = EDGE(x2, z2, x3, z3);
+    e3 = EDGE(x3, z3, x1, z1);
+#undef EDGE
+
+    if (isCeil) {
+        fail = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(e1, zero), _mm_cmpgt_epi32(e2, zero)),
+                            _mm_cmpgt_epi32(e3, zero));
+    } else {
+        fail = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(e1, zero), _mm_cmplt_epi32(e2, zero)),
+                            _mm_cmplt_epi32(e3, zero));
+    }
+    return ~_mm_movemask_ps(_mm_castsi128_ps(fail)) & packed_count_mask(list, i);
+#elif PACKED_LANES == 4
+    static const u32 laneBits[4] = { 1, 2, 4, 8 };
+    int32x4_t xv = vdupq_n_s32(x);
+    int32x4_t zv = vdupq_n_s32(z);
+    int32x4_t zero = vdupq_n_s32(0);
+    int32x4_t x1 = vld1q_s32(&list->x1[i]);
+    int32x4_t z1 = vld1q_s32(&list->z1[i]);
+    int32x4_t x2 = vld1q_s32(&list->x2[i]);
+    int32x4_t z2 = vld1q_s32(&list->z2[i]);
+    int32x4_t x3 = vld1q_s32(&list->x3[i]);
+    int32x4_t z3 = vld1q_s32(&list->z3[i]);
+    int32x4_t e1, e2, e3;
+    uint32x4_t fail;
+
+#define EDGE(xa, za, xb, zb) \
+    vsubq_s32(vmulq_s32(vsubq_s32(za, zv), vsubq_s32(xb, xa)), vmulq_s32(vsubq_s32(xa, xv), vsubq_s32(zb, za)))
+    e1 = EDGE(x1, z1, x2, z2);
+    e2 = EDGE(x2, z2, x3, z3);
+    e3 = EDGE(x3, z3, x1, z1);
+#undef EDGE
+
+    if (isCeil) {
+        fail = vorrq_u32(vorrq_u32(vcgtq_s32(e1, zero), vcgtq_s32(e2, zero)), vcgtq_s32(e3, zero));
+    } else {
+        fail = vorrq_u32(vorrq_u32(vcltq_s32(e1, zero), vcltq_s32(e2, zero)), vcltq_s32(e3, zero));
+    }
+    return ~vaddvq_u32(vandq_u32(fail, vld1q_u32(laneBits))) & packed_count_mask(list, i);
+#else
+    s32 e1 = (list->z1[i] - z) * (list->x2[i] - list->x1[i]) - (list->x1[i] - x) * (list->z2[i] - list->z1[i]);
+    s32 e2 = (list->z2[i] - z) * (list->x3[i] - list->x2[i]) - (list->x2[i] - x) * (list->z3[i] - list->z2[i]);
+    s32 e3 = (list->z3[i] - z) * (list->x1[i] - list->x3[i]) - (list->x3[i] - x) * (list->z1[i] - list->z3[i]);
+
+    if (isCeil) {
+        return e1 <= 0 && e2 <= 0 && e3 <= 0;
+    }
+    return e1 >= 0 && e2 >= 0 && e3 >= 0;
+#endif
+}
+
+/**
+ * Return a lane mask of the packed walls starting at index i whose y range contains y and whose
+ * xz bounds are within pad of (x, z).
+ */
+static u32 packed_wall_mask(struct PackedSurfaceList *list, s32 i, f32 x, f32 y, f32 z, f32 pad) {
+#if defined(__AVX2__)
+    __m256 yv = _mm256_set1_ps(y);
+    __m256 xLo = _mm256_set1_ps(x - pad);
+    __m256 xHi = _mm256_set1_ps(x + pad);
+    __m256 zLo = _mm256_set1_ps(z - pad);
+    __m256 zHi = _mm256_set1_ps(z + pad);
+    __m256 fail = _mm256_or_ps(_mm256_cmp_ps(yv, _mm256_loadu_ps(&list->lowerY[i]), _CMP_LT_OQ),
+                               _mm256_cmp_ps(yv, _mm256_loadu_ps(&list->upperY[i]), _CMP_GT_OQ));
+    fail = _mm256_or_ps(fail, _mm256_cmp_ps(xHi, _mm256_loadu_ps(&list->minX[i]), _CMP_LT_OQ));
+    fail = _mm256_or_ps(fail, _mm256_cmp_ps(xLo, _mm256_loadu_ps(&list->maxX[i]), _CMP_GT_OQ));
+    fail = _mm256_or_ps(fail, _mm256_cmp_ps(zHi, _mm256_loadu_ps(&list->minZ[i]), _CMP_LT_OQ));
+    fail = _mm256_or_ps(fail, _mm256_cmp_ps(zLo, _mm256_loadu_ps(&list->maxZ[i]), _CMP_GT_OQ));
+    return ~_mm256_movemask_ps(fail) & packed_count_mask(list, i);
+#elif defined(__SSE4_1__)
+    __m128 yv = _mm_set1_ps(y);
+    __m128 fail = _mm_or_ps(_mm_cmplt_ps(yv, _mm_loadu_ps(&list->lowerY[i])),
+                            _mm_cmpgt_ps(yv, _mm_loadu_ps(&list->upperY[i])));
+    fail = _mm_or_ps(fail, _mm_cmplt_ps(_mm_set1_ps(x + pad), _mm_loadu_ps(&list->minX[i])));
+    fail = _mm_or_ps(fail, _mm_cmpgt_ps(_mm_set1_ps(x - pad), _mm_loadu_ps(&list->maxX[i])));
+    fail = _mm_or_ps(fail, _mm_cmplt_ps(_mm_set1_ps(z + pad), _mm_loadu_ps(&list->minZ[i])));
+    fail = _mm_or_ps(fail, _mm_cmpgt_ps(_mm_set1_ps(z - pad), _mm_loadu_ps(&list->maxZ[i])));
+    return ~_mm_movemask_ps(fail) & packed_count_mask(list, i);
+#elif PACKED_LANES == 4
+    static const u32 laneBits[4] = { 1, 2, 4, 8 };
+    float32x4_t yv = vdupq_n_f32(y);
+    uint32x4_t fail = vorrq_u32(vcltq_f32(yv, vld1q_f32(&list->lowerY[i])),
+                                vcgtq_f32(yv, vld1q_f32(&list->upperY[i])));
+    fail = vorrq_u32(fail, vcltq_f32(vdupq_n_f32(x + pad), vld1q_f32(&list->minX[i])));
+    fail = vorrq_u32(fail, vcgtq_f32(vdupq_n_f32(x - pad), vld1q_f32(&list->maxX[i])));
+    fail = vorrq_u32(fail, vcltq_f32(vdupq_n_f32(z + pad), vld1q_f32(&list->minZ[i])));
+    fail = vorrq_u32(fail, vcgtq_f32(vdupq_n_f32(z - pad), vld1q_f32(&list->maxZ[i])));
+    return ~vaddvq_u32(vandq_u32(fail, vld1q_u32(laneBits))) & packed_count_mask(list, i);
+#else
+    return !(y < list->lowerY[i] || y > list->upperY[i] || x + pad < list->minX[i] || x - pad > list->maxX[i]
+             || z + pad < list->minZ[i] || z - pad > list->maxZ[i]);
+#endif
+}
+#endif
+
 /**************************************************
  *                      WALLS                     *
  **************************************************/
 
+/**
+ * Test a single wall against the collision sphere and, if it collides, push the sphere out of
+ * it. Returns whether the wall collided.
+ */
+static s32 resolve_wall_collision(struct Surface *surf, struct WallCollisionData *data,
+                                  f32 x, f32 y, f32 z, f32 radius) {
+    register f32 offset;
+    register f32 px, pz;
+    register f32 w1, w2, w3;
+    register f32 y1, y2, y3;
+
+    offset = surf->normal.x * x + surf->normal.y * y + surf->normal.z * z + surf->originOffset;
+
+    if (offset < -radius || offset > radius) {
+        return FALSE;
+    }
+
+    px = x;
+    pz = z;
+
+    //! (Quantum Tunneling) Due to issues with the vertices walls choose and
+    //  the fact they are floating point, certain floating point positions
+    //  along the seam of two walls may collide with neither wall or both walls.
+    if (surf->flags & SURFACE_FLAG_X_PROJECTION) {
+        w1 = -surf->vertex1[2];            w2 = -surf->vertex2[2];            w3 = -surf->vertex3[2];
+        y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+
+        if (surf->normal.x > 0.0f) {
+            if ((y1 - y) * (w2 - w1) - (w1 - -pz) * (y2 - y1) > 0.0f) {
+                return FALSE;
+            }
+            if ((y2 - y) * (w3 - w2) - (w2 - -pz) * (y3 - y2) > 0.0f) {
+                return FALSE;
+            }
+            if ((y3 - y) * (w1 - w3) - (w3 - -pz) * (y1 - y3) > 0.0f) {
+                return FALSE;
+            }
+        } else {
+            if ((y1 - y) * (w2 - w1) - (w1 - -pz) * (y2 - y1) < 0.0f) {
+                return FALSE;
+            }
+            if ((y2 - y) * (w3 - w2) - (w2 - -pz) * (y3 - y2) < 0.0f) {
+                return FALSE;
+            }
+            if ((y3 - y) * (w1 - w3) - (w3 - -pz) * (y1 - y3) < 0.0f) {
+                return FALSE;
+            }
+        }
+    } else {
+        w1 = surf->vertex1[0];            w2 = surf->vertex2[0];            w3 = surf->vertex3[0];
+        y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+
+        if (surf->normal.z > 0.0f) {
+            if ((y1 - y) * (w2 - w1) - (w1 - px) * (y2 - y1) > 0.0f) {
+                return FALSE;
+            }
+            if ((y2 - y) * (w3 - w2) - (w2 - px) * (y3 - y2) > 0.0f) {
+                return FALSE;
+            }
+            if ((y3 - y) * (w1 - w3) - (w3 - px) * (y1 - y3) > 0.0f) {
+                return FALSE;
+            }
+        } else {
+            if ((y1 - y) * (w2 - w1) - (w1 - px) * (y2 - y1) < 0.0f) {
+                return FALSE;
+            }
+            if ((y2 - y) * (w3 - w2) - (w2 - px) * (y3 - y2) < 0.0f) {
+                return FALSE;
+            }
+            if ((y3 - y) * (w1 - w3) - (w3 - px) * (y1 - y3) < 0.0f) {
+                return FALSE;
+            }
+        }
+    }
+
+    // Determine if checking for the camera or not.
+    if (gCheckingSurfaceCollisionsForCamera) {
+        if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+            return FALSE;
+        }
+    } else {
+        // Ignore camera only surfaces.
+        if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+            return FALSE;
+        }
+
+        // If an object can pass through a vanish cap wall, pass through.
+        if (surf->type == SURFACE_VANISH_CAP_WALLS) {
+            // If an object can pass through a vanish cap wall, pass through.
+            if (gCurrentObject != NULL
+                && (gCurrentObject->activeFlags & ACTIVE_FLAG_MOVE_THROUGH_GRATE)) {
+                    return FALSE;
+            }
+
+            // If Mario has a vanish cap, pass through the vanish cap wall.
+            if (gCurrentObject != NULL && gCurrentObject == gMarioObject
+                && (gMarioState->flags & MARIO_VANISH_CAP)) {
+                    return FALSE;
+            }
+        }
+    }
+
+    //! (Wall Overlaps) Because this doesn't update the x and z local variables,
+    //  multiple walls can push mario more than is required.
+    data->x += surf->normal.x * (radius - offset);
+    data->z += surf->normal.z * (radius - offset);
+
+    //! (Unreferenced Walls) Since this only returns the first four walls,
+    //  this can lead to wall interaction being missed. Typically unreferenced walls
+    //  come from only using one wall, however.
+    if (data->numWalls < 4) {
+        data->walls[data->numWalls++] = surf;
+    }
+
+    return TRUE;
+}
+
 /**
  * Iterate through the list of walls until all walls are checked and
  * have given their wall push.
@@ -19,14 +324,10 @@
 static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
                                           struct WallCollisionData *data) {
     register struct Surface *surf;
-    register f32 offset;
     register f32 radius = data->radius;
     register f32 x = data->x;
     register f32 y = data->y + data->offsetY;
     register f32 z = data->z;
-    register f32 px, pz;
-    register f32 w1, w2, w3;
-    register f32 y1, y2, y3;
     s32 numCols = 0;
 
     // Max collision radius = 200
@@ -36,6 +337,13 @@ static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
 
     // Stay in this loop until out of walls.
     while (surfaceNode != NULL) {
+#ifdef USE_SYSTEM_MALLOC
+        if (!DYNAMIC_SURFACE_NODE_LOADED(surfaceNode)) {
+            surfaceNode = surfaceNode->next;
+            continue;
+        }
+#endif
+        PROFILE_SCANNED(1);
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
 
@@ -44,114 +352,56 @@ static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
             continue;
         }
 
-        offset = surf->normal.x * x + surf->normal.y * y + surf->normal.z * z + surf->originOffset;
-
-        if (offset < -radius || offset > radius) {
-            continue;
+        if (resolve_wall_collision(surf, data, x, y, z, radius)) {
+            numCols++;
         }
+    }
 
-        px = x;
-        pz = z;
-
-        //! (Quantum Tunneling) Due to issues with the vertices walls choose and
-        //  the fact they are floating point, certain floating point positions
-        //  along the seam of two walls may collide with neither wall or both walls.
-        if (surf->flags & SURFACE_FLAG_X_PROJECTION) {
-            w1 = -surf->vertex1[2];            w2 = -surf->vertex2[2];            w3 = -surf->vertex3[2];
-            y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+    return numCols;
+}
 
-            if (surf->normal.x > 0.0f) {
-                if ((y1 - y) * (w2 - w1) - (w1 - -pz) * (y2 - y1) > 0.0f) {
-                    continue;
-                }
-                if ((y2 - y) * (w3 - w2) - (w2 - -pz) * (y3 - y2) > 0.0f) {
-                    continue;
-                }
-                if ((y3 - y) * (w1 - w3) - (w3 - -pz) * (y1 - y3) > 0.0f) {
-                    continue;
-                }
-            } else {
-                if ((y1 - y) * (w2 - w1) - (w1 - -pz) * (y2 - y1) < 0.0f) {
-                    continue;
-                }
-                if ((y2 - y) * (w3 - w2) - (w2 - -pz) * (y3 - y2) < 0.0f) {
-                    continue;
-                }
-                if ((y3 - y) * (w1 - w3) - (w3 - -pz) * (y1 - y3) < 0.0f) {
-                    continue;
-                }
-            }
-        } else {
-            w1 = surf->vertex1[0];            w2 = surf->vertex2[0];            w3 = surf->vertex3[0];
-            y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Packed version of find_wall_collisions_from_list. Walls outside the y range or too far away
+ * in x or z are rejected several at a time, and the rest are resolved in list order.
+ */
+static s32 find_wall_collisions_from_packed(struct PackedSurfaceList *list,
+                                            struct WallCollisionData *data) {
+    f32 radius = data->radius;
+    f32 x = data->x;
+    f32 y = data->y + data->offsetY;
+    f32 z = data->z;
+    f32 pad;
+    s32 numCols = 0;
+    u32 mask;
+    s32 i, j;
 
-            if (surf->normal.z > 0.0f) {
-                if ((y1 - y) * (w2 - w1) - (w1 - px) * (y2 - y1) > 0.0f) {
-                    continue;
-                }
-                if ((y2 - y) * (w3 - w2) - (w2 - px) * (y3 - y2) > 0.0f) {
-                    continue;
-                }
-                if ((y3 - y) * (w1 - w3) - (w3 - px) * (y1 - y3) > 0.0f) {
-                    continue;
-                }
-            } else {
-                if ((y1 - y) * (w2 - w1) - (w1 - px) * (y2 - y1) < 0.0f) {
-                    continue;
-                }
-                if ((y2 - y) * (w3 - w2) - (w2 - px) * (y3 - y2) < 0.0f) {
-                    continue;
-                }
-                if ((y3 - y) * (w1 - w3) - (w3 - px) * (y1 - y3) < 0.0f) {
-                    continue;
-                }
-            }
-        }
+    // Max collision radius = 200
+    if (radius > 200.0f) {
+        radius = 200.0f;
+    }
 
-        // Determine if checking for the camera or not.
-        if (gCheckingSurfaceCollisionsForCamera) {
-            if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
-                continue;
-            }
-        } else {
-            // Ignore camera only surfaces.
-            if (surf->type == SURFACE_CAMERA_BOUNDARY) {
-                continue;
-            }
+    // resolve_wall_collision checks the point against the wall's projection along x or z,
+    // whichever the normal is closer to, so a colliding wall can be up to radius / 0.707 units
+    // away on that axis. The slack covers the point in triangle test being done in floats.
+    pad = radius * 1.5f + 1.0f;
 
-            // If an object can pass through a vanish cap wall, pass through.
-            if (surf->type == SURFACE_VANISH_CAP_WALLS) {
-                // If an object can pass through a vanish cap wall, pass through.
-                if (gCurrentObject != NULL
-                    && (gCurrentObject->activeFlags & ACTIVE_FLAG_MOVE_THROUGH_GRATE)) {
-                    continue;
-                }
+    PROFILE_SCANNED(list->count);
+    for (i = 0; i < list->count; i += PACKED_LANES) {
+        mask = packed_wall_mask(list, i, x, y, z, pad);
+        while (mask != 0) {
+            j = i + __builtin_ctz(mask);
+            mask &= mask - 1;
 
-                // If Mario has a vanish cap, pass through the vanish cap wall.
-                if (gCurrentObject != NULL && gCurrentObject == gMarioObject
-                    && (gMarioState->flags & MARIO_VANISH_CAP)) {
-                    continue;
-                }
+            if (resolve_wall_collision(list->surfaces[j], data, x, y, z, radius)) {
+                numCols++;
             }
         }
-
-        //! (Wall Overlaps) Because this doesn't update the x and z local variables,
-        //  multiple walls can push mario more than is required.
-        data->x += surf->normal.x * (radius - offset);
-        data->z += surf->normal.z * (radius - offset);
-
-        //! (Unreferenced Walls) Since this only returns the first four walls,
-        //  this can lead to wall interaction being missed. Typically unreferenced walls
-        //  come from only using one wall, however.
-        if (data->numWalls < 4) {
-            data->walls[data->numWalls++] = surf;
-        }
-
-        numCols++;
     }
 
     return numCols;
 }
+#endif
 
 /**
  * Formats the position and wall search for find_wall_collisions.
@@ -169,7 +419,9 @@ s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 ra
 
     collision.numWalls = 0;
 
+    PROFILE_BEGIN(COLLISION_QUERY_WALL);
     numCollisions = find_wall_collisions(&collision);
+    PROFILE_END();
 
     *xPtr = collision.x;
     *yPtr = collision.y;
@@ -181,7 +433,11 @@ s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 ra
 /**
  * Find wall collisions and receive their push.
  */
+#ifdef USE_SYSTEM_MALLOC
+static s32 find_wall_collisions_internal(struct WallCollisionData *colData) {
+#else
 s32 find_wall_collisions(struct WallCollisionData *colData) {
+#endif
     struct SurfaceNode *node;
     s16 cellX, cellZ;
     s32 numCollisions = 0;
@@ -201,14 +457,20 @@ s32 find_wall_collisions(struct WallCollisionData *colData) {
     // the grid (round toward -inf)
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+    PROFILE_CELL(cellX, cellZ);
 
     // Check for surfaces belonging to objects.
     node = gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next;
     numCollisions += find_wall_collisions_from_list(node, colData);
 
     // Check for surfaces that are a part of level geometry.
+#ifdef USE_SYSTEM_MALLOC
+    numCollisions += find_wall_collisions_from_packed(
+        &gStaticPackedPartition[cellZ][cellX][SPATIAL_PARTITION_WALLS], colData);
+#else
     node = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next;
     numCollisions += find_wall_collisions_from_list(node, colData);
+#endif
 
     // Increment the debug tracker.
     gNumCalls.wall += 1;
@@ -216,6 +478,17 @@ s32 find_wall_collisions(struct WallCollisionData *colData) {
     return numCollisions;
 }
 
+#ifdef USE_SYSTEM_MALLOC
+s32 find_wall_collisions(struct WallCollisionData *colData) {
+    s32 numCollisions;
+
+    PROFILE_BEGIN(COLLISION_QUERY_WALL);
+    numCollisions = find_wall_collisions_internal(colData);
+    PROFILE_END();
+    return numCollisions;
+}
+#endif
+
 /**************************************************
  *                     CEILINGS                   *
  **************************************************/
@@ -231,6 +504,13 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
     *pheight = CELL_HEIGHT_LIMIT;
     // Stay in this loop until out of ceilings.
     while (surfaceNode != NULL) {
+#ifdef USE_SYSTEM_MALLOC
+        if (!DYNAMIC_SURFACE_NODE_LOADED(surfaceNode)) {
+            surfaceNode = surfaceNode->next;
+            continue;
+        }
+#endif
+        PROFILE_SCANNED(1);
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
         x1 = surf->vertex1[0];
@@ -289,6 +569,91 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
     return ceil;
 }
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Packed version of find_ceil_from_list. The lateral triangle test is done several surfaces at
+ * a time, and the surfaces that pass are checked in list order like before.
+ */
+static struct Surface *find_ceil_from_packed(struct PackedSurfaceList *list, s32 x, s32 y, s32 z, f32 *pheight) {
+    f32 nx, ny, nz, oo, height;
+    struct Surface *ceil = NULL;
+    u32 mask;
+    s32 i, j;
+
+    *pheight = CELL_HEIGHT_LIMIT;
+    PROFILE_SCANNED(list->count);
+    for (i = 0; i < list->count; i += PACKED_LANES) {
+        mask = packed_edge_mask(list, i, x, z, TRUE);
+        while (mask != 0) {
+            j = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+
+            // Determine if checking for the camera or not.
+            if (gCheckingSurfaceCollisionsForCamera != 0) {
+                if (list->flags[j] & SURFACE_FLAG_NO_CAM_COLLISION) {
+                    continue;
+                }
+            }
+            // Ignore camera only surfaces.
+            else if (list->type[j] == SURFACE_CAMERA_BOUNDARY) {
+                continue;
+            }
+            nx = list->normalX[j];
+            ny = list->normalY[j];
+            nz = list->normalZ[j];
+            oo = list->originOffset[j];
+            // If a wall, ignore it. Likely a remnant, should never occur.
+            if (ny == 0.0f) {
+                continue;
+            }
+            // Find the ceil height at the specific point.
+            height = -(x * nx + nz * z + oo) / ny;
+            if (height > *pheight) {
+                continue;
+            }
+            // Checks for ceiling interaction
+            if (y > height) {
+                continue;
+            }
+            if (y >= list->upperY[j]) {
+                continue;
+            }
+            *pheight = height;
+            ceil = list->surfaces[j];
+            if (height == y) {
+                return ceil;
+            }
+        }
+    }
+    return ceil;
+}
+#endif
+
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Get the static floors or ceilings that can be hit at a point of the given cell. The point
+ * is only needed when the cells are split further (STATIC_PARTITION_MODE 1).
+ */
+static struct PackedSurfaceList *get_static_packed_list(s16 cellX, s16 cellZ, s16 listIndex,
+                                                        UNUSED s32 x, UNUSED s32 z) {
+#if STATIC_PARTITION_MODE == 1
+    struct PackedSurfaceTree *tree = gStaticPackedTrees[cellZ][cellX][listIndex];
+    s32 localX, localZ, half;
+
+    if (tree != NULL) {
+        localX = (x + LEVEL_BOUNDARY_MAX) & (CELL_SIZE - 1);
+        localZ = (z + LEVEL_BOUNDARY_MAX) & (CELL_SIZE - 1);
+
+        for (half = CELL_SIZE / 2; tree->children != NULL; half >>= 1) {
+            tree = &tree->children[((localZ & half) ? 2 : 0) | ((localX & half) ? 1 : 0)];
+        }
+        return &tree->list;
+    }
+#endif
+    return &gStaticPackedPartition[cellZ][cellX][listIndex];
+}
+#endif
+
 /**
  * Find the lowest ceiling above a given position and return the height.
  */
@@ -308,24 +673,34 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     z = (s16) posZ;
     *pceil = NULL;
 
+    PROFILE_BEGIN(COLLISION_QUERY_CEIL);
+
     if (x <= -LEVEL_BOUNDARY_MAX || x >= LEVEL_BOUNDARY_MAX) {
+        PROFILE_END();
         return height;
     }
     if (z <= -LEVEL_BOUNDARY_MAX || z >= LEVEL_BOUNDARY_MAX) {
+        PROFILE_END();
         return height;
     }
 
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+    PROFILE_CELL(cellX, cellZ);
 
     // Check for surfaces belonging to objects.
     surfaceList = gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next;
     dynamicCeil = find_ceil_from_list(surfaceList, x, y, z, &dynamicHeight);
 
     // Check for surfaces that are a part of level geometry.
+#ifdef USE_SYSTEM_MALLOC
+    ceil = find_ceil_from_packed(get_static_packed_list(cellX, cellZ, SPATIAL_PARTITION_CEILS, x, z), x, y, z,
+                                 &height);
+#else
     surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next;
     ceil = find_ceil_from_list(surfaceList, x, y, z, &height);
+#endif
 
     if (dynamicHeight < height) {
         ceil = dynamicCeil;
@@ -337,6 +712,7 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     // Increment the debug tracker.
     gNumCalls.ceil += 1;
 
+    PROFILE_END();
     return height;
 }
 
@@ -367,7 +743,11 @@ UNUSED static u8 unused8038BE50[0x40];
  */
 f32 find_floor_height_and_data(f32 xPos, f32 yPos, f32 zPos, struct FloorGeometry **floorGeo) {
     struct Surface *floor;
-    f32 floorHeight = find_floor(xPos, yPos, zPos, &floor);
+    f32 floorHeight;
+
+    PROFILE_BEGIN(COLLISION_QUERY_FLOOR);
+    floorHeight = find_floor(xPos, yPos, zPos, &floor);
+    PROFILE_END();
 
     *floorGeo = NULL;
 
@@ -393,6 +773,13 @@ static struct Surface *find_floor_from_list(struct SurfaceNode *surfaceNode, s32
     *pheight = FLOOR_LOWER_LIMIT;
     // Iterate through the list of floors until there are no more floors.
     while (surfaceNode != NULL) {
+#ifdef USE_SYSTEM_MALLOC
+        if (!DYNAMIC_SURFACE_NODE_LOADED(surfaceNode)) {
+            surfaceNode = surfaceNode->next;
+            continue;
+        }
+#endif
+        PROFILE_SCANNED(1);
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
         x1 = surf->vertex1[0];
@@ -448,13 +835,159 @@ static struct Surface *find_floor_from_list(struct SurfaceNode *surfaceNode, s32
     return floor;
 }
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Packed version of find_floor_from_list. The lateral triangle test is done several surfaces
+ * at a time, and the surfaces that pass are checked in list order like before.
+ */
+static struct Surface *find_floor_from_packed(struct PackedSurfaceList *list, s32 x, s32 y, s32 z, f32 *pheight) {
+    f32 nx, ny, nz, oo, height;
+    struct Surface *floor = NULL;
+    u32 mask;
+    s32 i, j;
+
+    *pheight = FLOOR_LOWER_LIMIT;
+    PROFILE_SCANNED(list->count);
+    for (i = 0; i < list->count; i += PACKED_LANES) {
+        mask = packed_edge_mask(list, i, x, z, FALSE);
+        while (mask != 0) {
+            j = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+
+            // Determine if we are checking for the camera or not.
+            if (gCheckingSurfaceCollisionsForCamera != 0) {
+                if (list->flags[j] & SURFACE_FLAG_NO_CAM_COLLISION) {
+                    continue;
+                }
+            }
+            // If we are not checking for the camera, ignore camera only floors.
+            else if (list->type[j] == SURFACE_CAMERA_BOUNDARY) {
+                continue;
+            }
+            nx = list->normalX[j];
+            ny = list->normalY[j];
+            nz = list->normalZ[j];
+            oo = list->originOffset[j];
+            // If a wall, ignore it. Likely a remnant, should never occur.
+            if (ny == 0.0f) {
+                continue;
+            }
+            // Find the height of the floor at a given location.
+            height = -(x * nx + nz * z + oo) / ny;
+            if (height < *pheight) {
+                continue;
+            }
+            // Checks for floor interaction with a 78 unit buffer.
+            if (y < (height - 78.0f)) {
+                continue;
+            }
+            *pheight = height;
+            floor = list->surfaces[j];
+            if (height - 78.0f == y) {
+                return floor;
+            }
+        }
+    }
+    return floor;
+}
+#endif
+
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Find the highest static floor under a point, looking below SURFACE_INTANGIBLE floors unless
+ * gFindFloorIncludeSurfaceIntangible is set. See find_floor.
+ */
+static struct Surface *find_static_floor(s16 cellX, s16 cellZ, s32 x, s32 y, s32 z, f32 *pheight) {
+    struct PackedSurfaceList *staticList = get_static_packed_list(cellX, cellZ, SPATIAL_PARTITION_FLOORS, x, z);
+    struct Surface *floor = find_floor_from_packed(staticList, x, y, z, pheight);
+
+    // To prevent the Merry-Go-Round room from loading when Mario passes above the hole that leads
+    // there, SURFACE_INTANGIBLE is used. This prevent the wrong room from loading, but can also allow
+    // Mario to pass through.
+    //! (BBH Crash) If there is no floor under the SURFACE_INTANGIBLE floor, this returns a NULL
+    //  floor but the height of the SURFACE_INTANGIBLE floor.
+    if (!gFindFloorIncludeSurfaceIntangible && floor != NULL && floor->type == SURFACE_INTANGIBLE) {
+        floor = find_floor_from_packed(staticList, x, (s32)(*pheight - 200.0f), z, pheight);
+    }
+    return floor;
+}
+#endif
+
+#if defined(USE_SYSTEM_MALLOC) && defined(FLOOR_QUERY_CACHE)
+/**
+ * The level geometry only changes when an area is loaded, so the static floor found for a point
+ * stays valid until then. Objects, Mario, the camera and shadows tend to query the same points
+ * several times a frame and, when standing still, every frame. Each entry remembers the static
+ * floor for one point and set of query flags; object floors are still searched every time.
+ */
+#define FLOOR_QUERY_CACHE_SIZE 1024
+
+#define FLOOR_QUERY_VALID      (1 << 0)
+#define FLOOR_QUERY_CAMERA     (1 << 1)
+#define FLOOR_QUERY_INTANGIBLE (1 << 2)
+
+struct FloorQueryCacheEntry
+{
+    s16 x, y, z;
+    u8 flags;
+    struct Surface *floor;
+    f32 height;
+};
+
+static struct FloorQueryCacheEntry sFloorQueryCache[FLOOR_QUERY_CACHE_SIZE];
+
+s32 gFloorQueryCacheHits;
+s32 gFloorQueryCacheMisses;
+
+void clear_floor_query_cache(void) {
+    bzero(sFloorQueryCache, sizeof(sFloorQueryCache));
+}
+
+/**
+ * find_static_floor, remembering the result for the point.
+ */
+static struct Surface *find_static_floor_cached(s16 cellX, s16 cellZ, s16 x, s16 y, s16 z, f32 *pheight) {
+    struct FloorQueryCacheEntry *entry;
+    u32 hash;
+    u8 flags = FLOOR_QUERY_VALID;
+
+    if (gCheckingSurfaceCollisionsForCamera != 0) {
+        flags |= FLOOR_QUERY_CAMERA;
+    }
+    if (gFindFloorIncludeSurfaceIntangible) {
+        flags |= FLOOR_QUERY_INTANGIBLE;
+    }
+
+    hash = (u16) x * 73856093U ^ (u16) y * 19349663U ^ (u16) z * 83492791U;
+    entry = &sFloorQueryCache[(hash >> 16) & (FLOOR_QUERY_CACHE_SIZE - 1)];
+
+    if (entry->flags == flags && entry->x == x && entry->y == y && entry->z == z) {
+        gFloorQueryCacheHits++;
+        *pheight = entry->height;
+        return entry->floor;
+    }
+
+    gFloorQueryCacheMisses++;
+    entry->x = x;
+    entry->y = y;
+    entry->z = z;
+    entry->flags = flags;
+    entry->floor = find_static_floor(cellX, cellZ, x, y, z, &entry->height);
+    *pheight = entry->height;
+    return entry->floor;
+}
+#endif
+
 /**
  * Find the height of the highest floor below a point.
  */
 f32 find_floor_height(f32 x, f32 y, f32 z) {
     struct Surface *floor;
+    f32 floorHeight;
 
-    f32 floorHeight = find_floor(x, y, z, &floor);
+    PROFILE_BEGIN(COLLISION_QUERY_FLOOR);
+    floorHeight = find_floor(x, y, z, &floor);
+    PROFILE_END();
 
     return floorHeight;
 }
@@ -488,7 +1021,11 @@ f32 unused_find_dynamic_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfl
 /**
  * Find the highest floor under a given position and return the height.
  */
+#ifdef USE_SYSTEM_MALLOC
+static f32 find_floor_internal(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+#else
 f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+#endif
     s16 cellZ, cellX;
 
     struct Surface *floor, *dynamicFloor;
@@ -516,12 +1053,24 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+    PROFILE_CELL(cellX, cellZ);
 
     // Check for surfaces belonging to objects.
     surfaceList = gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
     dynamicFloor = find_floor_from_list(surfaceList, x, y, z, &dynamicHeight);
 
     // Check for surfaces that are a part of level geometry.
+#ifdef USE_SYSTEM_MALLOC
+#ifdef FLOOR_QUERY_CACHE
+    floor = find_static_floor_cached(cellX, cellZ, x, y, z, &height);
+#else
+    floor = find_static_floor(cellX, cellZ, x, y, z, &height);
+#endif
+    if (gFindFloorIncludeSurfaceIntangible) {
+        // To prevent accidentally leaving the floor tangible, stop checking for it.
+        gFindFloorIncludeSurfaceIntangible = FALSE;
+    }
+#else
     surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
     floor = find_floor_from_list(surfaceList, x, y, z, &height);
 
@@ -540,6 +1089,7 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         // To prevent accidentally leaving the floor tangible, stop checking for it.
         gFindFloorIncludeSurfaceIntangible = FALSE;
     }
+#endif
 
     // If a floor was missed, increment the debug counter.
     if (floor == NULL) {
@@ -559,6 +1109,267 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     return height;
 }
 
+#ifdef USE_SYSTEM_MALLOC
+f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+    f32 height;
+
+    PROFILE_BEGIN(COLLISION_QUERY_FLOOR);
+    height = find_floor_internal(xPos, yPos, zPos, pfloor);
+    PROFILE_END();
+    return height;
+}
+#endif
+
+#ifndef TARGET_N64
+/**************************************************
+ *                      RAYS                      *
+ **************************************************/
+
+/**
+ * Return the distance along a ray (dir is normalized) to where it enters the front of a surface,
+ * or -1 if it misses. Like the other queries, surfaces only collide from the front.
+ */
+static f32 raycast_surface(struct Surface *surf, Vec3f origin, Vec3f dir) {
+    f32 e1[3], e2[3], p[3], s[3], q[3];
+    f32 det, u, v, t;
+
+    if (surf->normal.x * dir[0] + surf->normal.y * dir[1] + surf->normal.z * dir[2] >= 0.0f) {
+        return -1.0f;
+    }
+
+    // Determine if checking for the camera or not.
+    if (gCheckingSurfaceCollisionsForCamera != 0) {
+        if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+            return -1.0f;
+        }
+    }
+    // Ignore camera only surfaces.
+    else if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+        return -1.0f;
+    }
+
+    e1[0] = surf->vertex2[0] - surf->vertex1[0];
+    e1[1] = surf->vertex2[1] - surf->vertex1[1];
+    e1[2] = surf->vertex2[2] - surf->vertex1[2];
+    e2[0] = surf->vertex3[0] - surf->vertex1[0];
+    e2[1] = surf->vertex3[1] - surf->vertex1[1];
+    e2[2] = surf->vertex3[2] - surf->vertex1[2];
+
+    p[0] = dir[1] * e2[2] - dir[2] * e2[1];
+    p[1] = dir[2] * e2[0] - dir[0] * e2[2];
+    p[2] = dir[0] * e2[1] - dir[1] * e2[0];
+    det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (det == 0.0f) {
+        return -1.0f;
+    }
+
+    s[0] = origin[0] - surf->vertex1[0];
+    s[1] = origin[1] - surf->vertex1[1];
+    s[2] = origin[2] - surf->vertex1[2];
+    u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+    if (u < 0.0f || u > 1.0f) {
+        return -1.0f;
+    }
+
+    q[0] = s[1] * e1[2] - s[2] * e1[1];
+    q[1] = s[2] * e1[0] - s[0] * e1[2];
+    q[2] = s[0] * e1[1] - s[1] * e1[0];
+    v = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) / det;
+    if (v < 0.0f || u + v > 1.0f) {
+        return -1.0f;
+    }
+
+    t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+    return t >= 0.0f ? t : -1.0f;
+}
+
+/**
+ * Test a cell's surface list against the ray, keeping the closest hit in hit. minY and maxY
+ * bound the height of the ray in the cell.
+ */
+static void raycast_list(struct SurfaceNode *surfaceNode, s32 isDynamic, Vec3f origin, Vec3f dir,
+                         f32 minY, f32 maxY, struct RaycastHit *hit) {
+    struct Surface *surf;
+    f32 t;
+
+    while (surfaceNode != NULL) {
+#ifdef USE_SYSTEM_MALLOC
+        if (isDynamic && !DYNAMIC_SURFACE_NODE_LOADED(surfaceNode)) {
+            surfaceNode = surfaceNode->next;
+            continue;
+        }
+#endif
+        PROFILE_SCANNED(1);
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+
+        // Exclude a large number of surfaces immediately to optimize.
+        if (surf->upperY < minY || surf->lowerY > maxY) {
+            continue;
+        }
+
+        t = raycast_surface(surf, origin, dir);
+        if (t >= 0.0f && t < hit->dist) {
+            hit->dist = t;
+            hit->surface = surf;
+        }
+    }
+}
+
+/**
+ * Walk the cells along the ray for raycast.
+ */
+static s32 raycast_internal(Vec3f origin, Vec3f dir, f32 maxDist, s32 flags, struct RaycastHit *hit) {
+    Vec3f unitDir;
+    f32 len, tMin, tMax, t0, t1, tNextX, tNextZ, tDeltaX, tDeltaZ, tExit, y0, y1;
+    s32 cellX, cellZ, stepX, stepZ, axis, list;
+
+    hit->surface = NULL;
+    hit->dist = maxDist;
+
+    // Increment the debug tracker.
+    gNumCalls.ray += 1;
+
+    len = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    if (len == 0.0f || !(maxDist > 0.0f)) {
+        return FALSE;
+    }
+    unitDir[0] = dir[0] / len;
+    unitDir[1] = dir[1] / len;
+    unitDir[2] = dir[2] / len;
+
+    // Clip the ray to the level boundary.
+    tMin = 0.0f;
+    tMax = maxDist;
+    for (axis = 0; axis < 3; axis += 2) {
+        if (unitDir[axis] == 0.0f) {
+            if (origin[axis] <= -LEVEL_BOUNDARY_MAX || origin[axis] >= LEVEL_BOUNDARY_MAX) {
+                return FALSE;
+            }
+        } else {
+            t0 = (-LEVEL_BOUNDARY_MAX - origin[axis]) / unitDir[axis];
+            t1 = (LEVEL_BOUNDARY_MAX - origin[axis]) / unitDir[axis];
+            if (t0 > t1) {
+                len = t0;
+                t0 = t1;
+                t1 = len;
+            }
+            if (t0 > tMin) {
+                tMin = t0;
+            }
+            if (t1 < tMax) {
+                tMax = t1;
+            }
+        }
+    }
+    if (tMin > tMax) {
+        return FALSE;
+    }
+
+    cellX = (origin[0] + unitDir[0] * tMin + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    cellZ = (origin[2] + unitDir[2] * tMin + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    // The clipped start can round onto the far boundary.
+    if (cellX > NUM_CELLS_INDEX) {
+        cellX = NUM_CELLS_INDEX;
+    }
+    if (cellZ > NUM_CELLS_INDEX) {
+        cellZ = NUM_CELLS_INDEX;
+    }
+
+    // Distances along the ray to the next cell boundary on each axis, and between boundaries.
+    stepX = unitDir[0] < 0.0f ? -1 : 1;
+    stepZ = unitDir[2] < 0.0f ? -1 : 1;
+    if (unitDir[0] != 0.0f) {
+        tNextX = ((cellX + (stepX > 0)) * CELL_SIZE - LEVEL_BOUNDARY_MAX - origin[0]) / unitDir[0];
+        tDeltaX = CELL_SIZE / (unitDir[0] * stepX);
+    } else {
+        tNextX = tDeltaX = tMax + 1.0f;
+    }
+    if (unitDir[2] != 0.0f) {
+        tNextZ = ((cellZ + (stepZ > 0)) * CELL_SIZE - LEVEL_BOUNDARY_MAX - origin[2]) / unitDir[2];
+        tDeltaZ = CELL_SIZE / (unitDir[2] * stepZ);
+    } else {
+        tNextZ = tDeltaZ = tMax + 1.0f;
+    }
+
+    while (TRUE) {
+        PROFILE_CELL(cellX, cellZ);
+
+        tExit = tNextX < tNextZ ? tNextX : tNextZ;
+        if (tExit > tMax) {
+            tExit = tMax;
+        }
+
+        // A surface the ray hits in this cell is in the cell's lists, so only surfaces that reach
+        // the height of the ray between entering and leaving the cell need to be tested.
+        y0 = origin[1] + unitDir[1] * tMin;
+        y1 = origin[1] + unitDir[1] * tExit;
+        if (y0 > y1) {
+            len = y0;
+            y0 = y1;
+            y1 = len;
+        }
+        for (list = SPATIAL_PARTITION_FLOORS; list <= SPATIAL_PARTITION_WALLS; list++) {
+            if (flags & (1 << list)) {
+                raycast_list(gDynamicSurfacePartition[cellZ][cellX][list].next, TRUE, origin, unitDir, y0, y1, hit);
+                raycast_list(gStaticSurfacePartition[cellZ][cellX][list].next, FALSE, origin, unitDir, y0, y1, hit);
+            }
+        }
+
+        // Surfaces span several cells, so a hit only ends the search once the ray can't reach
+        // anything closer in a later cell.
+        if (hit->surface != NULL && hit->dist <= tExit) {
+            break;
+        }
+        if (tExit >= tMax) {
+            break;
+        }
+        tMin = tExit;
+
+        if (tNextX < tNextZ) {
+            cellX += stepX;
+            tNextX += tDeltaX;
+        } else {
+            cellZ += stepZ;
+            tNextZ += tDeltaZ;
+        }
+        if (cellX < 0 || cellX > NUM_CELLS_INDEX || cellZ < 0 || cellZ > NUM_CELLS_INDEX) {
+            break;
+        }
+    }
+
+    if (hit->surface == NULL) {
+        hit->dist = maxDist;
+        return FALSE;
+    }
+
+    hit->pos[0] = origin[0] + unitDir[0] * hit->dist;
+    hit->pos[1] = origin[1] + unitDir[1] * hit->dist;
+    hit->pos[2] = origin[2] + unitDir[2] * hit->dist;
+    hit->normal[0] = hit->surface->normal.x;
+    hit->normal[1] = hit->surface->normal.y;
+    hit->normal[2] = hit->surface->normal.z;
+    return TRUE;
+}
+
+/**
+ * Find the first surface a ray hits within maxDist of its origin. The cells the ray crosses are
+ * walked in order, so the search stops at the first cell that contains a hit nearer than where
+ * the ray leaves it. flags is a mask of RAYCAST_FLOORS, RAYCAST_CEILS and RAYCAST_WALLS, and
+ * gCheckingSurfaceCollisionsForCamera is respected like in the other queries.
+ *
+ * dir does not need to be normalized. Returns TRUE and fills in hit if a surface was hit.
+ */
+s32 raycast(Vec3f origin, Vec3f dir, f32 maxDist, s32 flags, struct RaycastHit *hit) {
+    s32 result;
+
+    PROFILE_BEGIN(COLLISION_QUERY_RAY);
+    result = raycast_internal(origin, dir, maxDist, flags, hit);
+    PROFILE_END();
+    return result;
+}
+#endif
+
 /**************************************************
  *               ENVIRONMENTAL BOXES              *
  **************************************************/
@@ -699,6 +1510,9 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
     print_debug_top_down_mapinfo("%d", gNumCalls.floor);
     print_debug_top_down_mapinfo("%d", gNumCalls.wall);
     print_debug_top_down_mapinfo("%d", gNumCalls.ceil);
+#ifndef TARGET_N64
+    print_debug_top_down_mapinfo("%d", gNumCalls.ray);
+#endif
 
     set_text_array_x_y(-80, 0);
 
@@ -706,10 +1520,23 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
     print_debug_top_down_mapinfo("listal %d", gSurfaceNodesAllocated);
     print_debug_top_down_mapinfo("statbg %d", gNumStaticSurfaces);
     print_debug_top_down_mapinfo("movebg %d", gSurfacesAllocated - gNumStaticSurfaces);
+#ifdef USE_SYSTEM_MALLOC
+    print_debug_top_down_mapinfo("rebuilt %d", gDynamicSurfacesRebuilt);
+    print_debug_top_down_mapinfo("reused %d", gDynamicSurfacesReused);
+#ifdef FLOOR_QUERY_CACHE
+    print_debug_top_down_mapinfo("bghit %d", gFloorQueryCacheHits);
+    print_debug_top_down_mapinfo("bgmiss %d", gFloorQueryCacheMisses);
+    gFloorQueryCacheHits = 0;
+    gFloorQueryCacheMisses = 0;
+#endif
+#endif
 
     gNumCalls.floor = 0;
     gNumCalls.ceil = 0;
     gNumCalls.wall = 0;
+#ifndef TARGET_N64
+    gNumCalls.ray = 0;
+#endif
 }
 
 /**
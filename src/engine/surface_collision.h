@@ -34,6 +34,22 @@ struct FloorGeometry
     f32 originOffset;
 };
 
+#ifndef TARGET_N64
+// Surface lists a raycast tests.
+#define RAYCAST_FLOORS (1 << 0)
+#define RAYCAST_CEILS  (1 << 1)
+#define RAYCAST_WALLS  (1 << 2)
+#define RAYCAST_ALL    (RAYCAST_FLOORS | RAYCAST_CEILS | RAYCAST_WALLS)
+
+struct RaycastHit
+{
+    struct Surface *surface;
+    f32 dist;
+    Vec3f pos;
+    Vec3f normal;
+};
+#endif
+
 s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 radius);
 s32 find_wall_collisions(struct WallCollisionData *colData);
 f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil);
@@ -42,6 +58,15 @@ f32 find_floor_height(f32 x, f32 y, f32 z);
 f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor);
 f32 find_water_level(f32 x, f32 z);
 f32 find_poison_gas_level(f32 x, f32 z);
+#ifndef TARGET_N64
+s32 raycast(Vec3f origin, Vec3f dir, f32 maxDist, s32 flags, struct RaycastHit *hit);
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(FLOOR_QUERY_CACHE)
+extern s32 gFloorQueryCacheHits;
+extern s32 gFloorQueryCacheMisses;
+
+void clear_floor_query_cache(void);
+#endif
 void debug_surface_list_info(f32 xPos, f32 zPos);
 
 #endif // SURFACE_COLLISION_H
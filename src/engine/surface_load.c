@@ -1,10 +1,16 @@
 #include <PR/ultratypes.h>
+#ifdef USE_SYSTEM_MALLOC
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
 
 #include "prevent_bss_reordering.h"
 
 #include "sm64.h"
 #include "game/ingame_menu.h"
 #include "graph_node.h"
+#include "math_util.h"
 #include "behavior_script.h"
 #include "behavior_data.h"
 #include "game/memory.h"
@@ -14,6 +20,12 @@
 #include "game/mario.h"
 #include "game/object_list_processor.h"
 #include "surface_load.h"
+#ifdef USE_SYSTEM_MALLOC
+#include "../pc/collision_cache.h"
+#ifdef COLLISION_PROFILER
+#include "../pc/collision_profiler.h"
+#endif
+#endif
 
 s32 unused8038BE90;
 
@@ -32,7 +44,48 @@ static struct AllocOnlyPool *sStaticSurfaceNodePool;
 static struct AllocOnlyPool *sStaticSurfacePool;
 static struct AllocOnlyPool *sDynamicSurfaceNodePool;
 static struct AllocOnlyPool *sDynamicSurfacePool;
+static struct AllocOnlyPool *sStaticPackedPool;
 static u8 sStaticSurfaceLoadComplete;
+
+PackedPartitionCell gStaticPackedPartition[NUM_CELLS][NUM_CELLS];
+
+/**
+ * An object surface kept between frames, along with the nodes and cell range it is linked in.
+ * The surface is the first member, so the partition's nodes can point straight at it.
+ */
+struct DynamicSurface
+{
+    struct Surface surface;
+    struct DynamicSurface *next;
+    struct DynamicSurfaceNode *nodes;
+    s16 index;
+    s16 minCellX, maxCellX;
+    s16 minCellZ, maxCellZ;
+    s16 listIndex;
+    s16 priority;
+    u8 computed;
+    u8 loaded;
+};
+
+#define DYNAMIC_RECORD_TABLE_BITS 10
+#define DYNAMIC_RECORD_TABLE_SIZE (1 << DYNAMIC_RECORD_TABLE_BITS)
+
+// Load orders are renumbered before they can wrap around.
+#define DYNAMIC_LOAD_ORDER_LIMIT 0xF0000000
+
+static struct DynamicSurfaceRecord *sDynamicRecordTable[DYNAMIC_RECORD_TABLE_SIZE];
+static s32 sNumDynamicRecords;
+static struct DynamicSurfaceRecord *sDynamicRecords;
+static struct DynamicSurfaceRecord *sTransientDynamicRecords;
+static struct DynamicSurfaceRecord *sFreeDynamicRecords;
+static struct DynamicSurface *sFreeDynamicSurfaces;
+static struct DynamicSurfaceNode *sFreeDynamicNodes;
+static u32 sNextLoadOrder;
+static u32 sPrevLoadOrder;
+
+u32 gDynamicSurfaceFrame;
+s32 gDynamicSurfacesRebuilt;
+s32 gDynamicSurfacesReused;
 #else
 struct SurfaceNode *sSurfaceNodePool;
 struct Surface *sSurfacePool;
@@ -130,35 +183,47 @@ static void clear_static_surfaces(void) {
 }
 
 /**
- * Add a surface to the correct cell list of surfaces.
- * @param dynamic Determines whether the surface is static or dynamic
- * @param cellX The X position of the cell in which the surface resides
- * @param cellZ The Z position of the cell in which the surface resides
- * @param surface The surface to add
+ * Determine which cell list a surface belongs in and the direction that list is sorted in.
+ * Walls are flagged for projection onto the yz plane when they face mostly along x.
  */
-static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surface *surface) {
-    struct SurfaceNode *newNode = alloc_surface_node();
-    struct SurfaceNode *list;
-    s16 surfacePriority;
-    s16 priority;
-    s16 sortDir;
+static s16 classify_surface(struct Surface *surface, s16 *sortDir) {
     s16 listIndex;
 
     if (surface->normal.y > 0.01) {
         listIndex = SPATIAL_PARTITION_FLOORS;
-        sortDir = 1; // highest to lowest, then insertion order
+        *sortDir = 1; // highest to lowest, then insertion order
     } else if (surface->normal.y < -0.01) {
         listIndex = SPATIAL_PARTITION_CEILS;
-        sortDir = -1; // lowest to highest, then insertion order
+        *sortDir = -1; // lowest to highest, then insertion order
     } else {
         listIndex = SPATIAL_PARTITION_WALLS;
-        sortDir = 0; // insertion order
+        *sortDir = 0; // insertion order
 
         if (surface->normal.x < -0.707 || surface->normal.x > 0.707) {
             surface->flags |= SURFACE_FLAG_X_PROJECTION;
         }
     }
 
+    return listIndex;
+}
+
+/**
+ * Add a surface to the correct cell list of surfaces.
+ * @param dynamic Determines whether the surface is static or dynamic
+ * @param cellX The X position of the cell in which the surface resides
+ * @param cellZ The Z position of the cell in which the surface resides
+ * @param surface The surface to add
+ */
+static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surface *surface) {
+    struct SurfaceNode *newNode = alloc_surface_node();
+    struct SurfaceNode *list;
+    s16 surfacePriority;
+    s16 priority;
+    s16 sortDir;
+    s16 listIndex;
+
+    listIndex = classify_surface(surface, &sortDir);
+
     //! (Surface Cucking) Surfaces are sorted by the height of their first
     //  vertex. Since vertices aren't ordered by height, this causes many
     //  lower triangles to be sorted higher. This worsens surface cucking since
@@ -284,6 +349,422 @@ static s16 upper_cell_index(s32 coord) {
     return index;
 }
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * The static partition is built in bulk once the level's surfaces are all read. Each surface
+ * is queued with the cells it covers, then every cell list is laid out contiguously in one
+ * node arena and sorted once, instead of walking the list on every insertion.
+ */
+struct StaticSurfaceEntry
+{
+    struct Surface *surface;
+    s16 minCellX, maxCellX;
+    s16 minCellZ, maxCellZ;
+    s16 listIndex;
+    s16 priority;
+};
+
+struct StaticSurfaceKey
+{
+    s32 entry;
+    s16 priority;
+};
+
+static struct StaticSurfaceEntry *sStaticSurfaceEntries;
+static s32 sNumStaticSurfaceEntries;
+static s32 sStaticSurfaceEntryCapacity;
+static struct StaticSurfaceKey *sStaticSurfaceKeys;
+static s32 sStaticSurfaceKeyCapacity;
+static s32 sStaticCellListStart[NUM_CELLS][NUM_CELLS][3];
+static struct SurfaceNode *sStaticSurfaceNodes;
+
+/**
+ * Queue a static surface to be added to the cells in the given range.
+ */
+static void queue_static_surface(struct Surface *surface, s16 minCellX, s16 maxCellX, s16 minCellZ,
+                                 s16 maxCellZ) {
+    struct StaticSurfaceEntry *entry;
+    s16 sortDir;
+    s16 cellX, cellZ;
+
+    // add_surface_to_cell only classifies the surface if it lands in at least one cell.
+    if (minCellX > maxCellX || minCellZ > maxCellZ) {
+        return;
+    }
+
+    if (sNumStaticSurfaceEntries == sStaticSurfaceEntryCapacity) {
+        sStaticSurfaceEntryCapacity = sStaticSurfaceEntryCapacity != 0 ? sStaticSurfaceEntryCapacity * 2 : 1024;
+        sStaticSurfaceEntries = realloc(sStaticSurfaceEntries,
+                                        sStaticSurfaceEntryCapacity * sizeof(struct StaticSurfaceEntry));
+        if (sStaticSurfaceEntries == NULL) {
+            abort();
+        }
+    }
+
+    entry = &sStaticSurfaceEntries[sNumStaticSurfaceEntries++];
+    entry->surface = surface;
+    entry->minCellX = minCellX;
+    entry->maxCellX = maxCellX;
+    entry->minCellZ = minCellZ;
+    entry->maxCellZ = maxCellZ;
+    entry->listIndex = classify_surface(surface, &sortDir);
+    entry->priority = surface->vertex1[1] * sortDir;
+
+    for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
+        for (cellX = minCellX; cellX <= maxCellX; cellX++) {
+            sStaticCellListStart[cellZ][cellX][entry->listIndex]++;
+        }
+    }
+}
+
+/**
+ * Stable merge sort of a cell list's keys, highest priority first. Equal priorities keep
+ * their queue order, which is the order add_surface_to_cell would have left them in.
+ */
+static void sort_static_surface_keys(struct StaticSurfaceKey *keys, struct StaticSurfaceKey *temp, s32 count) {
+    s32 half = count / 2;
+    s32 i = 0;
+    s32 j = half;
+    s32 k = 0;
+
+    if (count < 2) {
+        return;
+    }
+
+    sort_static_surface_keys(keys, temp, half);
+    sort_static_surface_keys(keys + half, temp, count - half);
+
+    if (keys[half - 1].priority >= keys[half].priority) {
+        return;
+    }
+
+    while (i < half && j < count) {
+        if (keys[j].priority > keys[i].priority) {
+            temp[k++] = keys[j++];
+        } else {
+            temp[k++] = keys[i++];
+        }
+    }
+    while (i < half) {
+        temp[k++] = keys[i++];
+    }
+    while (j < count) {
+        temp[k++] = keys[j++];
+    }
+
+    memcpy(keys, temp, count * sizeof(struct StaticSurfaceKey));
+}
+
+/**
+ * Lay out the queued static surfaces in the partition.
+ */
+static void build_static_partition(void) {
+    struct StaticSurfaceEntry *entry;
+    struct SurfaceNode *nodes;
+    s32 numNodes = 0;
+    s32 start, count, i;
+    s16 cellZ, cellX, listIndex;
+
+    // Turn the per-list counts into each list's start in the arena.
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                count = sStaticCellListStart[cellZ][cellX][listIndex];
+                sStaticCellListStart[cellZ][cellX][listIndex] = numNodes;
+                numNodes += count;
+            }
+        }
+    }
+
+    if (numNodes == 0) {
+        return;
+    }
+
+    // Twice the nodes, as the second half is the merge sort's scratch space.
+    if (2 * numNodes > sStaticSurfaceKeyCapacity) {
+        sStaticSurfaceKeyCapacity = 2 * numNodes;
+        free(sStaticSurfaceKeys);
+        sStaticSurfaceKeys = malloc(sStaticSurfaceKeyCapacity * sizeof(struct StaticSurfaceKey));
+        if (sStaticSurfaceKeys == NULL) {
+            abort();
+        }
+    }
+
+    // Fill each list in queue order, leaving each start at the end of its list.
+    for (entry = sStaticSurfaceEntries; entry < sStaticSurfaceEntries + sNumStaticSurfaceEntries; entry++) {
+        for (cellZ = entry->minCellZ; cellZ <= entry->maxCellZ; cellZ++) {
+            for (cellX = entry->minCellX; cellX <= entry->maxCellX; cellX++) {
+                i = sStaticCellListStart[cellZ][cellX][entry->listIndex]++;
+                sStaticSurfaceKeys[i].entry = entry - sStaticSurfaceEntries;
+                sStaticSurfaceKeys[i].priority = entry->priority;
+            }
+        }
+    }
+
+    nodes = alloc_only_pool_alloc(sStaticSurfaceNodePool, numNodes * sizeof(struct SurfaceNode));
+    sStaticSurfaceNodes = nodes;
+
+    start = 0;
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                count = sStaticCellListStart[cellZ][cellX][listIndex] - start;
+                if (count == 0) {
+                    continue;
+                }
+
+                // Walls are only in insertion order.
+                if (listIndex != SPATIAL_PARTITION_WALLS) {
+                    sort_static_surface_keys(sStaticSurfaceKeys + start, sStaticSurfaceKeys + numNodes, count);
+                }
+
+                for (i = start; i < start + count; i++) {
+                    nodes[i].surface = sStaticSurfaceEntries[sStaticSurfaceKeys[i].entry].surface;
+                    nodes[i].next = &nodes[i + 1];
+                }
+                nodes[start + count - 1].next = NULL;
+                gStaticSurfacePartition[cellZ][cellX][listIndex].next = &nodes[start];
+
+                start += count;
+            }
+        }
+    }
+
+    gSurfaceNodesAllocated += numNodes;
+}
+
+/**
+ * The finished static partition is cached in a file, so that later loads of the same area can
+ * map it instead of reading and sorting every surface again. The blob holds the queued surfaces
+ * and the node arena as build_static_partition laid them out, with every pointer stored as an
+ * offset from the start of the blob. The offsets are fixed up in place once it is mapped.
+ */
+#define STATIC_PARTITION_MAGIC 0x53505031 // "SPP1"
+#define STATIC_PARTITION_VERSION 1
+
+// Surface data depends on how this file was compiled, so a rebuild gets its own cache files.
+#define STATIC_PARTITION_BUILD __DATE__ " " __TIME__
+
+#define ALIGN16(val) (((val) + 0xF) & ~0xF)
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+struct StaticPartitionHeader
+{
+    u32 magic;
+    u32 version;
+    u64 key;
+    u64 roomsHash;
+    u32 surfaceSize;
+    u32 nodeSize;
+    s32 numTerrainSurfaces;
+    s32 numSurfacesAllocated;
+    s32 numSurfaces;
+    s32 numNodes;
+    u32 surfacesOffset;
+    u32 nodesOffset;
+    u32 lists[NUM_CELLS][NUM_CELLS][3];
+};
+
+static u8 *sStaticPartitionBlob;
+static size_t sStaticPartitionBlobSize;
+static u64 sStaticPartitionKey;
+
+static u64 hash_bytes(u64 hash, const void *data, size_t size) {
+    const u8 *bytes = data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Hash the rooms of the area's surfaces, or return 0 if it has none.
+ */
+static u64 hash_surface_rooms(s8 *surfaceRooms, s32 numTerrainSurfaces) {
+    if (surfaceRooms == NULL) {
+        return 0;
+    }
+    return hash_bytes(FNV_OFFSET_BASIS, surfaceRooms, numTerrainSurfaces);
+}
+
+static void release_static_partition_blob(void) {
+    if (sStaticPartitionBlob != NULL) {
+        collision_cache_unmap(sStaticPartitionBlob, sStaticPartitionBlobSize);
+        sStaticPartitionBlob = NULL;
+    }
+}
+
+/**
+ * Turn a blob offset into a node pointer, checking that it points at a node in the arena.
+ * Nodes only ever point forward, which also rules out cycles in a damaged file.
+ */
+static s32 fix_up_node_offset(struct StaticPartitionHeader *header, struct SurfaceNode **node, u32 after) {
+    u32 offset = (u32) (uintptr_t) *node;
+
+    if (offset == 0) {
+        return TRUE;
+    }
+    if (offset < header->nodesOffset || offset <= after
+        || (offset - header->nodesOffset) % sizeof(struct SurfaceNode) != 0
+        || (offset - header->nodesOffset) / sizeof(struct SurfaceNode) >= (u32) header->numNodes) {
+        return FALSE;
+    }
+    *node = (struct SurfaceNode *) (sStaticPartitionBlob + offset);
+    return TRUE;
+}
+
+/**
+ * Look for a cached partition of the given terrain and link it in. Returns FALSE if there is
+ * none or it doesn't match, in which case the partition has to be built.
+ */
+static s32 map_static_partition(s16 *data, s8 *surfaceRooms) {
+    struct StaticPartitionHeader *header;
+    struct SurfaceNode *nodes;
+    u64 surfacesEnd, nodesEnd;
+    u32 offset;
+    s32 i;
+    s16 cellZ, cellX, listIndex;
+
+    sStaticPartitionKey = hash_bytes(FNV_OFFSET_BASIS, STATIC_PARTITION_BUILD, sizeof(STATIC_PARTITION_BUILD));
+    sStaticPartitionKey = hash_bytes(sStaticPartitionKey, data, get_area_terrain_size(data) * sizeof(s16));
+
+    sStaticPartitionBlob = collision_cache_map(sStaticPartitionKey, &sStaticPartitionBlobSize);
+    if (sStaticPartitionBlob == NULL) {
+        return FALSE;
+    }
+
+    header = (struct StaticPartitionHeader *) sStaticPartitionBlob;
+    if (sStaticPartitionBlobSize < sizeof(struct StaticPartitionHeader)
+        || header->magic != STATIC_PARTITION_MAGIC || header->version != STATIC_PARTITION_VERSION
+        || header->key != sStaticPartitionKey || header->surfaceSize != sizeof(struct Surface)
+        || header->nodeSize != sizeof(struct SurfaceNode) || header->numSurfaces < 0 || header->numNodes < 0
+        || header->surfacesOffset % 16 != 0 || header->nodesOffset % 16 != 0) {
+        goto invalid;
+    }
+
+    surfacesEnd = header->surfacesOffset + (u64) header->numSurfaces * sizeof(struct Surface);
+    nodesEnd = header->nodesOffset + (u64) header->numNodes * sizeof(struct SurfaceNode);
+    if (header->surfacesOffset < sizeof(struct StaticPartitionHeader) || surfacesEnd > header->nodesOffset
+        || nodesEnd > sStaticPartitionBlobSize) {
+        goto invalid;
+    }
+
+    // Only hash the rooms once the surface count is known to be sane.
+    if (header->numTerrainSurfaces < 0
+        || header->roomsHash != hash_surface_rooms(surfaceRooms, header->numTerrainSurfaces)) {
+        goto invalid;
+    }
+
+    nodes = (struct SurfaceNode *) (sStaticPartitionBlob + header->nodesOffset);
+    for (i = 0; i < header->numNodes; i++) {
+        offset = (u32) (uintptr_t) nodes[i].surface;
+        if (offset < header->surfacesOffset || offset >= surfacesEnd
+            || (offset - header->surfacesOffset) % sizeof(struct Surface) != 0) {
+            goto invalid;
+        }
+        nodes[i].surface = (struct Surface *) (sStaticPartitionBlob + offset);
+
+        if (!fix_up_node_offset(header, &nodes[i].next, header->nodesOffset + i * sizeof(struct SurfaceNode))) {
+            goto invalid;
+        }
+    }
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                gStaticSurfacePartition[cellZ][cellX][listIndex].next =
+                    (struct SurfaceNode *) (uintptr_t) header->lists[cellZ][cellX][listIndex];
+                if (!fix_up_node_offset(header, &gStaticSurfacePartition[cellZ][cellX][listIndex].next, 0)) {
+                    clear_static_surfaces();
+                    goto invalid;
+                }
+            }
+        }
+    }
+
+    gSurfacesAllocated = header->numSurfacesAllocated;
+    gSurfaceNodesAllocated = header->numNodes;
+    return TRUE;
+
+invalid:
+    release_static_partition_blob();
+    return FALSE;
+}
+
+/**
+ * Write the partition that was just built to the cache.
+ */
+static void store_static_partition(s8 *surfaceRooms, s32 numTerrainSurfaces) {
+    struct StaticPartitionHeader *header;
+    struct SurfaceNode *nodes;
+    struct SurfaceNode *head;
+    struct Surface *surfaces;
+    s32 numNodes = gSurfaceNodesAllocated;
+    size_t size;
+    u8 *blob;
+    s32 i;
+    s16 cellZ, cellX, listIndex;
+
+    size = ALIGN16(sizeof(struct StaticPartitionHeader))
+           + ALIGN16(sNumStaticSurfaceEntries * sizeof(struct Surface))
+           + numNodes * sizeof(struct SurfaceNode);
+    blob = calloc(1, size);
+    if (blob == NULL) {
+        return;
+    }
+
+    header = (struct StaticPartitionHeader *) blob;
+    header->magic = STATIC_PARTITION_MAGIC;
+    header->version = STATIC_PARTITION_VERSION;
+    header->key = sStaticPartitionKey;
+    header->roomsHash = hash_surface_rooms(surfaceRooms, numTerrainSurfaces);
+    header->surfaceSize = sizeof(struct Surface);
+    header->nodeSize = sizeof(struct SurfaceNode);
+    header->numTerrainSurfaces = numTerrainSurfaces;
+    header->numSurfacesAllocated = gSurfacesAllocated;
+    header->numSurfaces = sNumStaticSurfaceEntries;
+    header->numNodes = numNodes;
+    header->surfacesOffset = ALIGN16(sizeof(struct StaticPartitionHeader));
+    header->nodesOffset = header->surfacesOffset + ALIGN16(sNumStaticSurfaceEntries * sizeof(struct Surface));
+
+    surfaces = (struct Surface *) (blob + header->surfacesOffset);
+    for (i = 0; i < sNumStaticSurfaceEntries; i++) {
+        surfaces[i] = *sStaticSurfaceEntries[i].surface;
+        surfaces[i].object = NULL;
+    }
+
+    // The arena's nodes still line up with the sorted keys.
+    nodes = (struct SurfaceNode *) (blob + header->nodesOffset);
+    for (i = 0; i < numNodes; i++) {
+        nodes[i].surface = (struct Surface *) (uintptr_t) (header->surfacesOffset
+                                                            + sStaticSurfaceKeys[i].entry * sizeof(struct Surface));
+        if (sStaticSurfaceNodes[i].next != NULL) {
+            nodes[i].next = (struct SurfaceNode *) (uintptr_t) (header->nodesOffset
+                                                                 + (i + 1) * sizeof(struct SurfaceNode));
+        }
+    }
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                head = gStaticSurfacePartition[cellZ][cellX][listIndex].next;
+                if (head != NULL) {
+                    header->lists[cellZ][cellX][listIndex] =
+                        header->nodesOffset + (head - sStaticSurfaceNodes) * sizeof(struct SurfaceNode);
+                }
+            }
+        }
+    }
+
+    collision_cache_store(sStaticPartitionKey, blob, size);
+    free(blob);
+}
+#endif
+
 /**
  * Every level is split into 16x16 cells, this takes a surface, finds
  * the appropriate cells (with a buffer), and adds the surface to those
@@ -312,6 +793,13 @@ static void add_surface(struct Surface *surface, s32 dynamic) {
     minCellZ = lower_cell_index(minZ);
     maxCellZ = upper_cell_index(maxZ);
 
+#ifdef USE_SYSTEM_MALLOC
+    if (!dynamic) {
+        queue_static_surface(surface, minCellX, maxCellX, minCellZ, maxCellZ);
+        return;
+    }
+#endif
+
     for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
         for (cellX = minCellX; cellX <= maxCellX; cellX++) {
             add_surface_to_cell(dynamic, cellX, cellZ, surface);
@@ -323,12 +811,13 @@ UNUSED static void stub_surface_load_1(void) {
 }
 
 /**
- * Initializes a Surface struct using the given vertex data
+ * Fills in a Surface struct using the given vertex data. The type, force, flags, room and
+ * object are cleared. Returns FALSE without touching the surface if the triangle is degenerate.
+ * @param surface The surface to fill in
  * @param vertexData The raw data containing vertex positions
- * @param vertexIndices Helper which tells positions in vertexData to start reading vertices
+ * @param vertexIndices The indices of the triangle's three vertices in vertexData
  */
-static struct Surface *read_surface_data(s16 *vertexData, s16 **vertexIndices) {
-    struct Surface *surface;
+static s32 compute_surface_data(struct Surface *surface, s16 *vertexData, s16 *vertexIndices) {
     register s32 x1, y1, z1;
     register s32 x2, y2, z2;
     register s32 x3, y3, z3;
@@ -337,9 +826,9 @@ static struct Surface *read_surface_data(s16 *vertexData, s16 **vertexIndices) {
     f32 mag;
     s16 offset1, offset2, offset3;
 
-    offset1 = 3 * (*vertexIndices)[0];
-    offset2 = 3 * (*vertexIndices)[1];
-    offset3 = 3 * (*vertexIndices)[2];
+    offset1 = 3 * vertexIndices[0];
+    offset2 = 3 * vertexIndices[1];
+    offset3 = 3 * vertexIndices[2];
 
     x1 = *(vertexData + offset1 + 0);
     y1 = *(vertexData + offset1 + 1);
@@ -378,14 +867,18 @@ static struct Surface *read_surface_data(s16 *vertexData, s16 **vertexIndices) {
 
     // Checking to make sure no DIV/0
     if (mag < 0.0001) {
-        return NULL;
+        return FALSE;
     }
     mag = (f32)(1.0 / mag);
     nx *= mag;
     ny *= mag;
     nz *= mag;
 
-    surface = alloc_surface();
+    surface->type = 0;
+    surface->force = 0;
+    surface->flags = 0;
+    surface->room = 0;
+    surface->object = NULL;
 
     surface->vertex1[0] = x1;
     surface->vertex2[0] = x2;
@@ -408,6 +901,25 @@ static struct Surface *read_surface_data(s16 *vertexData, s16 **vertexIndices) {
     surface->lowerY = minY - 5;
     surface->upperY = maxY + 5;
 
+    return TRUE;
+}
+
+/**
+ * Initializes a Surface struct using the given vertex data
+ * @param vertexData The raw data containing vertex positions
+ * @param vertexIndices Helper which tells positions in vertexData to start reading vertices
+ */
+static struct Surface *read_surface_data(s16 *vertexData, s16 **vertexIndices) {
+    struct Surface data;
+    struct Surface *surface;
+
+    if (!compute_surface_data(&data, vertexData, *vertexIndices)) {
+        return NULL;
+    }
+
+    surface = alloc_surface();
+    *surface = data;
+
     return surface;
 }
 
@@ -472,6 +984,17 @@ static void load_static_surfaces(s16 **data, s16 *vertexData, s16 surfaceType, s
     numSurfaces = *(*data);
     *data += 1;
 
+#ifdef USE_SYSTEM_MALLOC
+    // The partition came from the cache, only the rest of the terrain data is needed.
+    if (sStaticPartitionBlob != NULL) {
+        *data += (3 + hasForce) * numSurfaces;
+        if (*surfaceRooms != NULL) {
+            *surfaceRooms += numSurfaces;
+        }
+        return;
+    }
+#endif
+
     for (i = 0; i < numSurfaces; i++) {
         if (*surfaceRooms != NULL) {
             room = *(*surfaceRooms);
@@ -548,6 +1071,714 @@ static void load_environmental_regions(s16 **data) {
     }
 }
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Allocate the surface array of a packed list, padded to a multiple of PACKED_SURFACE_LANES.
+ */
+static struct Surface **alloc_packed_surfaces(s32 count) {
+    s32 size = (count + PACKED_SURFACE_LANES - 1) & ~(PACKED_SURFACE_LANES - 1);
+
+    return alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(struct Surface *));
+}
+
+/**
+ * Copy an array of surfaces into parallel arrays, keeping their order. Padding entries are
+ * zeroed and never reported as hits since the queries mask off lanes past the count.
+ */
+static void pack_surface_array(struct PackedSurfaceList *packed, struct Surface **surfaces, s32 count) {
+    struct Surface *surf;
+    s32 size;
+    s32 i;
+
+    packed->count = count;
+    if (count == 0) {
+        bzero(packed, sizeof(struct PackedSurfaceList));
+        return;
+    }
+
+    size = (count + PACKED_SURFACE_LANES - 1) & ~(PACKED_SURFACE_LANES - 1);
+
+    packed->surfaces = surfaces;
+    packed->x1 = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s32));
+    packed->z1 = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s32));
+    packed->x2 = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s32));
+    packed->z2 = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s32));
+    packed->x3 = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s32));
+    packed->z3 = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s32));
+    packed->lowerY = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->upperY = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->normalX = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->normalY = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->normalZ = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->originOffset = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->type = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s16));
+    packed->flags = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(s8));
+
+    for (i = 0; i < size; i++) {
+        if (i < count) {
+            surf = surfaces[i];
+
+            packed->x1[i] = surf->vertex1[0];
+            packed->z1[i] = surf->vertex1[2];
+            packed->x2[i] = surf->vertex2[0];
+            packed->z2[i] = surf->vertex2[2];
+            packed->x3[i] = surf->vertex3[0];
+            packed->z3[i] = surf->vertex3[2];
+            packed->lowerY[i] = surf->lowerY;
+            packed->upperY[i] = surf->upperY;
+            packed->normalX[i] = surf->normal.x;
+            packed->normalY[i] = surf->normal.y;
+            packed->normalZ[i] = surf->normal.z;
+            packed->originOffset[i] = surf->originOffset;
+            packed->type[i] = surf->type;
+            packed->flags[i] = surf->flags;
+        } else {
+            packed->surfaces[i] = NULL;
+            packed->x1[i] = packed->z1[i] = 0;
+            packed->x2[i] = packed->z2[i] = 0;
+            packed->x3[i] = packed->z3[i] = 0;
+            packed->lowerY[i] = packed->upperY[i] = 0.0f;
+            packed->normalX[i] = packed->normalY[i] = packed->normalZ[i] = 0.0f;
+            packed->originOffset[i] = 0.0f;
+            packed->type[i] = 0;
+            packed->flags[i] = 0;
+        }
+    }
+}
+
+/**
+ * Add the xz bounds of each surface to a packed wall list.
+ */
+static void pack_wall_extents(struct PackedSurfaceList *packed) {
+    struct Surface *surf;
+    s32 size;
+    s32 i;
+
+    if (packed->count == 0) {
+        return;
+    }
+
+    size = (packed->count + PACKED_SURFACE_LANES - 1) & ~(PACKED_SURFACE_LANES - 1);
+
+    packed->minX = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->maxX = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->minZ = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+    packed->maxZ = alloc_only_pool_alloc(sStaticPackedPool, size * sizeof(f32));
+
+    for (i = 0; i < size; i++) {
+        if (i < packed->count) {
+            surf = packed->surfaces[i];
+
+            packed->minX[i] = min_3(surf->vertex1[0], surf->vertex2[0], surf->vertex3[0]);
+            packed->maxX[i] = max_3(surf->vertex1[0], surf->vertex2[0], surf->vertex3[0]);
+            packed->minZ[i] = min_3(surf->vertex1[2], surf->vertex2[2], surf->vertex3[2]);
+            packed->maxZ[i] = max_3(surf->vertex1[2], surf->vertex2[2], surf->vertex3[2]);
+        } else {
+            packed->minX[i] = packed->maxX[i] = 0.0f;
+            packed->minZ[i] = packed->maxZ[i] = 0.0f;
+        }
+    }
+}
+
+/**
+ * Copy a surface list into parallel arrays, keeping the list order.
+ */
+static void pack_surface_list(struct PackedSurfaceList *packed, struct SurfaceNode *node) {
+    struct Surface **surfaces;
+    struct SurfaceNode *list;
+    s32 count = 0;
+    s32 i;
+
+    for (list = node; list != NULL; list = list->next) {
+        count++;
+    }
+
+    surfaces = NULL;
+    if (count != 0) {
+        surfaces = alloc_packed_surfaces(count);
+        for (i = 0; i < count; i++) {
+            surfaces[i] = node->surface;
+            node = node->next;
+        }
+    }
+
+    pack_surface_array(packed, surfaces, count);
+}
+
+#if STATIC_PARTITION_MODE == 1
+// Lists longer than this are split into quarters, down to squares of STATIC_TREE_MIN_SIZE units.
+#define STATIC_TREE_SPLIT_COUNT 16
+#define STATIC_TREE_MIN_SIZE    64
+// How many of the quarters a node's surfaces may be in on average for the split to be worth it.
+#define STATIC_TREE_MAX_COPIES  1.5f
+
+struct PackedSurfaceTree *gStaticPackedTrees[NUM_CELLS][NUM_CELLS][2];
+
+/**
+ * Whether a surface can be found by a floor or ceiling query at some point of the square.
+ * The lateral triangle test only passes inside the surface's bounds, unless its products
+ * overflow, so a surface that spans too far from the square is always kept.
+ */
+static s32 surface_touches_square(struct Surface *surf, s32 minX, s32 minZ, s32 size) {
+    s32 surfMinX = min_3(surf->vertex1[0], surf->vertex2[0], surf->vertex3[0]);
+    s32 surfMaxX = max_3(surf->vertex1[0], surf->vertex2[0], surf->vertex3[0]);
+    s32 surfMinZ = min_3(surf->vertex1[2], surf->vertex2[2], surf->vertex3[2]);
+    s32 surfMaxZ = max_3(surf->vertex1[2], surf->vertex2[2], surf->vertex3[2]);
+    s32 maxX = minX + size - 1;
+    s32 maxZ = minZ + size - 1;
+    s64 spanX = max(surfMaxX, maxX) - min(surfMinX, minX);
+    s64 spanZ = max(surfMaxZ, maxZ) - min(surfMinZ, minZ);
+
+    if (spanX * spanZ >= (1 << 30)) {
+        return TRUE;
+    }
+    return surfMinX <= maxX && surfMaxX >= minX && surfMinZ <= maxZ && surfMaxZ >= minZ;
+}
+
+/**
+ * Split a tree node's square into quarters, each with the surfaces of the node that touch it.
+ * A split is only kept while the surfaces mostly fall into a single quarter, so the lists get
+ * shorter instead of just being copied.
+ */
+static void split_packed_tree(struct PackedSurfaceTree *tree, s32 minX, s32 minZ, s32 size) {
+    struct PackedSurfaceList *list = &tree->list;
+    struct PackedSurfaceTree *child;
+    struct Surface **surfaces;
+    s32 half = size / 2;
+    s32 counts[4];
+    s32 total = 0;
+    s32 i, k, n;
+
+    if (list->count <= STATIC_TREE_SPLIT_COUNT || size <= STATIC_TREE_MIN_SIZE) {
+        return;
+    }
+
+    for (k = 0; k < 4; k++) {
+        counts[k] = 0;
+        for (i = 0; i < list->count; i++) {
+            if (surface_touches_square(list->surfaces[i], minX + (k & 1) * half, minZ + (k >> 1) * half, half)) {
+                counts[k]++;
+            }
+        }
+        total += counts[k];
+    }
+
+    if (total > STATIC_TREE_MAX_COPIES * list->count) {
+        return;
+    }
+
+    tree->children = alloc_only_pool_alloc(sStaticPackedPool, 4 * sizeof(struct PackedSurfaceTree));
+    for (k = 0; k < 4; k++) {
+        child = &tree->children[k];
+        child->children = NULL;
+
+        surfaces = NULL;
+        if (counts[k] != 0) {
+            surfaces = alloc_packed_surfaces(counts[k]);
+            n = 0;
+            for (i = 0; i < list->count; i++) {
+                if (surface_touches_square(list->surfaces[i], minX + (k & 1) * half, minZ + (k >> 1) * half,
+                                           half)) {
+                    surfaces[n++] = list->surfaces[i];
+                }
+            }
+        }
+
+        pack_surface_array(&child->list, surfaces, counts[k]);
+        split_packed_tree(child, minX + (k & 1) * half, minZ + (k >> 1) * half, half);
+    }
+}
+
+/**
+ * Build quadtrees over the crowded floor and ceiling cells. Walls are left alone, since wall
+ * collisions reach out by a radius that isn't known in advance.
+ */
+static void build_static_packed_trees(void) {
+    struct PackedSurfaceTree *tree;
+    s32 cellZ, cellX, listIndex;
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = SPATIAL_PARTITION_FLOORS; listIndex <= SPATIAL_PARTITION_CEILS; listIndex++) {
+                gStaticPackedTrees[cellZ][cellX][listIndex] = NULL;
+                if (gStaticPackedPartition[cellZ][cellX][listIndex].count <= STATIC_TREE_SPLIT_COUNT) {
+                    continue;
+                }
+
+                // The root shares the cell's packed list.
+                tree = alloc_only_pool_alloc(sStaticPackedPool, sizeof(struct PackedSurfaceTree));
+                tree->list = gStaticPackedPartition[cellZ][cellX][listIndex];
+                tree->children = NULL;
+                split_packed_tree(tree, cellX * CELL_SIZE - LEVEL_BOUNDARY_MAX,
+                                  cellZ * CELL_SIZE - LEVEL_BOUNDARY_MAX, CELL_SIZE);
+
+                if (tree->children != NULL) {
+                    gStaticPackedTrees[cellZ][cellX][listIndex] = tree;
+                }
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * Build gStaticPackedPartition from the finished static partition.
+ */
+static void pack_static_surfaces(void) {
+    s32 cellZ, cellX, listIndex;
+
+    alloc_only_pool_clear(sStaticPackedPool);
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                pack_surface_list(&gStaticPackedPartition[cellZ][cellX][listIndex],
+                                  gStaticSurfacePartition[cellZ][cellX][listIndex].next);
+            }
+            pack_wall_extents(&gStaticPackedPartition[cellZ][cellX][SPATIAL_PARTITION_WALLS]);
+        }
+    }
+
+#if STATIC_PARTITION_MODE == 1
+    build_static_packed_trees();
+#endif
+}
+#endif
+
+/**
+ * Build the matrix that the current object's collision is transformed by.
+ */
+static void get_object_collision_matrix(Mat4 m) {
+    Mat4 *objectTransform = &gCurrentObject->transform;
+
+    if (gCurrentObject->header.gfx.throwMatrix == NULL) {
+        gCurrentObject->header.gfx.throwMatrix = objectTransform;
+        obj_build_transform_from_pos_and_angle(gCurrentObject, O_POS_INDEX, O_FACE_ANGLE_INDEX);
+    }
+
+    obj_apply_scale_to_matrix(gCurrentObject, m, *objectTransform);
+}
+
+/**
+ * Rotate and translate collision vertices by the given matrix.
+ */
+static void transform_vertices(s16 *vertices, s32 numVertices, Mat4 m, s16 *vertexData) {
+    register f32 vx, vy, vz;
+
+    // Go through all vertices, rotating and translating them to transform the object.
+    while (numVertices--) {
+        vx = *(vertices++);
+        vy = *(vertices++);
+        vz = *(vertices++);
+
+        //! No bounds check on vertex data
+        *vertexData++ = (s16)(vx * m[0][0] + vy * m[1][0] + vz * m[2][0] + m[3][0]);
+        *vertexData++ = (s16)(vx * m[0][1] + vy * m[1][1] + vz * m[2][1] + m[3][1]);
+        *vertexData++ = (s16)(vx * m[0][2] + vy * m[1][2] + vz * m[2][2] + m[3][2]);
+    }
+}
+
+#ifdef USE_SYSTEM_MALLOC
+static struct DynamicSurfaceNode *alloc_dynamic_node(void) {
+    struct DynamicSurfaceNode *node = sFreeDynamicNodes;
+
+    if (node != NULL) {
+        sFreeDynamicNodes = node->nextInSurface;
+    } else {
+        node = alloc_only_pool_alloc(sDynamicSurfaceNodePool, sizeof(struct DynamicSurfaceNode));
+    }
+
+    return node;
+}
+
+static void free_dynamic_node(struct DynamicSurfaceNode *node) {
+    node->nextInSurface = sFreeDynamicNodes;
+    sFreeDynamicNodes = node;
+}
+
+/**
+ * Insert a node into its cell list. The lists keep the order add_surface_to_cell would have
+ * built them in: by priority, then by the order the objects loaded their collision this
+ * frame, then by the surface's position in the object's collision data.
+ */
+static void link_dynamic_node(struct DynamicSurfaceNode *newNode, s16 listIndex) {
+    struct SurfaceNode *list = &gDynamicSurfacePartition[newNode->cellZ][newNode->cellX][listIndex];
+    struct DynamicSurfaceNode *next;
+
+    while ((next = (struct DynamicSurfaceNode *) list->next) != NULL) {
+        if (newNode->priority > next->priority) {
+            break;
+        }
+        if (newNode->priority == next->priority
+            && (newNode->order < next->order
+                || (newNode->order == next->order && newNode->index < next->index))) {
+            break;
+        }
+        list = list->next;
+    }
+
+    newNode->node.next = list->next;
+    newNode->prev = list;
+    if (next != NULL) {
+        next->prev = &newNode->node;
+    }
+    list->next = &newNode->node;
+}
+
+static void unlink_dynamic_node(struct DynamicSurfaceNode *node) {
+    node->prev->next = node->node.next;
+    if (node->node.next != NULL) {
+        ((struct DynamicSurfaceNode *) node->node.next)->prev = node->prev;
+    }
+}
+
+/**
+ * Link a surface into every cell of its range that is outside of the given old range.
+ */
+static void link_dynamic_surface(struct DynamicSurfaceRecord *record, struct DynamicSurface *dynSurface,
+                                 s16 oldMinCellX, s16 oldMaxCellX, s16 oldMinCellZ, s16 oldMaxCellZ) {
+    struct DynamicSurfaceNode *node;
+    s16 cellX, cellZ;
+
+    for (cellZ = dynSurface->minCellZ; cellZ <= dynSurface->maxCellZ; cellZ++) {
+        for (cellX = dynSurface->minCellX; cellX <= dynSurface->maxCellX; cellX++) {
+            if (cellX >= oldMinCellX && cellX <= oldMaxCellX
+                && cellZ >= oldMinCellZ && cellZ <= oldMaxCellZ) {
+                continue;
+            }
+
+            node = alloc_dynamic_node();
+            node->node.surface = &dynSurface->surface;
+            node->record = record;
+            node->order = record->order;
+            node->priority = dynSurface->priority;
+            node->index = dynSurface->index;
+            node->cellX = cellX;
+            node->cellZ = cellZ;
+            link_dynamic_node(node, dynSurface->listIndex);
+
+            node->nextInSurface = dynSurface->nodes;
+            dynSurface->nodes = node;
+            record->numNodes++;
+        }
+    }
+}
+
+/**
+ * Drop the nodes of a surface that are outside of the given range, or all of them if the
+ * range is empty.
+ */
+static void unlink_dynamic_surface(struct DynamicSurfaceRecord *record, struct DynamicSurface *dynSurface,
+                                   s16 minCellX, s16 maxCellX, s16 minCellZ, s16 maxCellZ) {
+    struct DynamicSurfaceNode **nodeLink = &dynSurface->nodes;
+    struct DynamicSurfaceNode *node;
+
+    while ((node = *nodeLink) != NULL) {
+        if (node->cellX < minCellX || node->cellX > maxCellX
+            || node->cellZ < minCellZ || node->cellZ > maxCellZ) {
+            *nodeLink = node->nextInSurface;
+            unlink_dynamic_node(node);
+            free_dynamic_node(node);
+            record->numNodes--;
+        } else {
+            nodeLink = &node->nextInSurface;
+        }
+    }
+}
+
+/**
+ * Drop all of a record's nodes from the dynamic partition, keeping its surfaces.
+ */
+static void unlink_dynamic_record(struct DynamicSurfaceRecord *record) {
+    struct DynamicSurface *dynSurface;
+
+    for (dynSurface = record->surfaces; dynSurface != NULL; dynSurface = dynSurface->next) {
+        unlink_dynamic_surface(record, dynSurface, 1, 0, 1, 0);
+    }
+    record->linked = FALSE;
+}
+
+/**
+ * Unlink and free all of a record's surfaces.
+ */
+static void free_dynamic_record_surfaces(struct DynamicSurfaceRecord *record) {
+    struct DynamicSurface *dynSurface;
+
+    while ((dynSurface = record->surfaces) != NULL) {
+        record->surfaces = dynSurface->next;
+        unlink_dynamic_surface(record, dynSurface, 1, 0, 1, 0);
+        dynSurface->next = sFreeDynamicSurfaces;
+        sFreeDynamicSurfaces = dynSurface;
+    }
+    record->collisionData = NULL;
+    record->numSurfaces = 0;
+    record->linked = FALSE;
+}
+
+static struct DynamicSurfaceRecord *alloc_dynamic_record(struct Object *obj) {
+    struct DynamicSurfaceRecord *record = sFreeDynamicRecords;
+
+    if (record != NULL) {
+        sFreeDynamicRecords = record->next;
+    } else {
+        record = alloc_only_pool_alloc(sDynamicSurfacePool, sizeof(struct DynamicSurfaceRecord));
+    }
+
+    bzero(record, sizeof(struct DynamicSurfaceRecord));
+    record->object = obj;
+
+    return record;
+}
+
+static u32 dynamic_record_hash(struct Object *obj) {
+    return ((u32)((uintptr_t) obj >> 4) * 0x9E3779B1) >> (32 - DYNAMIC_RECORD_TABLE_BITS);
+}
+
+/**
+ * Find the record for an object's collision, creating it on the object's first load. Objects
+ * are never freed on PC, so a record is kept until the next area load. If the object already
+ * loaded its collision this frame, the original would have added its surfaces a second time,
+ * so a separate record is returned that only lasts until the next frame.
+ */
+static struct DynamicSurfaceRecord *get_dynamic_record(struct Object *obj) {
+    u32 slot = dynamic_record_hash(obj);
+    struct DynamicSurfaceRecord *record;
+
+    while ((record = sDynamicRecordTable[slot]) != NULL) {
+        if (record->object == obj) {
+            break;
+        }
+        slot = (slot + 1) & (DYNAMIC_RECORD_TABLE_SIZE - 1);
+    }
+
+    if (record == NULL && sNumDynamicRecords < DYNAMIC_RECORD_TABLE_SIZE / 2) {
+        record = alloc_dynamic_record(obj);
+        record->next = sDynamicRecords;
+        sDynamicRecords = record;
+        sDynamicRecordTable[slot] = record;
+        sNumDynamicRecords++;
+    } else if (record == NULL || (record->linked && record->loadFrame == gDynamicSurfaceFrame)) {
+        record = alloc_dynamic_record(obj);
+        record->next = sTransientDynamicRecords;
+        sTransientDynamicRecords = record;
+    }
+
+    return record;
+}
+
+/**
+ * Update one of a record's surfaces from the transformed vertices. A surface whose vertices
+ * did not change is kept as it is. Otherwise it is recomputed in place and, as long as it
+ * still sorts the same, only the cells it entered or left are touched.
+ * @param relink Whether the record's nodes were all dropped and must be linked again
+ */
+static void update_dynamic_surface(struct DynamicSurfaceRecord *record, struct DynamicSurface *dynSurface,
+                                   s16 *vertexData, s16 *data, s16 surfaceType, s16 hasForce,
+                                   s16 flags, s32 relink) {
+    struct Surface *surface = &dynSurface->surface;
+    struct Surface updated;
+    s16 *v1 = vertexData + 3 * data[0];
+    s16 *v2 = vertexData + 3 * data[1];
+    s16 *v3 = vertexData + 3 * data[2];
+    s16 oldMinCellX, oldMaxCellX, oldMinCellZ, oldMaxCellZ;
+    s16 listIndex = 0;
+    s16 sortDir = 0;
+    s16 priority = 0;
+
+    if (dynSurface->computed
+        && surface->vertex1[0] == v1[0] && surface->vertex1[1] == v1[1] && surface->vertex1[2] == v1[2]
+        && surface->vertex2[0] == v2[0] && surface->vertex2[1] == v2[1] && surface->vertex2[2] == v2[2]
+        && surface->vertex3[0] == v3[0] && surface->vertex3[1] == v3[1] && surface->vertex3[2] == v3[2]) {
+        if (dynSurface->loaded) {
+            if (relink) {
+                link_dynamic_surface(record, dynSurface, 1, 0, 1, 0);
+            }
+            gDynamicSurfacesReused++;
+        }
+        return;
+    }
+
+    dynSurface->computed = TRUE;
+
+    if (!compute_surface_data(&updated, vertexData, data)) {
+        // Degenerate with this transform. Keep the vertices to recognize it next frame.
+        unlink_dynamic_surface(record, dynSurface, 1, 0, 1, 0);
+        if (dynSurface->loaded) {
+            dynSurface->loaded = FALSE;
+            record->numSurfaces--;
+        }
+        vec3s_copy(surface->vertex1, v1);
+        vec3s_copy(surface->vertex2, v2);
+        vec3s_copy(surface->vertex3, v3);
+        return;
+    }
+
+    updated.object = record->object;
+    updated.type = surfaceType;
+    updated.force = hasForce ? data[3] : 0;
+    updated.flags = flags;
+    updated.room = record->room;
+
+    oldMinCellX = dynSurface->minCellX;
+    oldMaxCellX = dynSurface->maxCellX;
+    oldMinCellZ = dynSurface->minCellZ;
+    oldMaxCellZ = dynSurface->maxCellZ;
+
+    dynSurface->minCellX = lower_cell_index(min_3(updated.vertex1[0], updated.vertex2[0], updated.vertex3[0]));
+    dynSurface->maxCellX = upper_cell_index(max_3(updated.vertex1[0], updated.vertex2[0], updated.vertex3[0]));
+    dynSurface->minCellZ = lower_cell_index(min_3(updated.vertex1[2], updated.vertex2[2], updated.vertex3[2]));
+    dynSurface->maxCellZ = upper_cell_index(max_3(updated.vertex1[2], updated.vertex2[2], updated.vertex3[2]));
+
+    // Like add_surface, only classify the surface if it lands in at least one cell.
+    if (dynSurface->minCellX <= dynSurface->maxCellX && dynSurface->minCellZ <= dynSurface->maxCellZ) {
+        listIndex = classify_surface(&updated, &sortDir);
+        priority = updated.vertex1[1] * sortDir;
+    }
+
+    if (relink || !dynSurface->loaded || dynSurface->listIndex != listIndex
+        || dynSurface->priority != priority) {
+        // The surface sorts differently, so it has to be reinserted everywhere.
+        unlink_dynamic_surface(record, dynSurface, 1, 0, 1, 0);
+        oldMinCellX = 1;
+        oldMaxCellX = 0;
+    } else {
+        unlink_dynamic_surface(record, dynSurface, dynSurface->minCellX, dynSurface->maxCellX,
+                               dynSurface->minCellZ, dynSurface->maxCellZ);
+    }
+
+    *surface = updated;
+    dynSurface->listIndex = listIndex;
+    dynSurface->priority = priority;
+    if (!dynSurface->loaded) {
+        dynSurface->loaded = TRUE;
+        record->numSurfaces++;
+    }
+
+    link_dynamic_surface(record, dynSurface, oldMinCellX, oldMaxCellX, oldMinCellZ, oldMaxCellZ);
+
+    gDynamicSurfacesRebuilt++;
+}
+
+/**
+ * Load the current object's collision into the dynamic partition, reusing the surfaces it
+ * had last frame.
+ * @param collisionData The object's collision data, past the TERRAIN_LOAD_VERTICES command
+ */
+static void load_dynamic_object_surfaces(s16 *collisionData) {
+    struct DynamicSurfaceRecord *record = get_dynamic_record(gCurrentObject);
+    struct DynamicSurface *dynSurface;
+    struct DynamicSurface **dynSurfaceLink;
+    s16 vertexData[600];
+    s16 *data = collisionData;
+    s32 numVertices;
+    s32 numSurfaces;
+    s32 surfaceType;
+    s16 hasForce;
+    s16 flags;
+    s16 index = 0;
+    s32 relink;
+    s32 i;
+    Mat4 m;
+    s8 room;
+
+    numVertices = *data++;
+    get_object_collision_matrix(m);
+
+    // The DDD warp is initially loaded at the origin and moved to the proper
+    // position in paintings.c and doesn't update its room, so set it here.
+    if (gCurrentObject->behavior == segmented_to_virtual(bhvDddWarp)) {
+        room = 5;
+    } else {
+        room = 0;
+    }
+
+    if (record->collisionData != collisionData || record->room != room) {
+        free_dynamic_record_surfaces(record);
+        record->collisionData = collisionData;
+        record->room = room;
+    }
+
+    // Objects must end up in the lists in the order they load this frame. If this one had
+    // an earlier place than an object that already loaded, give it the last place.
+    relink = !record->linked;
+    if (record->order <= sPrevLoadOrder) {
+        unlink_dynamic_record(record);
+        record->order = ++sNextLoadOrder;
+        relink = TRUE;
+    }
+
+    if (record->surfaces != NULL && memcmp(m, record->transform, sizeof(Mat4)) == 0) {
+        if (relink) {
+            for (dynSurface = record->surfaces; dynSurface != NULL; dynSurface = dynSurface->next) {
+                if (dynSurface->loaded) {
+                    link_dynamic_surface(record, dynSurface, 1, 0, 1, 0);
+                }
+            }
+        }
+        gDynamicSurfacesReused += record->numSurfaces;
+    } else {
+        transform_vertices(data, numVertices, m, vertexData);
+        memcpy(record->transform, m, sizeof(Mat4));
+        data += 3 * numVertices;
+
+        dynSurfaceLink = &record->surfaces;
+
+        // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
+        while (*data != TERRAIN_LOAD_CONTINUE) {
+            surfaceType = *data++;
+            numSurfaces = *data++;
+            hasForce = surface_has_force(surfaceType);
+            flags = surf_has_no_cam_collision(surfaceType) | SURFACE_FLAG_DYNAMIC;
+
+            for (i = 0; i < numSurfaces; i++) {
+                if ((dynSurface = *dynSurfaceLink) == NULL) {
+                    dynSurface = sFreeDynamicSurfaces;
+                    if (dynSurface != NULL) {
+                        sFreeDynamicSurfaces = dynSurface->next;
+                    } else {
+                        dynSurface = alloc_only_pool_alloc(sDynamicSurfacePool, sizeof(struct DynamicSurface));
+                    }
+                    bzero(dynSurface, sizeof(struct DynamicSurface));
+                    dynSurface->index = index;
+                    *dynSurfaceLink = dynSurface;
+                }
+
+                update_dynamic_surface(record, dynSurface, vertexData, data, surfaceType, hasForce,
+                                       flags, relink);
+
+                dynSurfaceLink = &dynSurface->next;
+                data += hasForce ? 4 : 3;
+                index++;
+            }
+        }
+    }
+
+    record->linked = TRUE;
+    record->loadFrame = gDynamicSurfaceFrame;
+    sPrevLoadOrder = record->order;
+
+    gSurfacesAllocated += record->numSurfaces;
+    gSurfaceNodesAllocated += record->numNodes;
+}
+
+/**
+ * Forget every object's surfaces, for when the dynamic pools are cleared.
+ */
+static void reset_dynamic_surfaces(void) {
+    bzero(sDynamicRecordTable, sizeof(sDynamicRecordTable));
+    sNumDynamicRecords = 0;
+    sDynamicRecords = NULL;
+    sTransientDynamicRecords = NULL;
+    sFreeDynamicRecords = NULL;
+    sFreeDynamicSurfaces = NULL;
+    sFreeDynamicNodes = NULL;
+    sNextLoadOrder = 0;
+    sPrevLoadOrder = 0;
+
+    clear_spatial_partition(&gDynamicSurfacePartition[0][0]);
+}
+#endif
+
 /**
  * Allocate some of the main pool for surfaces (2300 surf) and for surface nodes (7000 nodes).
  */
@@ -557,6 +1788,7 @@ void alloc_surface_pools(void) {
     sStaticSurfacePool = alloc_only_pool_init();
     sDynamicSurfaceNodePool = alloc_only_pool_init();
     sDynamicSurfacePool = alloc_only_pool_init();
+    sStaticPackedPool = alloc_only_pool_init();
 #else
     sSurfacePoolSize = SURFACE_POOL_SIZE;
     sSurfaceNodePool = main_pool_alloc(SURFACE_NODE_POOL_SIZE * sizeof(struct SurfaceNode), MEMORY_POOL_LEFT);
@@ -626,6 +1858,10 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
     s16 terrainLoadType;
     s16 *vertexData;
     UNUSED s32 unused;
+#ifdef USE_SYSTEM_MALLOC
+    s8 *surfaceRoomsStart = surfaceRooms;
+    s32 cacheable = collision_cache_enabled();
+#endif
 
     // Initialize the data for this.
     gEnvironmentRegions = NULL;
@@ -633,11 +1869,24 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
     gSurfaceNodesAllocated = 0;
     gSurfacesAllocated = 0;
 #ifdef USE_SYSTEM_MALLOC
+#ifdef COLLISION_PROFILER
+    // Report on the area being left before its cells are reused.
+    collision_profiler_area_loaded();
+#endif
     alloc_only_pool_clear(sStaticSurfaceNodePool);
     alloc_only_pool_clear(sStaticSurfacePool);
     alloc_only_pool_clear(sDynamicSurfaceNodePool);
     alloc_only_pool_clear(sDynamicSurfacePool);
+    release_static_partition_blob();
     sStaticSurfaceLoadComplete = FALSE;
+    sNumStaticSurfaceEntries = 0;
+    sStaticSurfaceNodes = NULL;
+    bzero(sStaticCellListStart, sizeof(sStaticCellListStart));
+    reset_dynamic_surfaces();
+
+    // The old area's surfaces are gone, so clear_dynamic_surfaces must not count them.
+    gNumStaticSurfaces = 0;
+    gNumStaticSurfaceNodes = 0;
 
     // Originally they forgot to clear this matrix,
     // results in segfaults if this is not done.
@@ -646,6 +1895,12 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
 
     clear_static_surfaces();
 
+#ifdef USE_SYSTEM_MALLOC
+    if (cacheable) {
+        map_static_partition(data, surfaceRooms);
+    }
+#endif
+
     // A while loop iterating through each section of the level data. Sections of data
     // are prefixed by a terrain "type." This type is reused for surfaces as the surface
     // type.
@@ -683,32 +1938,75 @@ void load_area_terrain(s16 index, s16 *data, s8 *surfaceRooms, s16 *macroObjects
         }
     }
 
+#ifdef USE_SYSTEM_MALLOC
+    if (sStaticPartitionBlob == NULL) {
+        build_static_partition();
+        if (cacheable) {
+            store_static_partition(surfaceRoomsStart, surfaceRooms - surfaceRoomsStart);
+        }
+    }
+#endif
+
     gNumStaticSurfaceNodes = gSurfaceNodesAllocated;
     gNumStaticSurfaces = gSurfacesAllocated;
 
 #ifdef USE_SYSTEM_MALLOC
+    pack_static_surfaces();
     sStaticSurfaceLoadComplete = TRUE;
+#ifdef FLOOR_QUERY_CACHE
+    clear_floor_query_cache();
+#endif
 #endif
 }
 
+
 /**
  * If not in time stop, clear the surface partitions.
  */
 void clear_dynamic_surfaces(void) {
     if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
 #ifdef USE_SYSTEM_MALLOC
-        if (gSurfacesAllocated > gNumStaticSurfaces) {
-            alloc_only_pool_clear(sDynamicSurfacePool);
+        struct DynamicSurfaceRecord *record;
+
+        // Objects that didn't load their collision last frame are taken out of the partition.
+        // The others stay linked, and their surfaces are found again once they load this frame.
+        for (record = sDynamicRecords; record != NULL; record = record->next) {
+            if (record->linked && (record->loadFrame != gDynamicSurfaceFrame
+                                   || sNextLoadOrder >= DYNAMIC_LOAD_ORDER_LIMIT)) {
+                unlink_dynamic_record(record);
+            }
+            if (!record->linked && record->surfaces != NULL
+                && record->object->activeFlags == ACTIVE_FLAG_DEACTIVATED) {
+                free_dynamic_record_surfaces(record);
+            }
+            if (sNextLoadOrder >= DYNAMIC_LOAD_ORDER_LIMIT) {
+                record->order = 0;
+            }
         }
-        if (gSurfaceNodesAllocated > gNumStaticSurfaceNodes) {
-            alloc_only_pool_clear(sDynamicSurfaceNodePool);
+
+        while ((record = sTransientDynamicRecords) != NULL) {
+            sTransientDynamicRecords = record->next;
+            free_dynamic_record_surfaces(record);
+            record->next = sFreeDynamicRecords;
+            sFreeDynamicRecords = record;
+        }
+
+        if (sNextLoadOrder >= DYNAMIC_LOAD_ORDER_LIMIT) {
+            sNextLoadOrder = 0;
         }
+        sPrevLoadOrder = 0;
+        gDynamicSurfaceFrame++;
+
+        gDynamicSurfacesRebuilt = 0;
+        gDynamicSurfacesReused = 0;
 #endif
 
         gSurfacesAllocated = gNumStaticSurfaces;
         gSurfaceNodesAllocated = gNumStaticSurfaceNodes;
 
+#ifndef USE_SYSTEM_MALLOC
         clear_spatial_partition(&gDynamicSurfacePartition[0][0]);
+#endif
     }
 }
 
@@ -719,40 +2017,16 @@ UNUSED static void unused_80383604(void) {
  * Applies an object's transformation to the object's vertices.
  */
 void transform_object_vertices(s16 **data, s16 *vertexData) {
-    register s16 *vertices;
-    register f32 vx, vy, vz;
     register s32 numVertices;
-
-    Mat4 *objectTransform;
     Mat4 m;
 
-    objectTransform = &gCurrentObject->transform;
-
     numVertices = *(*data);
     (*data)++;
 
-    vertices = *data;
-
-    if (gCurrentObject->header.gfx.throwMatrix == NULL) {
-        gCurrentObject->header.gfx.throwMatrix = objectTransform;
-        obj_build_transform_from_pos_and_angle(gCurrentObject, O_POS_INDEX, O_FACE_ANGLE_INDEX);
-    }
-
-    obj_apply_scale_to_matrix(gCurrentObject, m, *objectTransform);
+    get_object_collision_matrix(m);
+    transform_vertices(*data, numVertices, m, vertexData);
 
-    // Go through all vertices, rotating and translating them to transform the object.
-    while (numVertices--) {
-        vx = *(vertices++);
-        vy = *(vertices++);
-        vz = *(vertices++);
-
-        //! No bounds check on vertex data
-        *vertexData++ = (s16)(vx * m[0][0] + vy * m[1][0] + vz * m[2][0] + m[3][0]);
-        *vertexData++ = (s16)(vx * m[0][1] + vy * m[1][1] + vz * m[2][1] + m[3][1]);
-        *vertexData++ = (s16)(vx * m[0][2] + vy * m[1][2] + vz * m[2][2] + m[3][2]);
-    }
-
-    *data = vertices;
+    *data += 3 * numVertices;
 }
 
 /**
@@ -816,7 +2090,9 @@ void load_object_surfaces(s16 **data, s16 *vertexData) {
  */
 void load_object_collision_model(void) {
     UNUSED s32 unused;
+#ifndef USE_SYSTEM_MALLOC
     s16 vertexData[600];
+#endif
 
     s16 *collisionData = gCurrentObject->collisionData;
     f32 marioDist = gCurrentObject->oDistanceToMario;
@@ -838,12 +2114,16 @@ void load_object_collision_model(void) {
     if (!(gTimeStopState & TIME_STOP_ACTIVE) && marioDist < tangibleDist
         && !(gCurrentObject->activeFlags & ACTIVE_FLAG_IN_DIFFERENT_ROOM)) {
         collisionData++;
+#ifdef USE_SYSTEM_MALLOC
+        load_dynamic_object_surfaces(collisionData);
+#else
         transform_object_vertices(&collisionData, vertexData);
 
         // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
         while (*collisionData != TERRAIN_LOAD_CONTINUE) {
             load_object_surfaces(&collisionData, vertexData);
         }
+#endif
     }
 
     if (marioDist < gCurrentObject->oDrawingDistance) {
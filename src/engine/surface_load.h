@@ -26,6 +26,94 @@ enum
 
 typedef struct SurfaceNode SpatialPartitionCell[3];
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * The static partition's surface lists are also packed into parallel arrays, in the same order
+ * as the SurfaceNode lists, so the collision queries can test several surfaces at once.
+ * The arrays are padded to a multiple of PACKED_SURFACE_LANES entries.
+ */
+#define PACKED_SURFACE_LANES 8
+
+struct PackedSurfaceList
+{
+    s32 count;
+    struct Surface **surfaces;
+    s32 *x1, *z1, *x2, *z2, *x3, *z3;
+    f32 *lowerY, *upperY;
+    f32 *normalX, *normalY, *normalZ, *originOffset;
+    s16 *type;
+    s8 *flags;
+    // Walls only, the xz bounds of each wall for rejecting it before the exact test.
+    f32 *minX, *maxX, *minZ, *maxZ;
+};
+
+typedef struct PackedSurfaceList PackedPartitionCell[3];
+
+extern PackedPartitionCell gStaticPackedPartition[NUM_CELLS][NUM_CELLS];
+
+#if STATIC_PARTITION_MODE == 1
+/**
+ * A quadtree over a crowded cell's floors or ceilings. Each child covers a quarter of its
+ * parent's square and holds the parent's surfaces that can be hit in it, in the same order,
+ * so a query finds the same surfaces in a shorter list. Children are indexed by
+ * (z half << 1) | x half, and a leaf has none.
+ */
+struct PackedSurfaceTree
+{
+    struct PackedSurfaceList list;
+    struct PackedSurfaceTree *children;
+};
+
+// Floors and ceilings only, NULL for cells that aren't split.
+extern struct PackedSurfaceTree *gStaticPackedTrees[NUM_CELLS][NUM_CELLS][2];
+#endif
+
+/**
+ * Object surfaces are kept from one frame to the next and only recomputed when the object's
+ * transform changes. Each object that loads its collision has a record of its surfaces, and
+ * every node in the dynamic partition belongs to one. Nodes are doubly linked so that a moved
+ * surface can be taken out of the cells it left without walking the lists.
+ */
+struct DynamicSurfaceRecord
+{
+    struct DynamicSurfaceRecord *next;
+    struct Object *object;
+    s16 *collisionData;
+    struct DynamicSurface *surfaces;
+    Mat4 transform;
+    u32 loadFrame;
+    u32 order;
+    s32 numSurfaces;
+    s32 numNodes;
+    s8 room;
+    u8 linked;
+};
+
+struct DynamicSurfaceNode
+{
+    struct SurfaceNode node;
+    struct SurfaceNode *prev;
+    struct DynamicSurfaceNode *nextInSurface;
+    struct DynamicSurfaceRecord *record;
+    u32 order;
+    s16 priority;
+    s16 index;
+    s16 cellX;
+    s16 cellZ;
+};
+
+/**
+ * An object's nodes stay linked until the next frame, but like in the original, its surfaces
+ * must not be found until it has loaded its collision again this frame.
+ */
+#define DYNAMIC_SURFACE_NODE_LOADED(surfaceNode) \
+    (((struct DynamicSurfaceNode *) (surfaceNode))->record->loadFrame == gDynamicSurfaceFrame)
+
+extern u32 gDynamicSurfaceFrame;
+extern s32 gDynamicSurfacesRebuilt;
+extern s32 gDynamicSurfacesReused;
+#endif
+
 // Needed for bs bss reordering memes.
 extern s32 unused8038BE90;
 
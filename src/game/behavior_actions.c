@@ -44,6 +44,9 @@
 #include "spawn_object.h"
 #include "spawn_sound.h"
 #include "rumble_init.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+#include "particle_system.h"
+#endif
 
 #define o gCurrentObject
 
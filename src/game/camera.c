@@ -2619,15 +2619,19 @@ s32 set_mode_c_up(struct Camera *c) {
  * direction.
  */
 s32 exit_c_up(struct Camera *c) {
+#if defined(TARGET_N64) || !defined(C_UP_EXIT_RAYCAST)
     struct Surface *surface;
+#endif
     Vec3f checkFoc;
     Vec3f curPos;
     // Variables for searching for an open direction
     s32 searching = 0;
     /// The current sector of the circle that we are checking
     s32 sector;
+#if defined(TARGET_N64) || !defined(C_UP_EXIT_RAYCAST)
     f32 ceilHeight;
     f32 floorHeight;
+#endif
     f32 curDist;
     f32 d;
     s16 curPitch;
@@ -2635,6 +2639,10 @@ s32 exit_c_up(struct Camera *c) {
     s16 checkYaw = 0;
     Vec3f storePos; // unused
     Vec3f storeFoc; // unused
+#if !defined(TARGET_N64) && defined(C_UP_EXIT_RAYCAST)
+    struct RaycastHit hit;
+    Vec3f rayDir;
+#endif
 
     if ((gCameraMovementFlags & CAM_MOVE_C_UP_MODE) && !(gCameraMovementFlags & CAM_MOVE_STARTED_EXITING_C_UP)) {
         // Copy the stored pos and focus. This is unused.
@@ -2661,6 +2669,7 @@ s32 exit_c_up(struct Camera *c) {
 
                 // If there are no walls this way,
                 if (f32_find_wall_collision(&curPos[0], &curPos[1], &curPos[2], 20.f, 50.f) == 0) {
+#if defined(TARGET_N64) || !defined(C_UP_EXIT_RAYCAST)
 
                     // Start close to Mario, check for walls, floors, and ceilings all the way to the
                     // zoomed out distance
@@ -2682,6 +2691,18 @@ s32 exit_c_up(struct Camera *c) {
                             break;
                         }
                     }
+#else
+                    // Cast one ray from close to Mario out to the zoomed out distance, instead of
+                    // checking for walls, floors, and ceilings every 20 units along the way. The ray
+                    // reaches past the zoomed out distance by the radius of the wall check.
+                    vec3f_set_dist_and_angle(checkFoc, curPos, curDist, 0, curYaw + checkYaw);
+                    vec3f_set(rayDir, sins(curYaw + checkYaw), 0.f, coss(curYaw + checkYaw));
+                    if (raycast(curPos, rayDir, gCameraZoomDist - curDist + 50.f, RAYCAST_ALL, &hit)) {
+                        d = curDist;
+                    } else {
+                        d = gCameraZoomDist;
+                    }
+#endif
 
                     // If there was no collision found all the way to the max distance, it's an opening
                     if (d >= gCameraZoomDist) {
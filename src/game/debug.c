@@ -12,7 +12,11 @@
 #include "object_list_processor.h"
 #include "print.h"
 #include "sm64.h"
+#include "spawn_object.h"
 #include "types.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+#include "../pc/behavior_profiler.h"
+#endif
 
 #define DEBUG_INFO_NOFLAGS (0 << 0)
 #define DEBUG_INFO_FLAG_DPRINT (1 << 0)
@@ -75,6 +79,16 @@ void stub_debug_4(void) {
  * counts. They likely have stubbed out code that calculated the clock count and
  * its difference for consecutive calls.
  */
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+// The behavior profiler reads the phases of update_objects from them, in nanoseconds.
+s64 get_current_clock(void) {
+    return behavior_profiler_get_time_ns();
+}
+
+s64 get_clock_difference(s64 arg0) {
+    return behavior_profiler_get_time_ns() - arg0;
+}
+#else
 s64 get_current_clock(void) {
     s64 wtf = 0;
 
@@ -86,6 +100,7 @@ s64 get_clock_difference(UNUSED s64 arg0) {
 
     return wtf;
 }
+#endif
 
 /*
  * Set the print state info given a pointer to a print state and the relevent
@@ -466,6 +481,9 @@ void try_print_debug_mario_object_info(void) {
     }
 
     print_debug_top_down_mapinfo("obj  %d", gObjectCounter);
+#ifdef USE_SYSTEM_MALLOC
+    print_debug_top_down_mapinfo("pool %d", gObjectPoolHighWater);
+#endif
 
     if (gNumFindFloorMisses) {
         print_debug_bottom_up("NULLBG %d", gNumFindFloorMisses);
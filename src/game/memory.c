@@ -509,6 +509,25 @@ struct AllocOnlyPool *alloc_only_pool_init(void) {
     return pool;
 }
 
+#ifdef MODEL_GRAPH_CACHE
+/**
+ * Allocate an alloc-only pool outside the main pool, so that it survives every
+ * main_pool_pop_state. It is never freed.
+ */
+struct AllocOnlyPool *alloc_only_pool_init_persistent(void) {
+    struct AllocOnlyPool *pool = malloc(sizeof(struct AllocOnlyPool));
+
+    if (pool == NULL) {
+        abort();
+    }
+    pool->lastBlock = NULL;
+    pool->lastBlockSize = 0;
+    pool->lastBlockNextPos = 0;
+
+    return pool;
+}
+#endif
+
 void alloc_only_pool_clear(struct AllocOnlyPool *pool) {
     alloc_only_pool_release_handler(pool);
     pool->lastBlock = NULL;
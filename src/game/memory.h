@@ -85,6 +85,9 @@ void load_engine_code_segment(void);
 
 #ifdef USE_SYSTEM_MALLOC
 struct AllocOnlyPool *alloc_only_pool_init(void);
+#ifdef MODEL_GRAPH_CACHE
+struct AllocOnlyPool *alloc_only_pool_init_persistent(void);
+#endif
 void alloc_only_pool_clear(struct AllocOnlyPool *pool);
 void *alloc_only_pool_alloc(struct AllocOnlyPool *pool, s32 size);
 #else
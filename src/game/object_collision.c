@@ -1,4 +1,9 @@
 #include <PR/ultratypes.h>
+#ifdef USE_SYSTEM_MALLOC
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#endif
 
 #include "sm64.h"
 #include "debug.h"
@@ -104,8 +109,276 @@ void clear_object_collision(struct Object *a) {
     }
 }
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Broad phase for the collision checks. At the start of detect_object_collisions, the objects
+ * in each list are bucketed by the grid cell they are in. Checking an object against a list
+ * then only tests the objects in the cells its hitbox can reach, still in list order, so the
+ * same pairs collide in the same order as when the whole list is walked.
+ *
+ * Objects with a hitbox wider than half a cell aren't bucketed, they are kept apart and tested
+ * by every check against their list, so they don't widen the reach of the others.
+ */
+#define COLLISION_GRID_CELL_SIZE   512.0
+#define COLLISION_GRID_MAX_RADIUS  (COLLISION_GRID_CELL_SIZE / 2)
+#define COLLISION_GRID_BUCKETS     1024
+// With fewer objects than this, walking the lists is faster than building the grid.
+#define COLLISION_GRID_MIN_OBJECTS 128
+// Checks that would look at more cells than this walk the whole list instead.
+#define COLLISION_GRID_MAX_CELLS   16
+// Cell coordinates are clamped to this, objects further out share the edge cells.
+#define COLLISION_GRID_MAX_CELL    0x8000
+
+struct CollisionGridEntry {
+    struct Object *obj;
+    s32 next; // next entry in the same bucket, -1 at the end
+    s32 cellX;
+    s32 cellZ;
+    s32 list;
+    s32 large;
+};
+
+static s32 sCollisionGridBuilt = FALSE;
+// Entries are added list by list in list order, so an entry's index gives its order.
+static struct CollisionGridEntry *sCollisionGridEntries;
+static s32 sNumCollisionGridEntries;
+static s32 sCollisionGridCapacity;
+static s32 sCollisionGridBuckets[COLLISION_GRID_BUCKETS];
+// Entry index of each object, by open addressing on its address. -1 is an empty slot.
+static s32 *sCollisionGridSlots;
+static s32 sCollisionGridSlotMask;
+// The largest bucketed hitbox radius in each list, or infinity if the list can't use the grid.
+static f32 sCollisionGridMaxRadius[NUM_OBJ_LISTS];
+// First of the entries in each list that aren't bucketed, linked like a bucket.
+static s32 sCollisionGridLarge[NUM_OBJ_LISTS];
+// One bit per entry, set for the candidates of the check being done.
+static u32 *sCollisionGridMarks;
+
+static s32 collision_grid_cell(f32 pos) {
+    f64 cell = floor(pos / COLLISION_GRID_CELL_SIZE);
+
+    if (cell < -COLLISION_GRID_MAX_CELL) {
+        return -COLLISION_GRID_MAX_CELL;
+    }
+    if (cell > COLLISION_GRID_MAX_CELL) {
+        return COLLISION_GRID_MAX_CELL;
+    }
+    return (s32) cell;
+}
+
+static s32 collision_grid_bucket(s32 cellX, s32 cellZ, s32 list) {
+    return ((u32) cellX * 73856093u ^ (u32) cellZ * 19349663u ^ (u32) list * 83492791u)
+           & (COLLISION_GRID_BUCKETS - 1);
+}
+
+static s32 collision_grid_slot(struct Object *obj) {
+    return ((uintptr_t) obj / sizeof(struct Object) * 2654435761u) & sCollisionGridSlotMask;
+}
+
+/**
+ * Return the entry index of an object in the grid, or -1 if it isn't in it.
+ */
+static s32 collision_grid_find(struct Object *obj) {
+    s32 slot = collision_grid_slot(obj);
+
+    while (sCollisionGridSlots[slot] != -1) {
+        if (sCollisionGridEntries[sCollisionGridSlots[slot]].obj == obj) {
+            return sCollisionGridSlots[slot];
+        }
+        slot = (slot + 1) & sCollisionGridSlotMask;
+    }
+    return -1;
+}
+
+static void build_collision_grid(void) {
+    static const s32 lists[] = { OBJ_LIST_PLAYER,  OBJ_LIST_DESTRUCTIVE, OBJ_LIST_GENACTOR,
+                                 OBJ_LIST_PUSHABLE, OBJ_LIST_LEVEL,      OBJ_LIST_SURFACE,
+                                 OBJ_LIST_POLELIKE };
+    struct CollisionGridEntry *entry;
+    struct Object *head, *obj;
+    s32 count, numSlots, slot, bucket, i;
+
+    count = 0;
+    for (i = 0; i < (s32) ARRAY_COUNT(lists); i++) {
+        head = (struct Object *) &gObjectLists[lists[i]];
+        for (obj = (struct Object *) head->header.next; obj != head;
+             obj = (struct Object *) obj->header.next) {
+            count++;
+        }
+    }
+    if (count < COLLISION_GRID_MIN_OBJECTS) {
+        return;
+    }
+
+    if (count > sCollisionGridCapacity) {
+        free(sCollisionGridEntries);
+        free(sCollisionGridSlots);
+        free(sCollisionGridMarks);
+        sCollisionGridCapacity = count * 2;
+        numSlots = 64;
+        while (numSlots < sCollisionGridCapacity * 2) {
+            numSlots *= 2;
+        }
+        sCollisionGridEntries = malloc(sCollisionGridCapacity * sizeof(struct CollisionGridEntry));
+        sCollisionGridSlots = malloc(numSlots * sizeof(s32));
+        sCollisionGridMarks = calloc(sCollisionGridCapacity / 32 + 1, sizeof(u32));
+        sCollisionGridSlotMask = numSlots - 1;
+        if (sCollisionGridEntries == NULL || sCollisionGridSlots == NULL
+            || sCollisionGridMarks == NULL) {
+            sCollisionGridCapacity = 0;
+            return;
+        }
+    }
+
+    for (i = 0; i < COLLISION_GRID_BUCKETS; i++) {
+        sCollisionGridBuckets[i] = -1;
+    }
+    for (i = 0; i <= sCollisionGridSlotMask; i++) {
+        sCollisionGridSlots[i] = -1;
+    }
+
+    sNumCollisionGridEntries = 0;
+    for (i = 0; i < (s32) ARRAY_COUNT(lists); i++) {
+        sCollisionGridMaxRadius[lists[i]] = 0.0f;
+        sCollisionGridLarge[lists[i]] = -1;
+
+        head = (struct Object *) &gObjectLists[lists[i]];
+        for (obj = (struct Object *) head->header.next; obj != head;
+             obj = (struct Object *) obj->header.next) {
+            entry = &sCollisionGridEntries[sNumCollisionGridEntries];
+            entry->obj = obj;
+            entry->cellX = collision_grid_cell(obj->oPosX);
+            entry->cellZ = collision_grid_cell(obj->oPosZ);
+            entry->list = lists[i];
+            entry->large = FALSE;
+
+            // NaN or infinite values make checks against the list walk it instead.
+            if (!isfinite(obj->hitboxRadius) || !isfinite(obj->oPosX) || !isfinite(obj->oPosZ)) {
+                sCollisionGridMaxRadius[lists[i]] = INFINITY;
+            } else if (obj->hitboxRadius > COLLISION_GRID_MAX_RADIUS) {
+                entry->large = TRUE;
+            } else if (obj->hitboxRadius > sCollisionGridMaxRadius[lists[i]]) {
+                sCollisionGridMaxRadius[lists[i]] = obj->hitboxRadius;
+            }
+
+            slot = collision_grid_slot(obj);
+            while (sCollisionGridSlots[slot] != -1) {
+                slot = (slot + 1) & sCollisionGridSlotMask;
+            }
+            sCollisionGridSlots[slot] = sNumCollisionGridEntries;
+
+            sNumCollisionGridEntries++;
+        }
+    }
+
+    // Link the buckets backwards so that each one is in list order.
+    for (i = sNumCollisionGridEntries - 1; i >= 0; i--) {
+        entry = &sCollisionGridEntries[i];
+        if (entry->large) {
+            entry->next = sCollisionGridLarge[entry->list];
+            sCollisionGridLarge[entry->list] = i;
+        } else {
+            bucket = collision_grid_bucket(entry->cellX, entry->cellZ, entry->list);
+            entry->next = sCollisionGridBuckets[bucket];
+            sCollisionGridBuckets[bucket] = i;
+        }
+    }
+
+    sCollisionGridBuilt = TRUE;
+}
+
+/**
+ * Mark the entries of a bucket from index start on that are in the given list and cell. The
+ * bucket may also hold entries from other cells that hash the same.
+ */
+static void mark_collision_candidates(s32 i, s32 start, s32 list, s32 cellX, s32 cellZ,
+                                      s32 *minIndex, s32 *maxIndex) {
+    struct CollisionGridEntry *entry;
+
+    while (i != -1) {
+        entry = &sCollisionGridEntries[i];
+        if (i >= start && entry->list == list
+            && (entry->large || (entry->cellX == cellX && entry->cellZ == cellZ))) {
+            sCollisionGridMarks[i / 32] |= 1u << (i % 32);
+            if (i < *minIndex) {
+                *minIndex = i;
+            }
+            if (i > *maxIndex) {
+                *maxIndex = i;
+            }
+        }
+        i = entry->next;
+    }
+}
+
+/**
+ * Check a against the objects from b to the end of list c using the grid. Returns FALSE if the
+ * grid can't be used, and the list should be walked instead.
+ */
+static s32 check_collision_in_grid(struct Object *a, struct Object *b, struct Object *c) {
+    s32 list = (struct ObjectNode *) c - gObjectLists;
+    s32 start, minIndex, maxIndex, minX, maxX, minZ, maxZ, cellX, cellZ, word, i;
+    f64 reach;
+
+    if (b == c) {
+        return TRUE;
+    }
+    start = collision_grid_find(b);
+    if (start < 0 || sCollisionGridEntries[start].list != list) {
+        return FALSE;
+    }
+    if (!isfinite(sCollisionGridMaxRadius[list]) || !isfinite(a->hitboxRadius)
+        || !isfinite(a->oPosX) || !isfinite(a->oPosZ)) {
+        return FALSE;
+    }
+
+    // Any bucketed object that a's hitbox touches is within the sum of their radii on both axes.
+    // The extra unit covers the rounding in detect_object_hitbox_overlap's distance.
+    reach = (f64) a->hitboxRadius + sCollisionGridMaxRadius[list] + 1.0;
+    minX = collision_grid_cell(a->oPosX - reach);
+    maxX = collision_grid_cell(a->oPosX + reach);
+    minZ = collision_grid_cell(a->oPosZ - reach);
+    maxZ = collision_grid_cell(a->oPosZ + reach);
+    if (maxX - minX >= COLLISION_GRID_MAX_CELLS || maxZ - minZ >= COLLISION_GRID_MAX_CELLS
+        || (maxX - minX + 1) * (maxZ - minZ + 1) > COLLISION_GRID_MAX_CELLS) {
+        return FALSE;
+    }
+
+    // The candidates are marked by entry index, so they are visited in list order.
+    minIndex = sNumCollisionGridEntries;
+    maxIndex = -1;
+    mark_collision_candidates(sCollisionGridLarge[list], start, list, 0, 0, &minIndex, &maxIndex);
+    for (cellZ = minZ; cellZ <= maxZ; cellZ++) {
+        for (cellX = minX; cellX <= maxX; cellX++) {
+            mark_collision_candidates(sCollisionGridBuckets[collision_grid_bucket(cellX, cellZ, list)],
+                                      start, list, cellX, cellZ, &minIndex, &maxIndex);
+        }
+    }
+
+    for (word = minIndex / 32; word <= maxIndex / 32 && maxIndex >= 0; word++) {
+        while (sCollisionGridMarks[word] != 0) {
+            i = word * 32 + __builtin_ctz(sCollisionGridMarks[word]);
+            sCollisionGridMarks[word] &= sCollisionGridMarks[word] - 1;
+
+            b = sCollisionGridEntries[i].obj;
+            if (b->oIntangibleTimer == 0) {
+                if (detect_object_hitbox_overlap(a, b) && b->hurtboxRadius != 0.0f) {
+                    detect_object_hurtbox_overlap(a, b);
+                }
+            }
+        }
+    }
+    return TRUE;
+}
+#endif
+
 void check_collision_in_list(struct Object *a, struct Object *b, struct Object *c) {
     if (a->oIntangibleTimer == 0) {
+#ifdef USE_SYSTEM_MALLOC
+        if (sCollisionGridBuilt && check_collision_in_grid(a, b, c)) {
+            return;
+        }
+#endif
         while (b != c) {
             if (b->oIntangibleTimer == 0) {
                 if (detect_object_hitbox_overlap(a, b) && b->hurtboxRadius != 0.0f) {
@@ -175,7 +448,13 @@ void detect_object_collisions(void) {
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_LEVEL]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_SURFACE]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_DESTRUCTIVE]);
+#ifdef USE_SYSTEM_MALLOC
+    build_collision_grid();
+#endif
     check_player_object_collision();
     check_destructive_object_collision();
     check_pushable_object_collision();
+#ifdef USE_SYSTEM_MALLOC
+    sCollisionGridBuilt = FALSE;
+#endif
 }
@@ -26,6 +26,9 @@
 #include "rendering_graph_node.h"
 #include "spawn_object.h"
 #include "spawn_sound.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+#include "particle_system.h"
+#endif
 
 static s8 sBbhStairJiggleOffsets[] = { -8, 8, -4, 4 };
 static s16 sPowersOfTwo[] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
@@ -2072,7 +2075,12 @@ s16 cur_obj_reflect_move_angle_off_wall(void) {
 }
 
 void cur_obj_spawn_particles(struct SpawnParticlesInfo *info) {
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    s16 yaw;
+    f32 forwardVel, velY;
+#else
     struct Object *particle;
+#endif
     s32 i;
     f32 scale;
     s32 numParticles = info->count;
@@ -2091,6 +2099,14 @@ void cur_obj_spawn_particles(struct SpawnParticlesInfo *info) {
     for (i = 0; i < numParticles; i++) {
         scale = random_float() * (info->sizeRange * 0.1f) + info->sizeBase * 0.1f;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+        // The same random numbers, in the same order, as the object below
+        yaw = random_u16();
+        forwardVel = random_float() * info->forwardVelRange + info->forwardVelBase;
+        velY = random_float() * info->velYRange + info->velYBase;
+        spawn_puff_particle(o, info->model, info->behParam, yaw, forwardVel, velY, info->gravity,
+                            info->dragStrength, info->offsetY, scale);
+#else
         particle = spawn_object(o, info->model, bhvWhitePuffExplosion);
 
         particle->oBehParams2ndByte = info->behParam;
@@ -2103,6 +2119,7 @@ void cur_obj_spawn_particles(struct SpawnParticlesInfo *info) {
         particle->oVelY = random_float() * info->velYRange + info->velYBase;
 
         obj_scale_xyz(particle, scale, scale, scale);
+#endif
     }
 }
 
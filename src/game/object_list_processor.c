@@ -19,7 +19,21 @@
 #include "platform_displacement.h"
 #include "profiler.h"
 #include "spawn_object.h"
-
+#if defined(USE_SYSTEM_MALLOC) && defined(COLLISION_PROFILER)
+#include "../pc/collision_profiler.h"
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+#include "particle_system.h"
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../pc/thread_pool.h"
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+#include "../pc/behavior_profiler.h"
+#endif
 
 /**
  * Flags controlling what debug info is displayed.
@@ -104,12 +118,38 @@ struct Object *gLuigiObject;
  * This object is used frequently in object behavior code, and so is often
  * aliased as "o".
  */
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+__thread struct Object *gCurrentObject;
+#else
 struct Object *gCurrentObject;
+#endif
 
 /**
  * The next object behavior command to be executed.
  */
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+__thread const BehaviorScript *gCurBhvCommand;
+#else
 const BehaviorScript *gCurBhvCommand;
+#endif
+
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+/**
+ * The number of frames that gCurrentObject's update stands for. This is more than 1 when the
+ * object is updated less often because it's far from Mario.
+ */
+#ifdef PARALLEL_OBJECT_UPDATES
+__thread s32 gCurrentObjectUpdateFrames = 1;
+#else
+s32 gCurrentObjectUpdateFrames = 1;
+#endif
+
+/**
+ * Counts the frames in which objects were updated without time stop, for spacing out updates of
+ * far objects.
+ */
+static u32 sObjectUpdateFrame;
+#endif
 
 /**
  * The number of objects that were processed last frame, which may miss some
@@ -158,8 +198,13 @@ s16 gTHIWaterDrained;
 s16 gTTCSpeedSetting;
 s16 gMarioShotFromCannon;
 s16 gCCMEnteredSlide;
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+__thread s16 gNumRoomedObjectsInMarioRoom;
+__thread s16 gNumRoomedObjectsNotInMarioRoom;
+#else
 s16 gNumRoomedObjectsInMarioRoom;
 s16 gNumRoomedObjectsNotInMarioRoom;
+#endif
 s16 gWDWWaterLevelChanging;
 s16 gMarioOnMerryGoRound;
 
@@ -257,6 +302,12 @@ void copy_mario_state_to_object(void) {
 void spawn_particle(u32 activeParticleFlag, s16 model, const BehaviorScript *behavior) {
     if (!(gCurrentObject->oActiveParticleFlags & activeParticleFlag)) {
         struct Object *particle;
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+        // During time stop the spawner would wait with its flag set, so leave these to it.
+        if (!(gTimeStopState & TIME_STOP_ACTIVE) && spawn_mario_particle(gCurrentObject, behavior)) {
+            return;
+        }
+#endif
         gCurrentObject->oActiveParticleFlags |= activeParticleFlag;
         particle = spawn_object_at_origin(gCurrentObject, 0, model, behavior);
         obj_copy_pos_and_angle(particle, gCurrentObject);
@@ -288,6 +339,387 @@ void bhv_mario_update(void) {
     }
 }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+/**
+ * Return the number of frames the object should be updated for this frame, or 0 if its update
+ * should be skipped. Objects that allow it are updated less often the further they are from
+ * Mario, but never less than every frame within their drawing distance. Updates of objects at
+ * the same rate are spread over the frames by their address.
+ */
+static s32 get_object_update_frames(struct Object *obj) {
+    f32 dx, dy, dz, distSq, minDistSq;
+    u32 interval, phase;
+    s32 frames;
+
+    if (!(obj->oFlags & OBJ_FLAG_ALLOW_UPDATE_LOD) || gMarioObject == NULL) {
+        return 1;
+    }
+
+    dx = obj->oPosX - gMarioObject->oPosX;
+    dy = obj->oPosY - gMarioObject->oPosY;
+    dz = obj->oPosZ - gMarioObject->oPosZ;
+    distSq = dx * dx + dy * dy + dz * dz;
+    minDistSq = obj->oDrawingDistance * obj->oDrawingDistance;
+
+    if (distSq < minDistSq
+        || distSq < OBJECT_UPDATE_LOD_HALF_RATE_DIST * OBJECT_UPDATE_LOD_HALF_RATE_DIST) {
+        interval = 1;
+    } else if (distSq < OBJECT_UPDATE_LOD_QUARTER_RATE_DIST * OBJECT_UPDATE_LOD_QUARTER_RATE_DIST) {
+        interval = 2;
+    } else if (distSq < OBJECT_UPDATE_LOD_SUSPEND_DIST * OBJECT_UPDATE_LOD_SUSPEND_DIST) {
+        interval = 4;
+    } else {
+        // Suspended objects don't catch up on the frames they missed once they're updated again.
+        obj->lastUpdateFrame = sObjectUpdateFrame;
+        return 0;
+    }
+
+    phase = (u32) ((uintptr_t) obj / sizeof(struct Object));
+    if (((sObjectUpdateFrame + phase) & (interval - 1)) != 0) {
+        return 0;
+    }
+
+    frames = obj->lastUpdateFrame != 0 ? (s32) (sObjectUpdateFrame - obj->lastUpdateFrame) : 1;
+    obj->lastUpdateFrame = sObjectUpdateFrame;
+    return frames;
+}
+#endif
+
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+// Objects per thread below which a parallel phase isn't worth splitting up.
+#define PARALLEL_UPDATE_MIN_PER_THREAD 16
+
+/**
+ * An object updated in the parallel phase of its list. The object is put back as it was before
+ * the phase, and takes the result when the rest of the list's update gets to it.
+ */
+struct ParallelUpdateSlot {
+    struct Object *obj;
+    struct Object before;
+    struct Object after;
+    void (**deferred)(void);
+    s32 numDeferred;
+    s32 deferredCapacity;
+    // What the update added to the roomed object counts.
+    s16 inMarioRoom;
+    s16 notInMarioRoom;
+};
+
+static struct ParallelUpdateSlot *sParallelUpdateSlots;
+static s32 sParallelUpdateSlotCapacity;
+
+// The slot of the object this thread is updating in a parallel phase, NULL outside of one.
+static __thread struct ParallelUpdateSlot *sCurParallelUpdateSlot;
+
+void cur_obj_defer(void (*func)(void)) {
+    struct ParallelUpdateSlot *slot = sCurParallelUpdateSlot;
+    void (**deferred)(void);
+
+    if (slot == NULL) {
+        func();
+        return;
+    }
+
+    if (slot->numDeferred == slot->deferredCapacity) {
+        slot->deferredCapacity = slot->deferredCapacity != 0 ? slot->deferredCapacity * 2 : 4;
+        deferred = realloc(slot->deferred, slot->deferredCapacity * sizeof(slot->deferred[0]));
+        if (deferred == NULL) {
+            abort();
+        }
+        slot->deferred = deferred;
+    }
+    slot->deferred[slot->numDeferred++] = func;
+}
+
+static void update_parallel_objects_range(void *arg, int start, int end) {
+    struct ParallelUpdateSlot *slots = arg;
+    s16 inMarioRoom = gNumRoomedObjectsInMarioRoom;
+    s16 notInMarioRoom = gNumRoomedObjectsNotInMarioRoom;
+    s32 i;
+
+    // Same as update_objects_starting_at.
+    for (i = start; i < end; i++) {
+        sCurParallelUpdateSlot = &slots[i];
+        gCurrentObject = slots[i].obj;
+        gNumRoomedObjectsInMarioRoom = 0;
+        gNumRoomedObjectsNotInMarioRoom = 0;
+
+        gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
+#ifdef OBJECT_UPDATE_LOD
+        gCurrentObjectUpdateFrames = get_object_update_frames(gCurrentObject);
+        if (gCurrentObjectUpdateFrames != 0) {
+            cur_obj_update();
+        }
+        gCurrentObjectUpdateFrames = 1;
+#else
+        cur_obj_update();
+#endif
+
+        slots[i].inMarioRoom = gNumRoomedObjectsInMarioRoom;
+        slots[i].notInMarioRoom = gNumRoomedObjectsNotInMarioRoom;
+    }
+    sCurParallelUpdateSlot = NULL;
+
+    gNumRoomedObjectsInMarioRoom = inMarioRoom;
+    gNumRoomedObjectsNotInMarioRoom = notInMarioRoom;
+}
+
+/**
+ * Copy an object's state, leaving it where it is in its list and in the graph, which objects
+ * spawned in the meantime may have changed.
+ */
+static void copy_object_state(struct Object *obj, struct Object *state) {
+    struct GraphNode node = obj->header.gfx.node;
+    struct ObjectNode *next = obj->header.next;
+    struct ObjectNode *prev = obj->header.prev;
+
+    memcpy(obj, state, sizeof(struct Object));
+    obj->header.gfx.node.prev = node.prev;
+    obj->header.gfx.node.next = node.next;
+    obj->header.gfx.node.parent = node.parent;
+    obj->header.gfx.node.children = node.children;
+    obj->header.next = next;
+    obj->header.prev = prev;
+}
+
+/**
+ * Return whether the object's state is the same as state, apart from where it is in its list and
+ * in the graph. The links are taken into state.
+ */
+static s32 object_state_equals(struct Object *obj, struct Object *state) {
+    state->header.gfx.node.prev = obj->header.gfx.node.prev;
+    state->header.gfx.node.next = obj->header.gfx.node.next;
+    state->header.gfx.node.parent = obj->header.gfx.node.parent;
+    state->header.gfx.node.children = obj->header.gfx.node.children;
+    state->header.next = obj->header.next;
+    state->header.prev = obj->header.prev;
+    return memcmp(obj, state, sizeof(struct Object)) == 0;
+}
+
+#ifdef PARALLEL_OBJECT_UPDATE_CHECK
+/**
+ * The state kept for checking a parallel update against updating the object at its place in its
+ * list, as the original game does.
+ */
+struct ParallelUpdateCheck {
+    // Every object in the lists, and what it was like before the update being checked.
+    struct Object **objects;
+    struct Object *before;
+    s32 numObjects;
+    s32 objectCapacity;
+    struct MarioState marioState;
+    u16 randomSeed;
+    s32 poolUsed;
+};
+
+static struct ParallelUpdateCheck sParallelUpdateCheck;
+
+enum ParallelUpdateProblem {
+    PARALLEL_UPDATE_WROTE_OBJECT,
+    PARALLEL_UPDATE_WROTE_MARIO,
+    PARALLEL_UPDATE_USED_RANDOM,
+    PARALLEL_UPDATE_SPAWNED,
+    PARALLEL_UPDATE_DIFFERED,
+};
+
+/**
+ * Report a problem with a behavior's parallel updates, once for each behavior and problem.
+ */
+static void report_parallel_update_problem(struct Object *obj, s32 problem, struct Object *other) {
+    static const char *const sProblemNames[] = {
+        "wrote another object",
+        "wrote Mario's state",
+        "used the random seed",
+        "spawned or unloaded an object",
+        "gave a different result when updated in parallel",
+    };
+    static struct {
+        const BehaviorScript *behavior;
+        s32 problem;
+    } sReported[128];
+    static s32 sNumReported = 0;
+    s32 i;
+
+    for (i = 0; i < sNumReported; i++) {
+        if (sReported[i].behavior == obj->behavior && sReported[i].problem == problem) {
+            return;
+        }
+    }
+    if (sNumReported < (s32) ARRAY_COUNT(sReported)) {
+        sReported[sNumReported].behavior = obj->behavior;
+        sReported[sNumReported].problem = problem;
+        sNumReported++;
+    }
+
+    if (other != NULL) {
+        fprintf(stderr, "parallel update: behavior %p %s (behavior %p)\n", (void *) obj->behavior,
+                sProblemNames[problem], (void *) other->behavior);
+    } else {
+        fprintf(stderr, "parallel update: behavior %p %s\n", (void *) obj->behavior,
+                sProblemNames[problem]);
+    }
+}
+
+static void *grow_check_array(void *array, s32 capacity, size_t size) {
+    array = realloc(array, capacity * size);
+    if (array == NULL) {
+        abort();
+    }
+    return array;
+}
+
+/**
+ * Take a copy of every object in the lists, and of the other state that the object being
+ * checked must leave alone.
+ */
+static void snapshot_objects_for_check(struct ParallelUpdateCheck *check) {
+    struct ObjectNode *list, *node;
+    s32 i;
+
+    check->numObjects = 0;
+    for (i = 0; i < NUM_OBJ_LISTS; i++) {
+        list = &gObjectListArray[i];
+        for (node = list->next; node != list; node = node->next) {
+            if (check->numObjects == check->objectCapacity) {
+                check->objectCapacity = check->objectCapacity != 0 ? check->objectCapacity * 2 : 256;
+                check->objects = grow_check_array(check->objects, check->objectCapacity,
+                                                  sizeof(struct Object *));
+                check->before = grow_check_array(check->before, check->objectCapacity,
+                                                 sizeof(struct Object));
+            }
+            check->objects[check->numObjects] = (struct Object *) node;
+            memcpy(&check->before[check->numObjects], node, sizeof(struct Object));
+            check->numObjects++;
+        }
+    }
+
+    memcpy(&check->marioState, &gMarioStates[0], sizeof(struct MarioState));
+    check->randomSeed = get_random_seed();
+    check->poolUsed = gObjectPoolUsed;
+}
+
+/**
+ * Report what the update of obj changed besides obj itself.
+ */
+static void check_parallel_update_writes(struct ParallelUpdateCheck *check, struct Object *obj) {
+    s32 i;
+
+    for (i = 0; i < check->numObjects; i++) {
+        if (check->objects[i] != obj
+            && memcmp(&check->before[i], check->objects[i], sizeof(struct Object)) != 0) {
+            report_parallel_update_problem(obj, PARALLEL_UPDATE_WROTE_OBJECT, check->objects[i]);
+        }
+    }
+
+    if (memcmp(&check->marioState, &gMarioStates[0], sizeof(struct MarioState)) != 0) {
+        report_parallel_update_problem(obj, PARALLEL_UPDATE_WROTE_MARIO, NULL);
+    }
+    if (check->randomSeed != get_random_seed()) {
+        report_parallel_update_problem(obj, PARALLEL_UPDATE_USED_RANDOM, NULL);
+    }
+    if (check->poolUsed != gObjectPoolUsed) {
+        report_parallel_update_problem(obj, PARALLEL_UPDATE_SPAWNED, NULL);
+    }
+}
+#endif
+
+/**
+ * Update the objects in the list whose behavior allows it together on the worker threads, and
+ * put them back as they were. The rest of the list's update gives them their results in list
+ * order.
+ */
+static void update_parallel_objects_in_list(struct ObjectNode *objList) {
+    struct ParallelUpdateSlot *slots;
+    struct ObjectNode *node;
+    struct Object *obj;
+    s32 count = 0;
+    s32 i;
+
+    for (node = objList->next; node != objList; node = node->next) {
+        obj = (struct Object *) node;
+        if (!(obj->oFlags & OBJ_FLAG_PARALLEL_UPDATE)) {
+            continue;
+        }
+
+        if (count == sParallelUpdateSlotCapacity) {
+            i = sParallelUpdateSlotCapacity;
+            sParallelUpdateSlotCapacity = i != 0 ? i * 2 : 64;
+            slots = realloc(sParallelUpdateSlots, sParallelUpdateSlotCapacity * sizeof(*slots));
+            if (slots == NULL) {
+                abort();
+            }
+            sParallelUpdateSlots = slots;
+            memset(&slots[i], 0, (sParallelUpdateSlotCapacity - i) * sizeof(*slots));
+        }
+
+        obj->parallelUpdateSlot = count + 1;
+        sParallelUpdateSlots[count].obj = obj;
+        sParallelUpdateSlots[count].numDeferred = 0;
+        memcpy(&sParallelUpdateSlots[count].before, obj, sizeof(struct Object));
+        count++;
+    }
+
+    if (count == 0) {
+        return;
+    }
+    slots = sParallelUpdateSlots;
+
+#if defined(BEHAVIOR_PROFILER) && !defined(PARALLEL_OBJECT_UPDATE_CHECK)
+    // The profiler isn't thread safe, so profiling builds run the phase on this thread.
+    update_parallel_objects_range(slots, 0, count);
+#else
+    thread_pool_run(update_parallel_objects_range, slots, count, PARALLEL_UPDATE_MIN_PER_THREAD);
+#endif
+
+    for (i = 0; i < count; i++) {
+        memcpy(&slots[i].after, slots[i].obj, sizeof(struct Object));
+        memcpy(slots[i].obj, &slots[i].before, sizeof(struct Object));
+    }
+}
+
+/**
+ * Give an object of the parallel phase its result, now that the list's update has got to it,
+ * and run what it deferred. If an object before it in the list has changed it since the phase,
+ * it is updated again here instead.
+ */
+static void finish_parallel_update(struct Object *obj) {
+    struct ParallelUpdateSlot *slot = &sParallelUpdateSlots[obj->parallelUpdateSlot - 1];
+    s32 i;
+
+#ifdef PARALLEL_OBJECT_UPDATE_CHECK
+    // Update it one more time here, as the original game does, and keep that result. The
+    // parallel result would only have been used if no object before it changed it.
+    s32 parallelNumDeferred = slot->numDeferred;
+    s32 unchanged = object_state_equals(obj, &slot->before);
+
+    snapshot_objects_for_check(&sParallelUpdateCheck);
+    slot->numDeferred = 0;
+    update_parallel_objects_range(slot, 0, 1);
+    check_parallel_update_writes(&sParallelUpdateCheck, obj);
+
+    if (unchanged && (!object_state_equals(obj, &slot->after) || slot->numDeferred != parallelNumDeferred)) {
+        report_parallel_update_problem(obj, PARALLEL_UPDATE_DIFFERED, NULL);
+    }
+#else
+    if (object_state_equals(obj, &slot->before)) {
+        copy_object_state(obj, &slot->after);
+    } else {
+        slot->numDeferred = 0;
+        update_parallel_objects_range(slot, 0, 1);
+    }
+#endif
+
+    obj->parallelUpdateSlot = 0;
+    gNumRoomedObjectsInMarioRoom += slot->inMarioRoom;
+    gNumRoomedObjectsNotInMarioRoom += slot->notInMarioRoom;
+
+    gCurrentObject = obj;
+    for (i = 0; i < slot->numDeferred; i++) {
+        slot->deferred[i]();
+    }
+}
+#endif
+
 /**
  * Update every object that occurs after firstObj in the given object list,
  * including firstObj itself. Return the number of objects that were updated.
@@ -295,12 +727,46 @@ void bhv_mario_update(void) {
 s32 update_objects_starting_at(struct ObjectNode *objList, struct ObjectNode *firstObj) {
     s32 count = 0;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    if (gNumPendingParticles != 0) {
+        run_pending_particles(firstObj->prev, FALSE);
+    }
+#endif
+
     while (objList != firstObj) {
         gCurrentObject = (struct Object *) firstObj;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+        // Already updated in the list's parallel phase
+        if (gCurrentObject->parallelUpdateSlot != 0) {
+            finish_parallel_update(gCurrentObject);
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+            if (gNumPendingParticles != 0) {
+                run_pending_particles(firstObj, FALSE);
+            }
+#endif
+            firstObj = firstObj->next;
+            count += 1;
+            continue;
+        }
+#endif
+
         gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+        gCurrentObjectUpdateFrames = get_object_update_frames(gCurrentObject);
+        if (gCurrentObjectUpdateFrames != 0) {
+            cur_obj_update();
+        }
+        gCurrentObjectUpdateFrames = 1;
+#else
         cur_obj_update();
+#endif
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+        if (gNumPendingParticles != 0) {
+            run_pending_particles(firstObj, FALSE);
+        }
+#endif
         firstObj = firstObj->next;
         count += 1;
     }
@@ -321,6 +787,12 @@ s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNod
     s32 count = 0;
     s32 unfrozen;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    if (gNumPendingParticles != 0) {
+        run_pending_particles(firstObj->prev, TRUE);
+    }
+#endif
+
     while (objList != firstObj) {
         gCurrentObject = (struct Object *) firstObj;
 
@@ -351,6 +823,11 @@ s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNod
             gCurrentObject->header.gfx.node.flags &= ~GRAPH_RENDER_HAS_ANIMATION;
         }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+        if (gNumPendingParticles != 0) {
+            run_pending_particles(firstObj, TRUE);
+        }
+#endif
         firstObj = firstObj->next;
         count++;
     }
@@ -367,6 +844,9 @@ s32 update_objects_in_list(struct ObjectNode *objList) {
     struct ObjectNode *firstObj = objList->next;
 
     if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+        update_parallel_objects_in_list(objList);
+#endif
         count = update_objects_starting_at(objList, firstObj);
     } else {
         count = update_objects_during_time_stop(objList, firstObj);
@@ -447,6 +927,10 @@ void unload_objects_from_area(UNUSED s32 unused, s32 areaIndex) {
             }
         }
     }
+
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    unload_particles_from_area(areaIndex);
+#endif
 }
 
 /**
@@ -546,6 +1030,9 @@ void clear_objects(void) {
     init_free_object_list();
 #endif
     clear_object_lists(gObjectListArray);
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    clear_particles();
+#endif
 
     stub_behavior_script_2();
     stub_obj_list_processor_1();
@@ -645,6 +1132,17 @@ void update_objects(UNUSED s32 unused) {
 
     gObjectLists = gObjectListArray;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+    // Frames with time stop don't count, so that far objects don't catch up on them.
+    if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
+        sObjectUpdateFrame++;
+    }
+#endif
+
+#if defined(USE_SYSTEM_MALLOC) && defined(COLLISION_PROFILER)
+    collision_profiler_set_object_updates(TRUE);
+#endif
+
     // If time stop is not active, unload object surfaces
     cycleCounts[1] = get_clock_difference(cycleCounts[0]);
     clear_dynamic_surfaces();
@@ -666,6 +1164,9 @@ void update_objects(UNUSED s32 unused) {
     // Update all other objects that haven't been updated yet
     cycleCounts[4] = get_clock_difference(cycleCounts[0]);
     update_non_terrain_objects();
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    update_particles();
+#endif
 
     // Unload any objects that have been deactivated
     cycleCounts[5] = get_clock_difference(cycleCounts[0]);
@@ -677,6 +1178,13 @@ void update_objects(UNUSED s32 unused) {
 
     cycleCounts[7] = get_clock_difference(cycleCounts[0]);
 
+#if defined(USE_SYSTEM_MALLOC) && defined(COLLISION_PROFILER)
+    collision_profiler_set_object_updates(FALSE);
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+    behavior_profiler_end_frame(cycleCounts);
+#endif
+
     cycleCounts[0] = 0;
     try_print_debug_mario_object_info();
 
@@ -71,6 +71,9 @@ struct NumTimesCalled {
     /*0x00*/ s16 floor;
     /*0x02*/ s16 ceil;
     /*0x04*/ s16 wall;
+#ifndef TARGET_N64
+    s16 ray;
+#endif
 };
 
 extern struct NumTimesCalled gNumCalls;
@@ -86,9 +89,23 @@ extern struct ObjectNode gFreeObjectList;
 
 extern struct Object *gMarioObject;
 extern struct Object *gLuigiObject;
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+// Each thread updating objects has its own current object.
+extern __thread struct Object *gCurrentObject;
+
+extern __thread const BehaviorScript *gCurBhvCommand;
+#else
 extern struct Object *gCurrentObject;
 
 extern const BehaviorScript *gCurBhvCommand;
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+#ifdef PARALLEL_OBJECT_UPDATES
+extern __thread s32 gCurrentObjectUpdateFrames;
+#else
+extern s32 gCurrentObjectUpdateFrames;
+#endif
+#endif
 extern s16 gPrevFrameObjectCount;
 
 extern s32 gSurfaceNodesAllocated;
@@ -110,8 +127,13 @@ extern s16 gTHIWaterDrained;
 extern s16 gTTCSpeedSetting;
 extern s16 gMarioShotFromCannon;
 extern s16 gCCMEnteredSlide;
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+extern __thread s16 gNumRoomedObjectsInMarioRoom;
+extern __thread s16 gNumRoomedObjectsNotInMarioRoom;
+#else
 extern s16 gNumRoomedObjectsInMarioRoom;
 extern s16 gNumRoomedObjectsNotInMarioRoom;
+#endif
 extern s16 gWDWWaterLevelChanging;
 extern s16 gMarioOnMerryGoRound;
 
@@ -122,6 +144,11 @@ void unload_objects_from_area(UNUSED s32 unused, s32 areaIndex);
 void spawn_objects_from_info(UNUSED s32 unused, struct SpawnInfo *spawnInfo);
 void clear_objects(void);
 void update_objects(UNUSED s32 unused);
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+// Run func for the current object now, or, if it's being updated in the parallel phase, when the
+// rest of its list's update gets to it.
+void cur_obj_defer(void (*func)(void));
+#endif
 
 
 #endif // OBJECT_LIST_PROCESSOR_H
@@ -0,0 +1,620 @@
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "area.h"
+#include "behavior_data.h"
+#include "engine/behavior_script.h"
+#include "engine/graph_node.h"
+#include "engine/math_util.h"
+#include "model_ids.h"
+#include "object_list_processor.h"
+#include "particle_system.h"
+
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+/**
+ * How a type of particle moves, and the behavior it stands in for.
+ */
+enum ParticleKind {
+    PARTICLE_KIND_PUFF,      // bhvWhitePuffExplosion
+    PARTICLE_KIND_MIST,      // bhvWhitePuff1
+    PARTICLE_KIND_ANIMATION, // bhvWhitePuff2, bhvSparkle and bhvSparkleParticleSpawner
+};
+
+/**
+ * The arrays each type keeps, one element per particle.
+ */
+enum ParticleArray {
+    PARTICLE_ARRAY_POS_X,
+    PARTICLE_ARRAY_POS_Y,
+    PARTICLE_ARRAY_POS_Z,
+    PARTICLE_ARRAY_VEL_X,
+    PARTICLE_ARRAY_VEL_Y,
+    PARTICLE_ARRAY_VEL_Z,
+    PARTICLE_ARRAY_GRAVITY,
+    PARTICLE_ARRAY_DRAG,
+    PARTICLE_ARRAY_SCALE,
+    PARTICLE_ARRAY_BASE_SCALE,
+    PARTICLE_ARRAY_OPACITY,
+    PARTICLE_ARRAY_OPACITY_STEP,
+    PARTICLE_ARRAY_FADE_IN,
+    PARTICLE_ARRAY_TIMER,
+    PARTICLE_ARRAY_AREA_INDEX,
+    PARTICLE_ARRAY_KEEP,
+    NUM_PARTICLE_ARRAYS
+};
+
+static const u8 sParticleArraySizes[NUM_PARTICLE_ARRAYS] = {
+    sizeof(f32), sizeof(f32), sizeof(f32), // pos
+    sizeof(f32), sizeof(f32), sizeof(f32), // vel
+    sizeof(f32), sizeof(f32),              // gravity, drag
+    sizeof(f32), sizeof(f32),              // scale, base scale
+    sizeof(s32), sizeof(s32), sizeof(s8),  // opacity, opacity step, fade in
+    sizeof(s16), sizeof(s8), sizeof(u8),   // timer, area index, keep
+};
+
+struct ParticleBuffer {
+    s16 kind;
+    s16 model;
+    s16 numFrames;
+    s16 unimportant;
+    f32 graphYOffset;
+    s32 count;
+    s32 capacity;
+    void *arrays[NUM_PARTICLE_ARRAYS];
+};
+
+s32 gNumParticleTypes = 0;
+static s32 sParticleTypeCapacity = 0;
+static struct ParticleBuffer *sParticleBuffers = NULL;
+
+static struct Object sParticleProxy;
+static u8 sParticleProxyInitialized = FALSE;
+
+/**
+ * The objects that Mario's dust and sparkles stand in for, which take their random offsets on
+ * their first update.
+ */
+enum PendingObject {
+    PENDING_MIST_SPAWNER,   // bhvMistParticleSpawner, spawns the two below
+    PENDING_WHITE_PUFF_1,   // bhvWhitePuff1
+    PENDING_WHITE_PUFF_2,   // bhvWhitePuff2
+    PENDING_SPARKLE_SPAWNER // bhvSparkleParticleSpawner
+};
+
+/**
+ * The first update of one of those objects, waiting for the object list to get to where the
+ * object would be. Particles are referred to by type and index, and an index of -1 means the
+ * particle has been removed.
+ */
+struct PendingParticle {
+    struct ObjectNode *list;
+    struct ObjectNode *after; // the object it would follow, or the list itself if none
+    s32 object;
+    s32 types[2];
+    s32 indices[2];
+};
+
+s32 gNumPendingParticles = 0;
+static s32 sPendingParticleCapacity = 0;
+static struct PendingParticle *sPendingParticles = NULL;
+
+/**
+ * Return the buffer of the given type of particle, adding it if there isn't one yet.
+ */
+static struct ParticleBuffer *get_particle_buffer(s32 kind, s32 model, s32 numFrames,
+                                                  f32 graphYOffset, s32 unimportant) {
+    struct ParticleBuffer *buf;
+    s32 i;
+
+    for (i = 0; i < gNumParticleTypes; i++) {
+        buf = &sParticleBuffers[i];
+        if (buf->kind == kind && buf->model == model && buf->numFrames == numFrames
+            && buf->unimportant == unimportant) {
+            return buf;
+        }
+    }
+
+    if (gNumParticleTypes == sParticleTypeCapacity) {
+        sParticleTypeCapacity = sParticleTypeCapacity != 0 ? sParticleTypeCapacity * 2 : 16;
+        sParticleBuffers = realloc(sParticleBuffers, sParticleTypeCapacity * sizeof(struct ParticleBuffer));
+    }
+
+    buf = &sParticleBuffers[gNumParticleTypes++];
+    memset(buf, 0, sizeof(struct ParticleBuffer));
+    buf->kind = kind;
+    buf->model = model;
+    buf->numFrames = numFrames;
+    buf->graphYOffset = graphYOffset;
+    buf->unimportant = unimportant;
+    return buf;
+}
+
+/**
+ * Add a particle at the parent's position, in its area, and return its index. Everything else
+ * starts at 0.
+ */
+static s32 add_particle(struct ParticleBuffer *buf, struct Object *parent) {
+    s32 index;
+    s32 i;
+
+    if (buf->count == buf->capacity) {
+        buf->capacity = buf->capacity != 0 ? buf->capacity * 2 : 32;
+        for (i = 0; i < NUM_PARTICLE_ARRAYS; i++) {
+            buf->arrays[i] = realloc(buf->arrays[i], buf->capacity * sParticleArraySizes[i]);
+        }
+    }
+
+    index = buf->count++;
+    for (i = 0; i < NUM_PARTICLE_ARRAYS; i++) {
+        memset((u8 *) buf->arrays[i] + index * sParticleArraySizes[i], 0, sParticleArraySizes[i]);
+    }
+
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_X])[index] = parent->oPosX;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Y])[index] = parent->oPosY;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Z])[index] = parent->oPosZ;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_SCALE])[index] = 1.0f;
+    ((s8 *) buf->arrays[PARTICLE_ARRAY_AREA_INDEX])[index] = parent->header.gfx.areaIndex;
+    return index;
+}
+
+/**
+ * Point the pending particles of the buffer at the indices their particles will have once the
+ * ones whose keep flag is clear are removed.
+ */
+static void move_pending_particle_indices(struct ParticleBuffer *buf) {
+    u8 *keep = buf->arrays[PARTICLE_ARRAY_KEEP];
+    s32 type = buf - sParticleBuffers;
+    s32 *index;
+    s32 i, j, k;
+
+    for (i = 0; i < gNumPendingParticles; i++) {
+        for (j = 0; j < 2; j++) {
+            index = &sPendingParticles[i].indices[j];
+            if (sPendingParticles[i].types[j] != type || *index < 0) {
+                continue;
+            }
+
+            if (!keep[*index]) {
+                *index = -1;
+            } else {
+                for (k = *index - 1; k >= 0; k--) {
+                    if (!keep[k]) {
+                        (*index)--;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Remove the particles whose keep flag is clear, leaving the rest in the order they were added.
+ */
+static void remove_particles(struct ParticleBuffer *buf) {
+    u8 *keep = buf->arrays[PARTICLE_ARRAY_KEEP];
+    s32 count = 0;
+    s32 i, j;
+
+    if (gNumPendingParticles != 0) {
+        move_pending_particle_indices(buf);
+    }
+
+    for (i = 0; i < buf->count; i++) {
+        if (keep[i]) {
+            if (count != i) {
+                for (j = 0; j < NUM_PARTICLE_ARRAYS; j++) {
+                    memcpy((u8 *) buf->arrays[j] + count * sParticleArraySizes[j],
+                           (u8 *) buf->arrays[j] + i * sParticleArraySizes[j], sParticleArraySizes[j]);
+                }
+            }
+            count++;
+        }
+    }
+
+    buf->count = count;
+}
+
+void spawn_puff_particle(struct Object *parent, s32 model, s32 behParam, s16 yaw, f32 forwardVel,
+                         f32 velY, f32 gravity, f32 drag, f32 offsetY, f32 scale) {
+    struct ParticleBuffer *buf = get_particle_buffer(PARTICLE_KIND_PUFF, model, 0, 0.0f, TRUE);
+    s32 i = add_particle(buf, parent);
+
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Y])[i] += offsetY;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_VEL_X])[i] = forwardVel * sins(yaw);
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_VEL_Y])[i] = velY;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_VEL_Z])[i] = forwardVel * coss(yaw);
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_GRAVITY])[i] = gravity;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_DRAG])[i] = drag;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_SCALE])[i] = scale;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_BASE_SCALE])[i] = scale;
+
+    switch (behParam) {
+        case 2:
+            ((s32 *) buf->arrays[PARTICLE_ARRAY_OPACITY])[i] = 254;
+            ((s32 *) buf->arrays[PARTICLE_ARRAY_OPACITY_STEP])[i] = -21;
+            ((s8 *) buf->arrays[PARTICLE_ARRAY_FADE_IN])[i] = FALSE;
+            break;
+        case 3:
+            ((s32 *) buf->arrays[PARTICLE_ARRAY_OPACITY])[i] = 254;
+            ((s32 *) buf->arrays[PARTICLE_ARRAY_OPACITY_STEP])[i] = -13;
+            ((s8 *) buf->arrays[PARTICLE_ARRAY_FADE_IN])[i] = TRUE;
+            break;
+    }
+}
+
+void spawn_sparkle_particle(struct Object *parent) {
+    struct ParticleBuffer *buf =
+        get_particle_buffer(PARTICLE_KIND_ANIMATION, MODEL_SPARKLES_ANIMATION, 9, 0.0f, TRUE);
+    s32 i = add_particle(buf, parent);
+
+    // Same as obj_translate_xyz_random and obj_scale_random, with the game's random numbers.
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_X])[i] += random_float() * 90.0f - 90.0f * 0.5f;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Y])[i] += random_float() * 90.0f - 90.0f * 0.5f;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Z])[i] += random_float() * 90.0f - 90.0f * 0.5f;
+    ((f32 *) buf->arrays[PARTICLE_ARRAY_SCALE])[i] = random_float() * 1.0f + 0.0f;
+}
+
+/**
+ * Queue the first update of an object that would be spawned into the given list now, at the
+ * end of it.
+ */
+static void add_pending_particle(s32 listIndex, s32 object, s32 type0, s32 index0, s32 type1,
+                                 s32 index1) {
+    struct PendingParticle *pending;
+
+    if (gNumPendingParticles == sPendingParticleCapacity) {
+        sPendingParticleCapacity = sPendingParticleCapacity != 0 ? sPendingParticleCapacity * 2 : 16;
+        sPendingParticles =
+            realloc(sPendingParticles, sPendingParticleCapacity * sizeof(struct PendingParticle));
+    }
+
+    pending = &sPendingParticles[gNumPendingParticles++];
+    pending->list = &gObjectLists[listIndex];
+    pending->after = gObjectLists[listIndex].prev;
+    pending->object = object;
+    pending->types[0] = type0;
+    pending->indices[0] = index0;
+    pending->types[1] = type1;
+    pending->indices[1] = index1;
+}
+
+static f32 *get_particle_pos(s32 type, s32 index, s32 axis) {
+    return &((f32 *) sParticleBuffers[type].arrays[PARTICLE_ARRAY_POS_X + axis])[index];
+}
+
+/**
+ * Do what the object does on its first update that concerns its particles, drawing the game's
+ * random numbers in the same order.
+ */
+static void run_pending_particle(struct PendingParticle *pending) {
+    s32 type = pending->types[0];
+    s32 index = pending->indices[0];
+
+    switch (pending->object) {
+        case PENDING_MIST_SPAWNER:
+            // SPAWN_CHILD bhvWhitePuff1, then bhvWhitePuff2
+            add_pending_particle(OBJ_LIST_DEFAULT, PENDING_WHITE_PUFF_1, type, index, -1, -1);
+            add_pending_particle(OBJ_LIST_UNIMPORTANT, PENDING_WHITE_PUFF_2, pending->types[1],
+                                 pending->indices[1], -1, -1);
+            break;
+        case PENDING_WHITE_PUFF_1:
+            // bhv_white_puff_1_loop
+            *get_particle_pos(type, index, 0) += random_float() * 40.0f - 40.0f * 0.5f;
+            *get_particle_pos(type, index, 2) += random_float() * 40.0f - 40.0f * 0.5f;
+            *get_particle_pos(type, index, 1) += 30.0f;
+            break;
+        case PENDING_WHITE_PUFF_2:
+            // bhv_white_puff_2_loop
+            *get_particle_pos(type, index, 0) += random_float() * 40.0f - 40.0f * 0.5f;
+            *get_particle_pos(type, index, 2) += random_float() * 40.0f - 40.0f * 0.5f;
+            break;
+        case PENDING_SPARKLE_SPAWNER:
+            // SET_RANDOM_FLOAT and SUM_FLOAT for x, z and y
+            *get_particle_pos(type, index, 0) += 100.0f * random_float() + -50.0f;
+            *get_particle_pos(type, index, 2) += 100.0f * random_float() + -50.0f;
+            *get_particle_pos(type, index, 1) += 100.0f * random_float() + -50.0f;
+            break;
+    }
+}
+
+void run_pending_particles(struct ObjectNode *after, s32 timeStop) {
+    struct PendingParticle pending;
+    s32 i;
+
+    // Objects queued while these run come after them, and are run in the same loop.
+    for (i = 0; i < gNumPendingParticles; i++) {
+        pending = sPendingParticles[i];
+        if (pending.after != after) {
+            continue;
+        }
+
+        // Same as update_objects_during_time_stop, for objects that aren't Mario or doors.
+        if (timeStop && (pending.list != &gObjectLists[OBJ_LIST_UNIMPORTANT]
+                         || (gTimeStopState & TIME_STOP_ALL_OBJECTS))) {
+            continue;
+        }
+
+        memmove(&sPendingParticles[i], &sPendingParticles[i + 1],
+                (gNumPendingParticles - i - 1) * sizeof(struct PendingParticle));
+        gNumPendingParticles--;
+        i--;
+
+        if (pending.indices[0] >= 0 && (pending.types[1] < 0 || pending.indices[1] >= 0)) {
+            run_pending_particle(&pending);
+        }
+    }
+}
+
+void move_pending_particles(struct ObjectNode *node) {
+    s32 i;
+
+    for (i = 0; i < gNumPendingParticles; i++) {
+        if (sPendingParticles[i].after == node) {
+            sPendingParticles[i].after = node->prev;
+        }
+    }
+}
+
+s32 spawn_mario_particle(struct Object *mario, const BehaviorScript *behavior) {
+    struct ParticleBuffer *buf;
+    s32 mistType, mistIndex;
+    s32 i;
+
+    // The spawners are in OBJ_LIST_DEFAULT, which is updated after Mario's list.
+    if (behavior == bhvMistParticleSpawner) {
+        buf = get_particle_buffer(PARTICLE_KIND_MIST, MODEL_MIST, 0, 0.0f, FALSE);
+        mistType = buf - sParticleBuffers;
+        mistIndex = add_particle(buf, mario);
+
+        buf = get_particle_buffer(PARTICLE_KIND_ANIMATION, MODEL_SMOKE, 7, 0.0f, TRUE);
+        i = add_particle(buf, mario);
+        add_pending_particle(OBJ_LIST_DEFAULT, PENDING_MIST_SPAWNER, mistType, mistIndex,
+                             buf - sParticleBuffers, i);
+        return TRUE;
+    }
+
+    if (behavior == bhvSparkleParticleSpawner) {
+        buf = get_particle_buffer(PARTICLE_KIND_ANIMATION, MODEL_SPARKLES, 12, 25.0f, FALSE);
+        i = add_particle(buf, mario);
+        add_pending_particle(OBJ_LIST_DEFAULT, PENDING_SPARKLE_SPAWNER, buf - sParticleBuffers, i,
+                             -1, -1);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Same as apply_drag_to_value in object_helpers.c.
+ */
+static f32 apply_particle_drag(f32 value, f32 dragStrength) {
+    f32 decel;
+
+    if (value != 0) {
+        decel = value * value * (dragStrength * 0.0001L);
+
+        if (value > 0) {
+            value -= decel;
+            if (value < 0.001L) {
+                value = 0;
+            }
+        } else {
+            value += decel;
+            if (value > -0.001L) {
+                value = 0;
+            }
+        }
+    }
+
+    return value;
+}
+
+/**
+ * Update puffs like bhv_white_puff_exploding_loop. Velocity and gravity are applied to the whole
+ * type first, several particles at a time.
+ */
+static void update_puff_particles(struct ParticleBuffer *buf) {
+    f32 *posX = buf->arrays[PARTICLE_ARRAY_POS_X];
+    f32 *posY = buf->arrays[PARTICLE_ARRAY_POS_Y];
+    f32 *posZ = buf->arrays[PARTICLE_ARRAY_POS_Z];
+    f32 *velX = buf->arrays[PARTICLE_ARRAY_VEL_X];
+    f32 *velY = buf->arrays[PARTICLE_ARRAY_VEL_Y];
+    f32 *velZ = buf->arrays[PARTICLE_ARRAY_VEL_Z];
+    f32 *gravity = buf->arrays[PARTICLE_ARRAY_GRAVITY];
+    f32 *drag = buf->arrays[PARTICLE_ARRAY_DRAG];
+    f32 *scale = buf->arrays[PARTICLE_ARRAY_SCALE];
+    f32 *baseScale = buf->arrays[PARTICLE_ARRAY_BASE_SCALE];
+    s32 *opacity = buf->arrays[PARTICLE_ARRAY_OPACITY];
+    s32 *opacityStep = buf->arrays[PARTICLE_ARRAY_OPACITY_STEP];
+    s8 *fadeIn = buf->arrays[PARTICLE_ARRAY_FADE_IN];
+    s16 *timer = buf->arrays[PARTICLE_ARRAY_TIMER];
+    u8 *keep = buf->arrays[PARTICLE_ARRAY_KEEP];
+    s32 count = buf->count;
+    s32 i = 0;
+
+    // cur_obj_move_using_vel_and_gravity
+#ifdef __SSE2__
+    for (; i + 4 <= count; i += 4) {
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(velY + i), _mm_loadu_ps(gravity + i));
+
+        _mm_storeu_ps(posX + i, _mm_add_ps(_mm_loadu_ps(posX + i), _mm_loadu_ps(velX + i)));
+        _mm_storeu_ps(posZ + i, _mm_add_ps(_mm_loadu_ps(posZ + i), _mm_loadu_ps(velZ + i)));
+        _mm_storeu_ps(velY + i, vy);
+        _mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), vy));
+    }
+#endif
+    for (; i < count; i++) {
+        posX[i] += velX[i];
+        posZ[i] += velZ[i];
+        velY[i] += gravity[i];
+        posY[i] += velY[i];
+    }
+
+    for (i = 0; i < count; i++) {
+        velX[i] = apply_particle_drag(velX[i], drag[i]);
+        velZ[i] = apply_particle_drag(velZ[i], drag[i]);
+        if (velY[i] > 100.0f) {
+            velY[i] = 100.0f;
+        }
+
+        keep[i] = timer[i] <= 20;
+
+        if (opacity[i] != 0) {
+            opacity[i] += opacityStep[i];
+            if (opacity[i] < 2) {
+                keep[i] = FALSE;
+            }
+            if (fadeIn[i]) {
+                scale[i] = baseScale[i] * ((254 - opacity[i]) / 254.0);
+            } else {
+                scale[i] = baseScale[i] * (opacity[i] / 254.0);
+            }
+        }
+
+        timer[i]++;
+    }
+}
+
+/**
+ * Update the mist of Mario's dust like bhv_white_puff_1_loop.
+ */
+static void update_mist_particles(struct ParticleBuffer *buf) {
+    f32 *scale = buf->arrays[PARTICLE_ARRAY_SCALE];
+    s16 *timer = buf->arrays[PARTICLE_ARRAY_TIMER];
+    u8 *keep = buf->arrays[PARTICLE_ARRAY_KEEP];
+    s32 i;
+
+    for (i = 0; i < buf->count; i++) {
+        scale[i] = timer[i] * 0.5f + 0.1f;
+        keep[i] = timer[i] <= 4;
+        timer[i]++;
+    }
+}
+
+/**
+ * Update particles that show one frame of their model per update, like a behavior that adds 1
+ * to oAnimState in a BEGIN_REPEAT and deactivates after it.
+ */
+static void update_animation_particles(struct ParticleBuffer *buf) {
+    s16 *timer = buf->arrays[PARTICLE_ARRAY_TIMER];
+    u8 *keep = buf->arrays[PARTICLE_ARRAY_KEEP];
+    s32 i;
+
+    for (i = 0; i < buf->count; i++) {
+        keep[i] = timer[i] < buf->numFrames;
+        timer[i]++;
+    }
+}
+
+/**
+ * Update every particle once, after the objects. During time stop, only the types that stand in
+ * for objects in OBJ_LIST_UNIMPORTANT are updated, unless every object is stopped.
+ */
+void update_particles(void) {
+    struct ParticleBuffer *buf;
+    s32 i;
+
+    for (i = 0; i < gNumParticleTypes; i++) {
+        buf = &sParticleBuffers[i];
+
+        if ((gTimeStopState & TIME_STOP_ACTIVE)
+            && (!buf->unimportant || (gTimeStopState & TIME_STOP_ALL_OBJECTS))) {
+            continue;
+        }
+
+        switch (buf->kind) {
+            case PARTICLE_KIND_PUFF:
+                update_puff_particles(buf);
+                break;
+            case PARTICLE_KIND_MIST:
+                update_mist_particles(buf);
+                break;
+            case PARTICLE_KIND_ANIMATION:
+                update_animation_particles(buf);
+                break;
+        }
+
+        remove_particles(buf);
+    }
+}
+
+/**
+ * Remove every particle. The buffers are kept for the next level.
+ */
+void clear_particles(void) {
+    s32 i;
+
+    for (i = 0; i < gNumParticleTypes; i++) {
+        sParticleBuffers[i].count = 0;
+    }
+    gNumPendingParticles = 0;
+}
+
+void unload_particles_from_area(s32 areaIndex) {
+    struct ParticleBuffer *buf;
+    s8 *particleArea;
+    u8 *keep;
+    s32 i, j;
+
+    for (i = 0; i < gNumParticleTypes; i++) {
+        buf = &sParticleBuffers[i];
+        particleArea = buf->arrays[PARTICLE_ARRAY_AREA_INDEX];
+        keep = buf->arrays[PARTICLE_ARRAY_KEEP];
+
+        for (j = 0; j < buf->count; j++) {
+            keep[j] = particleArea[j] != areaIndex;
+        }
+        remove_particles(buf);
+    }
+}
+
+/**
+ * Set up the proxy object to draw a particle. It's an object with just enough set for the
+ * particle's model and its geo functions, set up again for the first particle of each type.
+ */
+struct Object *get_particle_proxy(s32 type, s32 index) {
+    struct ParticleBuffer *buf = &sParticleBuffers[type];
+    struct Object *proxy = &sParticleProxy;
+    struct GraphNode *model = gLoadedGraphNodes[buf->model];
+    s32 frame;
+
+    if (index >= buf->count || model == NULL) {
+        return NULL;
+    }
+
+    if (!sParticleProxyInitialized) {
+        init_graph_node_object(NULL, &proxy->header.gfx, NULL, gVec3fZero, gVec3sZero, gVec3fOne);
+        sParticleProxyInitialized = TRUE;
+    }
+
+    if (index == 0) {
+        geo_obj_init(&proxy->header.gfx, model, gVec3fZero, gVec3sZero);
+        proxy->header.gfx.node.flags |= GRAPH_RENDER_BILLBOARD;
+        proxy->oOpacity = buf->kind == PARTICLE_KIND_MIST ? 50 : 0;
+    }
+
+    // The timer has already counted the update that is being drawn.
+    frame = ((s16 *) buf->arrays[PARTICLE_ARRAY_TIMER])[index] - 1;
+
+    proxy->header.gfx.pos[0] = ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_X])[index];
+    proxy->header.gfx.pos[1] = ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Y])[index] + buf->graphYOffset;
+    proxy->header.gfx.pos[2] = ((f32 *) buf->arrays[PARTICLE_ARRAY_POS_Z])[index];
+    vec3f_set(proxy->header.gfx.scale, ((f32 *) buf->arrays[PARTICLE_ARRAY_SCALE])[index],
+              ((f32 *) buf->arrays[PARTICLE_ARRAY_SCALE])[index],
+              ((f32 *) buf->arrays[PARTICLE_ARRAY_SCALE])[index]);
+    proxy->header.gfx.areaIndex = ((s8 *) buf->arrays[PARTICLE_ARRAY_AREA_INDEX])[index];
+    proxy->header.gfx.activeAreaIndex = proxy->header.gfx.areaIndex;
+    proxy->oAnimState = buf->kind == PARTICLE_KIND_ANIMATION && frame > 0 ? frame : 0;
+    if (buf->kind == PARTICLE_KIND_PUFF) {
+        proxy->oOpacity = ((s32 *) buf->arrays[PARTICLE_ARRAY_OPACITY])[index];
+    }
+
+    return proxy;
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <PR/ultratypes.h>
+
+#include "types.h"
+
+// Particles that are kept outside the object pool, enabled with PARTICLE_SYSTEM in config.h.
+// Each type of particle, a kind of movement drawn with one model, has its own packed arrays that
+// are updated together once a frame after the objects, and drawn after the objects one type at a
+// time. They look and move like the objects they replace.
+
+// The puffs of cur_obj_spawn_particles (bhvWhitePuffExplosion), with the values it picked.
+void spawn_puff_particle(struct Object *parent, s32 model, s32 behParam, s16 yaw, f32 forwardVel,
+                         f32 velY, f32 gravity, f32 drag, f32 offsetY, f32 scale);
+// The sparkles of bhvSparkleSpawn (bhvSparkle).
+void spawn_sparkle_particle(struct Object *parent);
+// Mario's dust (bhvMistParticleSpawner) and sparkles (bhvSparkleParticleSpawner). Returns FALSE
+// if the behavior's particles aren't handled here and its spawner should be spawned as before.
+s32 spawn_mario_particle(struct Object *mario, const BehaviorScript *behavior);
+
+// The random offsets of Mario's dust and sparkles are drawn from the game's seed where the
+// objects they replace would have been updated, after the object (or list head) they would
+// follow. The object lists run the ones after each node as they go, and move them to the
+// previous node when an object is unloaded.
+extern s32 gNumPendingParticles;
+void run_pending_particles(struct ObjectNode *after, s32 timeStop);
+void move_pending_particles(struct ObjectNode *node);
+
+void update_particles(void);
+void clear_particles(void);
+void unload_particles_from_area(s32 areaIndex);
+
+// Rendering. Returns an object standing in for the given particle, or NULL past the last one.
+extern s32 gNumParticleTypes;
+struct Object *get_particle_proxy(s32 type, s32 index);
+
+#endif // PARTICLE_SYSTEM_H
@@ -9,7 +9,13 @@
 #include "print.h"
 #include "rendering_graph_node.h"
 #include "shadow.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+#include "particle_system.h"
+#endif
 #include "sm64.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE) && defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 /**
  * This file contains the code that processes the scene graph for rendering.
@@ -554,6 +560,168 @@ static void geo_process_background(struct GraphNodeBackground *node) {
     }
 }
 
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+#define POSE_CACHE_SIZE 64
+#define POSE_CACHE_MAX_JOINTS 32
+
+/**
+ * The joints of an animation at one frame, decoded by the first object drawn with it in a frame
+ * and reused by the others. Each joint is its rotation matrix with the raw animation translation
+ * in the last row, which is scaled by the object's translation multiplier and added to the
+ * part's own translation when it's drawn.
+ */
+struct AnimPose {
+    struct Animation *anim;
+    u32 renderFrame;
+    s16 frame;
+    s16 numJoints;
+    Mat4 joints[POSE_CACHE_MAX_JOINTS];
+};
+
+static struct AnimPose sPoseCache[POSE_CACHE_SIZE];
+static u32 sPoseRenderFrame;
+// The pose of the object being drawn, NULL if it isn't cached
+static struct AnimPose *sCurPose;
+static s32 sCurPoseJoint;
+static s32 sPoseHits;
+static s32 sPoseMisses;
+
+/**
+ * Find the pose for the current object's animation and frame, starting a new one if no object
+ * has been drawn with it yet this frame.
+ */
+static void geo_set_pose(struct Animation *anim, s16 frame) {
+    struct AnimPose *pose =
+        &sPoseCache[(((uintptr_t) anim >> 4) ^ (frame * 31)) & (POSE_CACHE_SIZE - 1)];
+
+    if (pose->renderFrame == sPoseRenderFrame && pose->anim == anim && pose->frame == frame) {
+        sPoseHits++;
+    } else {
+        pose->anim = anim;
+        pose->renderFrame = sPoseRenderFrame;
+        pose->frame = frame;
+        pose->numJoints = 0;
+        sPoseMisses++;
+    }
+    sCurPose = pose;
+    sCurPoseJoint = 0;
+}
+
+/**
+ * Decode the next joint of the current animation into 'joint', advancing the animation globals
+ * the same way geo_process_animated_part does.
+ */
+static void geo_decode_pose_joint(Mat4 joint) {
+    Vec3s rotation;
+    Vec3f offset;
+
+    vec3s_copy(rotation, gVec3sZero);
+    vec3f_copy(offset, gVec3fZero);
+    if (gCurAnimType == ANIM_TYPE_TRANSLATION) {
+        offset[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        offset[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        offset[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurAnimType == ANIM_TYPE_LATERAL_TRANSLATION) {
+        offset[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimAttribute += 2;
+        offset[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurAnimType == ANIM_TYPE_VERTICAL_TRANSLATION) {
+        gCurrAnimAttribute += 2;
+        offset[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimAttribute += 2;
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurAnimType == ANIM_TYPE_NO_TRANSLATION) {
+        gCurrAnimAttribute += 6;
+        gCurAnimType = ANIM_TYPE_ROTATION;
+    }
+
+    rotation[0] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    rotation[1] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    rotation[2] = gCurAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    mtxf_rotate_xyz_and_translate(joint, offset, rotation);
+}
+
+/**
+ * Set 'dest' to the joint, translated by 'translation' instead of its offset, times 'parent'.
+ * Same as mtxf_rotate_xyz_and_translate followed by mtxf_mul, with the float operations in the
+ * same order, so the result only differs where the compiler fuses mtxf_mul's multiply-adds.
+ */
+static void geo_mul_pose_joint(Mat4 dest, Mat4 joint, Vec3f translation, Mat4 parent) {
+#ifdef __SSE2__
+    __m128 p0 = _mm_loadu_ps(parent[0]);
+    __m128 p1 = _mm_loadu_ps(parent[1]);
+    __m128 p2 = _mm_loadu_ps(parent[2]);
+    __m128 p3 = _mm_loadu_ps(parent[3]);
+    s32 i;
+
+    for (i = 0; i < 3; i++) {
+        _mm_storeu_ps(dest[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(joint[i][0]), p0),
+                                                     _mm_mul_ps(_mm_set1_ps(joint[i][1]), p1)),
+                                          _mm_mul_ps(_mm_set1_ps(joint[i][2]), p2)));
+    }
+    _mm_storeu_ps(dest[3], _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(translation[0]), p0),
+                                                            _mm_mul_ps(_mm_set1_ps(translation[1]), p1)),
+                                                 _mm_mul_ps(_mm_set1_ps(translation[2]), p2)),
+                                      p3));
+    dest[0][3] = dest[1][3] = dest[2][3] = 0;
+    dest[3][3] = 1;
+#else
+    Mat4 matrix;
+
+    mtxf_copy(matrix, joint);
+    vec3f_copy(matrix[3], translation);
+    mtxf_mul(dest, matrix, parent);
+#endif
+}
+
+/**
+ * Render an animated part of an object whose pose is cached. Joints that an earlier object
+ * decoded are taken from the pose, the rest are decoded into it.
+ */
+static void geo_process_posed_part(struct GraphNodeAnimatedPart *node, Mtx *matrixPtr) {
+    Mat4 decoded;
+    Vec3f translation;
+    Mat4 *joint;
+    struct AnimPose *pose = sCurPose;
+
+    if (sCurPoseJoint < pose->numJoints) {
+        // Skip the joint's attributes as decoding it would
+        if (gCurAnimType != ANIM_TYPE_ROTATION) {
+            gCurrAnimAttribute += 6;
+            gCurAnimType = ANIM_TYPE_ROTATION;
+        }
+        gCurrAnimAttribute += 6;
+        joint = &pose->joints[sCurPoseJoint];
+    } else if (sCurPoseJoint < POSE_CACHE_MAX_JOINTS) {
+        geo_decode_pose_joint(pose->joints[sCurPoseJoint]);
+        pose->numJoints++;
+        joint = &pose->joints[sCurPoseJoint];
+    } else {
+        geo_decode_pose_joint(decoded);
+        joint = &decoded;
+    }
+    sCurPoseJoint++;
+
+    translation[0] = node->translation[0] + (*joint)[3][0] * gCurAnimTranslationMultiplier;
+    translation[1] = node->translation[1] + (*joint)[3][1] * gCurAnimTranslationMultiplier;
+    translation[2] = node->translation[2] + (*joint)[3][2] * gCurAnimTranslationMultiplier;
+    geo_mul_pose_joint(gMatStack[gMatStackIndex + 1], *joint, translation,
+                       gMatStack[gMatStackIndex]);
+    gMatStackIndex++;
+    mtxf_to_mtx(matrixPtr, gMatStack[gMatStackIndex]);
+    gMatStackFixed[gMatStackIndex] = matrixPtr;
+    if (node->displayList != NULL) {
+        geo_append_display_list(node->displayList, node->node.flags >> 8);
+    }
+    if (node->node.children != NULL) {
+        geo_process_node_and_siblings(node->node.children);
+    }
+    gMatStackIndex--;
+}
+#endif
+
 /**
  * Render an animated part. The current animation state is not part of the node
  * but set in global variables. If an animated part is skipped, everything afterwards desyncs.
@@ -564,6 +732,12 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
     Vec3f translation;
     Mtx *matrixPtr = alloc_display_list(sizeof(*matrixPtr));
 
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+    if (sCurPose != NULL && gCurAnimType != ANIM_TYPE_NONE) {
+        geo_process_posed_part(node, matrixPtr);
+        return;
+    }
+#endif
     vec3s_copy(rotation, gVec3sZero);
     vec3f_set(translation, node->translation[0], node->translation[1], node->translation[2]);
     if (gCurAnimType == ANIM_TYPE_TRANSLATION) {
@@ -649,6 +823,14 @@ void geo_set_animation_globals(struct AnimInfo *node, s32 hasAnimation) {
     } else {
         gCurAnimTranslationMultiplier = (f32) node->animYTrans / (f32) anim->animYTransDivisor;
     }
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+    // A held object is drawn in the middle of its holder, whose pose it could evict
+    if (gCurGraphNodeHeldObject == NULL) {
+        geo_set_pose(anim, node->animFrame);
+    } else {
+        sCurPose = NULL;
+    }
+#endif
 }
 
 /**
@@ -877,6 +1059,11 @@ static void geo_process_object(struct Object *node) {
  * actual children are be processed. (in practice they are null though)
  */
 static void geo_process_object_parent(struct GraphNodeObjectParent *node) {
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    struct Object *particle;
+    s32 type, i;
+#endif
+
     if (node->sharedChild != NULL) {
         node->sharedChild->parent = (struct GraphNode *) node;
         geo_process_node_and_siblings(node->sharedChild);
@@ -885,6 +1072,15 @@ static void geo_process_object_parent(struct GraphNodeObjectParent *node) {
     if (node->node.children != NULL) {
         geo_process_node_and_siblings(node->node.children);
     }
+
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    // Particles come after the objects, each type drawn in one go
+    for (type = 0; type < gNumParticleTypes; type++) {
+        for (i = 0; (particle = get_particle_proxy(type, i)) != NULL; i++) {
+            geo_process_object(particle);
+        }
+    }
+#endif
 }
 
 /**
@@ -894,6 +1090,10 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
     Mat4 mat;
     Vec3f translation;
     Mtx *mtx = alloc_display_list(sizeof(*mtx));
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+    struct AnimPose *holderPose;
+    s32 holderPoseJoint;
+#endif
 
 #ifdef F3DEX_GBI_2
     gSPLookAt(gDisplayListHead++, &lookAt);
@@ -930,6 +1130,10 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gGeoTempState.translationMultiplier = gCurAnimTranslationMultiplier;
         gGeoTempState.attribute = gCurrAnimAttribute;
         gGeoTempState.data = gCurAnimData;
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+        holderPose = sCurPose;
+        holderPoseJoint = sCurPoseJoint;
+#endif
         gCurAnimType = 0;
         gCurGraphNodeHeldObject = (void *) node;
         if (node->objNode->header.gfx.animInfo.curAnim != NULL) {
@@ -944,6 +1148,10 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gCurAnimTranslationMultiplier = gGeoTempState.translationMultiplier;
         gCurrAnimAttribute = gGeoTempState.attribute;
         gCurAnimData = gGeoTempState.data;
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+        sCurPose = holderPose;
+        sCurPoseJoint = holderPoseJoint;
+#endif
         gMatStackIndex--;
     }
 
@@ -1075,6 +1283,12 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
         initialMatrix = alloc_display_list(sizeof(*initialMatrix));
         gMatStackIndex = 0;
         gCurAnimType = 0;
+#if defined(USE_SYSTEM_MALLOC) && defined(ANIMATION_POSE_CACHE)
+        // Poses decoded in earlier frames are stale
+        sPoseRenderFrame++;
+        sPoseHits = 0;
+        sPoseMisses = 0;
+#endif
         vec3s_set(viewport->vp.vtrans, node->x * 4, node->y * 4, 511);
         vec3s_set(viewport->vp.vscale, node->width * 4, node->height * 4, 511);
         if (b != NULL) {
@@ -1103,6 +1317,12 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
 #ifndef USE_SYSTEM_MALLOC
             print_text_fmt_int(180, 36, "MEM %d",
                                gDisplayListHeap->totalSpace - gDisplayListHeap->usedSpace);
+#elif defined(ANIMATION_POSE_CACHE)
+            // Unique poses drawn this frame, and the percentage of animated objects that reused one
+            print_text_fmt_int(180, 20, "POSE %d", sPoseMisses);
+            if (sPoseHits + sPoseMisses != 0) {
+                print_text_fmt_int(180, 36, "HIT %d", sPoseHits * 100 / (sPoseHits + sPoseMisses));
+            }
 #endif
         }
         main_pool_free(gDisplayListHeap);
@@ -15,6 +15,12 @@
 #include "object_list_processor.h"
 #include "spawn_object.h"
 #include "types.h"
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+#include "../pc/behavior_profiler.h"
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+#include "particle_system.h"
+#endif
 
 /**
  * An unused linked list struct that seems to have been replaced by ObjectNode.
@@ -74,6 +80,38 @@ struct LinkedList *unused_try_allocate(struct LinkedList *destList,
     return node;
 }
 
+#ifdef USE_SYSTEM_MALLOC
+/**
+ * Objects are allocated in blocks of this many, and blocks are never freed, so an object's
+ * address stays valid after it is unloaded, like in the fixed pool.
+ */
+#define OBJECT_POOL_BLOCK_SIZE 64
+
+s32 gObjectPoolCapacity;
+s32 gObjectPoolUsed;
+s32 gObjectPoolHighWater;
+
+/**
+ * Allocate a new block of objects and add them to the front of freeList, in address order.
+ */
+static void grow_object_pool(struct ObjectNode *freeList) {
+    struct Object *block = calloc(OBJECT_POOL_BLOCK_SIZE, sizeof(struct Object));
+    s32 i;
+
+    if (block == NULL) {
+        abort();
+    }
+
+    block[OBJECT_POOL_BLOCK_SIZE - 1].header.next = freeList->next;
+    for (i = 0; i < OBJECT_POOL_BLOCK_SIZE - 1; i++) {
+        block[i].header.next = &block[i + 1].header;
+    }
+    freeList->next = &block[0].header;
+
+    gObjectPoolCapacity += OBJECT_POOL_BLOCK_SIZE;
+}
+#endif
+
 /**
  * Attempt to allocate an object from freeList (singly linked) and append it
  * to the end of destList (doubly linked). Return the object, or NULL if
@@ -82,6 +120,13 @@ struct LinkedList *unused_try_allocate(struct LinkedList *destList,
 struct Object *try_allocate_object(struct ObjectNode *destList, struct ObjectNode *freeList) {
     struct ObjectNode *nextObj;
 
+#ifdef USE_SYSTEM_MALLOC
+    // The pool grows instead of running out.
+    if (freeList->next == NULL) {
+        grow_object_pool(freeList);
+    }
+#endif
+
     if ((nextObj = freeList->next) != NULL) {
         // Remove from free list
         freeList->next = nextObj->next;
@@ -92,22 +137,13 @@ struct Object *try_allocate_object(struct ObjectNode *destList, struct ObjectNod
         destList->prev->next = nextObj;
         destList->prev = nextObj;
     } else {
-#ifdef USE_SYSTEM_MALLOC
-        nextObj = (struct ObjectNode *) malloc(sizeof(struct Object));
-        if (nextObj == NULL) {
-            abort();
-        }
-        // Insert at end of destination list
-        nextObj->prev = destList->prev;
-        nextObj->next = destList;
-        destList->prev->next = nextObj;
-        destList->prev = nextObj;
-#else
         return NULL;
-#endif
     }
 
 #ifdef USE_SYSTEM_MALLOC
+    if (++gObjectPoolUsed > gObjectPoolHighWater) {
+        gObjectPoolHighWater = gObjectPoolUsed;
+    }
     init_graph_node_object(NULL, &nextObj->gfx, 0, gVec3fZero, gVec3sZero, gVec3fOne);
 #else
     geo_remove_child(&nextObj->gfx.node);
@@ -144,6 +180,10 @@ static void deallocate_object(struct ObjectNode *freeList, struct ObjectNode *ob
     // Insert at beginning of free list
     obj->next = freeList->next;
     freeList->next = obj;
+
+#ifdef USE_SYSTEM_MALLOC
+    gObjectPoolUsed--;
+#endif
 }
 
 #ifndef USE_SYSTEM_MALLOC
@@ -232,9 +272,24 @@ void unload_object(struct Object *obj) {
     obj->header.gfx.node.flags &= ~GRAPH_RENDER_BILLBOARD;
     obj->header.gfx.node.flags &= ~GRAPH_RENDER_ACTIVE;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(PARTICLE_SYSTEM)
+    if (gNumPendingParticles != 0) {
+        move_pending_particles(&obj->header);
+    }
+#endif
     deallocate_object(&gFreeObjectList, &obj->header);
 }
 
+#if IS_64_BIT
+/**
+ * The indices of the fields defined with a pointer type in object_fields.h, which are the only
+ * ones kept in ptrData on 64-bit targets.
+ */
+static const u8 sObjectPointerFields[] = {
+    0x1B, 0x1C, 0x1D, 0x1E, 0x20, 0x21, 0x22, 0x26, 0x49, 0x4E,
+};
+#endif
+
 /**
  * Attempt to allocate a new object slot into the given object list, freeing
  * an unimportant object if necessary. If this is not possible, hang using an
@@ -282,7 +337,10 @@ struct Object *allocate_object(struct ObjectNode *objList) {
 #if IS_64_BIT
     for (i = 0; i < 0x50; i++) {
         obj->rawData.asS32[i] = 0;
-        obj->ptrData.asVoidPtr[i] = NULL;
+    }
+    // Only the pointer fields are ever read from ptrData.
+    for (i = 0; i < ARRAY_COUNT(sObjectPointerFields); i++) {
+        obj->ptrData.asVoidPtr[sObjectPointerFields[i]] = NULL;
     }
 #else
     // -O2 needs everything until = on the same line
@@ -317,6 +375,12 @@ struct Object *allocate_object(struct ObjectNode *objList) {
 
     obj->respawnInfoType = RESPAWN_INFO_TYPE_NULL;
     obj->respawnInfo = NULL;
+#if defined(USE_SYSTEM_MALLOC) && defined(OBJECT_UPDATE_LOD)
+    obj->lastUpdateFrame = 0;
+#endif
+#if defined(USE_SYSTEM_MALLOC) && defined(PARALLEL_OBJECT_UPDATES)
+    obj->parallelUpdateSlot = 0;
+#endif
 
     obj->oDistanceToMario = 19000.0f;
     obj->oRoom = -1;
@@ -367,6 +431,10 @@ struct Object *create_object(const BehaviorScript *bhvScript) {
     obj->curBhvCommand = bhvScript;
     obj->behavior = behavior;
 
+#if defined(USE_SYSTEM_MALLOC) && defined(BEHAVIOR_PROFILER)
+    behavior_profiler_object_created(behavior);
+#endif
+
     if (objListIndex == OBJ_LIST_UNIMPORTANT) {
         obj->activeFlags |= ACTIVE_FLAG_UNIMPORTANT;
     }
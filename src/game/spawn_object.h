@@ -3,6 +3,13 @@
 
 #include "types.h"
 
+#ifdef USE_SYSTEM_MALLOC
+// Objects in the pool, objects in use, and the most objects that have been in use at once.
+extern s32 gObjectPoolCapacity;
+extern s32 gObjectPoolUsed;
+extern s32 gObjectPoolHighWater;
+#endif
+
 void init_free_object_list(void);
 void clear_object_lists(struct ObjectNode *objLists);
 void unload_object(struct Object *obj);
@@ -34,10 +34,18 @@
 #include <stdio.h>
 
 #include "audio_api.h"
+#include "../configfile.h"
+
+#define DEFAULT_BUFFER_SIZE (1600 + 528 + 544) // five audio buffers from the game
+#define DEFAULT_LATENCY 1100
 
-#define PCM_DEVICE "default"
 static snd_pcm_t *pcm_handle;
 static unsigned long int alsa_buffer_size;
+static snd_pcm_uframes_t alsa_period_size;
+static bool alsa_mmap;
+static int alsa_latency;
+static unsigned int alsa_underruns;
+static snd_pcm_sframes_t alsa_measured_latency;
 
 static unsigned long get_time(void) {
 	struct timespec ts;
@@ -50,16 +58,18 @@ static bool audio_alsa_init(void) {
 	unsigned int tmp;
 	unsigned int rate, channels;
 	snd_pcm_hw_params_t *params;
+	snd_pcm_sw_params_t *swparams;
 	snd_pcm_uframes_t frames;
 
 	rate 	 = 32000;
 	channels = 2;
 
 	/* Open the PCM device in playback mode */
-	if ((pcm = snd_pcm_open(&pcm_handle, PCM_DEVICE,
+	if ((pcm = snd_pcm_open(&pcm_handle, configAudioAlsaDevice,
 					SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
 		printf("ERROR: Can't open \"%s\" PCM device. %s\n",
-					PCM_DEVICE, snd_strerror(pcm));
+					configAudioAlsaDevice, snd_strerror(pcm));
+        pcm_handle = NULL;
         return false;
     }
 
@@ -68,8 +78,17 @@ static bool audio_alsa_init(void) {
 
 	snd_pcm_hw_params_any(pcm_handle, params);
 
-	/* Set parameters */
-	if ((pcm = snd_pcm_hw_params_set_access(pcm_handle, params,
+	/* Set parameters. mmap access lets us write straight into the ring buffer,
+	   falling back to regular writes if the device doesn't support it. */
+	alsa_mmap = false;
+	if (configAudioAlsaMmap) {
+		if ((pcm = snd_pcm_hw_params_set_access(pcm_handle, params,
+						SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0)
+			printf("ERROR: Can't set mmap interleaved mode. %s\n", snd_strerror(pcm));
+		else
+			alsa_mmap = true;
+	}
+	if (!alsa_mmap && (pcm = snd_pcm_hw_params_set_access(pcm_handle, params,
 					SND_PCM_ACCESS_RW_INTERLEAVED)) < 0)
 		printf("ERROR: Can't set interleaved mode. %s\n", snd_strerror(pcm));
 
@@ -83,7 +102,13 @@ static bool audio_alsa_init(void) {
 	if ((pcm = snd_pcm_hw_params_set_rate_near(pcm_handle, params, &rate, 0)) < 0)
 		printf("ERROR: Can't set rate. %s\n", snd_strerror(pcm));
 
-	alsa_buffer_size = 1600 + 528 + 544; // five audio buffers from the game
+	if (configAudioPeriodSize != 0) {
+		frames = configAudioPeriodSize;
+		if ((pcm = snd_pcm_hw_params_set_period_size_near(pcm_handle, params, &frames, 0)) < 0)
+			printf("ERROR: Can't set period size. %s\n", snd_strerror(pcm));
+	}
+
+	alsa_buffer_size = configAudioBufferSize != 0 ? configAudioBufferSize : DEFAULT_BUFFER_SIZE;
 	if ((pcm = snd_pcm_hw_params_set_buffer_size_near(pcm_handle, params, &alsa_buffer_size)) < 0)
 		printf("ERROR: Can't set buffer size. %s\n", snd_strerror(pcm));
 
@@ -96,6 +121,8 @@ static bool audio_alsa_init(void) {
 
 	printf("PCM state: %s\n", snd_pcm_state_name(snd_pcm_state(pcm_handle)));
 
+	printf("access: %s\n", alsa_mmap ? "mmap" : "rw");
+
 	snd_pcm_hw_params_get_channels(params, &tmp);
 	printf("channels: %i ", tmp);
 
@@ -111,12 +138,29 @@ static bool audio_alsa_init(void) {
 	printf("buffer size: %lu\n", alsa_buffer_size);
 
 	/* Allocate buffer to hold single period */
-	snd_pcm_hw_params_get_period_size(params, &frames, 0);
-	printf("frames: %lu\n", frames);
+	snd_pcm_hw_params_get_period_size(params, &alsa_period_size, 0);
+	printf("frames: %lu\n", alsa_period_size);
 
 	snd_pcm_hw_params_get_period_time(params, &tmp, NULL);
 	printf("time: %d\n", tmp);
 
+	/* Start playback as soon as one period is queued and wake up once a period is free */
+	snd_pcm_sw_params_alloca(&swparams);
+	snd_pcm_sw_params_current(pcm_handle, swparams);
+	snd_pcm_sw_params_set_start_threshold(pcm_handle, swparams, alsa_period_size);
+	snd_pcm_sw_params_set_avail_min(pcm_handle, swparams, alsa_period_size);
+	if ((pcm = snd_pcm_sw_params(pcm_handle, swparams)) < 0)
+		printf("ERROR: Can't set software parameters. %s\n", snd_strerror(pcm));
+
+	/* The game has to stay at least a period ahead of the device, and can't queue more
+	   than fits in the buffer */
+	alsa_latency = configAudioLatency != 0 ? (int)configAudioLatency : DEFAULT_LATENCY;
+	if (alsa_latency < (int)alsa_period_size)
+		alsa_latency = alsa_period_size;
+	if (alsa_latency > (int)(alsa_buffer_size - alsa_period_size))
+		alsa_latency = alsa_buffer_size - alsa_period_size;
+	printf("target latency: %d\n", alsa_latency);
+
     return true;
 }
 
@@ -124,6 +168,15 @@ static int audio_alsa_buffered(void) {
     if (!pcm_handle) {
         return 0;
     }
+    if (alsa_mmap) {
+        // snd_pcm_delay also counts the frames that have left the ring buffer but haven't
+        // been played yet, so this is the actual output latency
+        snd_pcm_sframes_t delay;
+        if (snd_pcm_delay(pcm_handle, &delay) < 0) {
+            return 0;
+        }
+        return delay < 0 ? 0 : delay;
+    }
     snd_pcm_sframes_t ret = snd_pcm_avail(pcm_handle);
     if (ret < 0) {
         return 0;
@@ -133,7 +186,65 @@ static int audio_alsa_buffered(void) {
 }
 
 static int audio_alsa_get_desired_buffered(void) {
-    return 1100;
+    return alsa_latency;
+}
+
+// Copies interleaved frames directly into the device's ring buffer
+static int alsa_mmap_write(const uint8_t *buff, snd_pcm_uframes_t frames) {
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset;
+    snd_pcm_uframes_t count;
+    snd_pcm_sframes_t avail;
+    snd_pcm_sframes_t committed;
+    int err;
+
+    while (frames > 0) {
+        if ((avail = snd_pcm_avail_update(pcm_handle)) < 0) {
+            return avail;
+        }
+        if (avail == 0) {
+            // Buffer is full, wait for the device to consume a period
+            if (snd_pcm_state(pcm_handle) == SND_PCM_STATE_PREPARED
+                && (err = snd_pcm_start(pcm_handle)) < 0) {
+                return err;
+            }
+            if ((err = snd_pcm_wait(pcm_handle, 100)) < 0) {
+                return err;
+            }
+            continue;
+        }
+
+        count = frames;
+        if ((err = snd_pcm_mmap_begin(pcm_handle, &areas, &offset, &count)) < 0) {
+            return err;
+        }
+        memcpy((uint8_t *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8, buff, count * 4);
+        committed = snd_pcm_mmap_commit(pcm_handle, offset, count);
+        if (committed < 0) {
+            return committed;
+        }
+        if ((snd_pcm_uframes_t)committed != count) {
+            return -EPIPE;
+        }
+        buff += committed * 4;
+        frames -= committed;
+    }
+
+    // Committing frames doesn't start the stream by itself
+    if (snd_pcm_state(pcm_handle) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(pcm_handle);
+    }
+    return 0;
+}
+
+static int alsa_write(const uint8_t *buff, int frames) {
+    int pcm;
+
+    if (alsa_mmap) {
+        return alsa_mmap_write(buff, frames);
+    }
+    pcm = snd_pcm_writei(pcm_handle, buff, frames);
+    return pcm < 0 ? pcm : 0;
 }
 
 static void audio_alsa_play(const uint8_t* buff, size_t len) {
@@ -143,20 +254,24 @@ static void audio_alsa_play(const uint8_t* buff, size_t len) {
 	//unsigned long t1 = get_time();
     int frames = len / 4;
     int pcm;
-	if ((pcm = snd_pcm_writei(pcm_handle, buff, frames)) == -EPIPE) {
-		printf("XRUN.\n");
+	if ((pcm = alsa_write(buff, frames)) == -EPIPE || pcm == -ESTRPIPE) {
+		alsa_underruns++;
+		printf("XRUN #%u (last measured latency: %ld frames).\n", alsa_underruns, (long)alsa_measured_latency);
 		snd_pcm_prepare(pcm_handle);
         // Add some silence to avoid another XRUN
-        char buf[1100 * 4 + len];
-        memset(buf, 0, 1100 * 4);
-        memcpy(buf + 1100 * 4, buff, len);
-		if ((pcm = snd_pcm_writei(pcm_handle, buf, 1100 + frames)) < 0) {
+        char buf[alsa_latency * 4 + len];
+        memset(buf, 0, alsa_latency * 4);
+        memcpy(buf + alsa_latency * 4, buff, len);
+		if ((pcm = alsa_write((const uint8_t *)buf, alsa_latency + frames)) < 0) {
 			printf("Failed again %d\n", pcm);
 		}
 	} else if (pcm < 0) {
 		printf("ERROR. Can't write to PCM device. %s\n", snd_strerror(pcm));
 		return;
 	}
+    if (snd_pcm_delay(pcm_handle, &alsa_measured_latency) < 0) {
+        alsa_measured_latency = 0;
+    }
 	//fprintf(stderr, "%u ", get_time() - t1);
 }
 
@@ -1,19 +1,85 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
 #include "macros.h"
 #include "audio_api.h"
+#include "../configfile.h"
+
+// The null backend models a device that drains the submitted samples at a fixed rate, so
+// the game sees the same buffer levels it would with real hardware and keeps alternating
+// between SAMPLES_HIGH and SAMPLES_LOW like it normally does. The device clock either
+// follows wall time scaled by audio_null_speed, or with a speed of 0 advances by exactly
+// one game frame per play() call, which makes headless runs fully deterministic.
+
+#define SAMPLE_RATE 32000
+#define GAME_FRAMES_PER_SECOND 30
+#define DESIRED_BUFFERED 1100
+
+static double queued_frames;
+static double last_time;
+static FILE *dump_file;
+
+static double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static void consume(double frames) {
+    queued_frames -= frames;
+    if (queued_frames < 0.0) {
+        queued_frames = 0.0;
+    }
+}
+
+// Drain the frames the device would have played since the last call
+static void advance_clock(void) {
+    double now;
+
+    if (configAudioNullSpeed > 0.0f) {
+        now = get_time();
+        if (queued_frames > 0.0) {
+            consume((now - last_time) * SAMPLE_RATE * configAudioNullSpeed);
+        }
+        last_time = now;
+    }
+}
 
 static bool audio_null_init(void) {
+    queued_frames = 0.0;
+    last_time = get_time();
+
+    if (dump_file == NULL && strcmp(configAudioNullDump, "none") != 0) {
+        dump_file = fopen(configAudioNullDump, "wb");
+        if (dump_file == NULL) {
+            printf("Can't open audio dump file '%s'\n", configAudioNullDump);
+        }
+    }
     return true;
 }
 
 static int audio_null_buffered(void) {
-    return 0;
+    advance_clock();
+    return (int)queued_frames;
 }
 
 static int audio_null_get_desired_buffered(void) {
-    return 0;
+    return DESIRED_BUFFERED;
 }
 
-static void audio_null_play(UNUSED const uint8_t *buf, UNUSED size_t len) {
+static void audio_null_play(const uint8_t *buf, size_t len) {
+    advance_clock();
+    queued_frames += len / 4;
+
+    if (configAudioNullSpeed <= 0.0f) {
+        // Frame-locked: the device plays one game frame's worth of audio until the next call
+        consume((double)SAMPLE_RATE / GAME_FRAMES_PER_SECOND);
+    }
+
+    if (dump_file != NULL) {
+        fwrite(buf, 1, len, dump_file);
+    }
 }
 
 struct AudioAPI audio_null = {
@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#ifdef __linux__
+#include <elf.h>
+#endif
+
+#include "sm64.h"
+#include "game/game_init.h"
+#include "game/print.h"
+
+#include "behavior_profiler.h"
+
+#ifdef BEHAVIOR_PROFILER
+
+#define PROFILE_FILE "behavior_profile.txt"
+
+#define REPORT_KEY  0x43 // F9
+#define OVERLAY_KEY 0x57 // F11, F10 toggles fullscreen
+
+// Distinct behavior scripts and native functions that are tracked.
+#define MAX_ENTRIES 4096
+#define MAX_UPDATE_DEPTH 16
+
+#define OVERLAY_FRAMES 15
+#define OVERLAY_ENTRIES 10
+#define OVERLAY_NAME_LENGTH 13
+
+enum ProfileEntryType {
+    PROFILE_BEHAVIOR,
+    PROFILE_NATIVE,
+};
+
+struct ProfileStats {
+    u32 calls;
+    u32 spawned;
+    uint64_t ns;
+};
+
+struct ProfileEntry {
+    const void *addr;
+    s32 type;
+    s32 used;
+    // Objects created with this behavior, wherever they were spawned from.
+    u32 created;
+    const char *name;
+    struct ProfileStats total;
+    struct ProfileStats window;
+};
+
+// The phases of update_objects, between consecutive cycleCounts.
+#define NUM_PHASES 6
+static const char *sPhaseNames[NUM_PHASES] = {
+    "clear dynamic surfaces", "terrain objects", "object collisions",
+    "other objects",          "unload objects",  "mario platform",
+};
+
+static FILE *sReport;
+static s32 sInitialized;
+static struct ProfileEntry sEntries[MAX_ENTRIES];
+static s32 sNumEntries;
+static u32 sDroppedCalls;
+static u32 sFrames;
+static uint64_t sPhaseNs[NUM_PHASES];
+static uint64_t sObjectsNs;
+
+// The updates in progress.
+static struct ProfileEntry *sUpdateEntries[MAX_UPDATE_DEPTH];
+static uint64_t sUpdateStarts[MAX_UPDATE_DEPTH];
+static s32 sUpdateDepth;
+
+static s32 sShowOverlay;
+static u32 sWindowFrames;
+static uint64_t sWindowObjectsNs;
+static struct ProfileEntry *sOverlayEntries[OVERLAY_ENTRIES];
+static uint64_t sOverlayNs[OVERLAY_ENTRIES];
+static u32 sOverlayCalls[OVERLAY_ENTRIES];
+static s32 sNumOverlayEntries;
+static uint64_t sOverlayObjectsNs;
+
+static uint64_t get_time_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&count);
+    return (uint64_t) (count.QuadPart / freq.QuadPart) * 1000000000
+           + (uint64_t) (count.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+u64 behavior_profiler_get_time_ns(void) {
+    return get_time_ns();
+}
+
+static struct ProfileEntry *get_entry(s32 type, const void *addr) {
+    uintptr_t hash = ((uintptr_t) addr >> 2) * 31 ^ type;
+    s32 i = hash % MAX_ENTRIES;
+
+    while (sEntries[i].used) {
+        if (sEntries[i].addr == addr && sEntries[i].type == type) {
+            return &sEntries[i];
+        }
+        i = (i + 1) % MAX_ENTRIES;
+    }
+    if (sNumEntries >= MAX_ENTRIES * 3 / 4) {
+        return NULL;
+    }
+    sNumEntries++;
+    sEntries[i].used = TRUE;
+    sEntries[i].addr = addr;
+    sEntries[i].type = type;
+    return &sEntries[i];
+}
+
+static void add_stats(struct ProfileEntry *entry, uint64_t ns) {
+    entry->total.calls++;
+    entry->total.ns += ns;
+    entry->window.calls++;
+    entry->window.ns += ns;
+}
+
+void behavior_profiler_begin_update(const BehaviorScript *behavior) {
+    if (sUpdateDepth < MAX_UPDATE_DEPTH) {
+        sUpdateEntries[sUpdateDepth] = get_entry(PROFILE_BEHAVIOR, behavior);
+        sUpdateStarts[sUpdateDepth] = get_time_ns();
+    }
+    sUpdateDepth++;
+}
+
+void behavior_profiler_end_update(void) {
+    struct ProfileEntry *entry;
+
+    if (--sUpdateDepth >= MAX_UPDATE_DEPTH) {
+        return;
+    }
+    entry = sUpdateEntries[sUpdateDepth];
+    if (entry != NULL) {
+        add_stats(entry, get_time_ns() - sUpdateStarts[sUpdateDepth]);
+    } else {
+        sDroppedCalls++;
+    }
+}
+
+void behavior_profiler_call_native(void (*func)(void)) {
+    struct ProfileEntry *entry;
+    uint64_t start = get_time_ns();
+
+    func();
+
+    entry = get_entry(PROFILE_NATIVE, (const void *) func);
+    if (entry != NULL) {
+        add_stats(entry, get_time_ns() - start);
+    } else {
+        sDroppedCalls++;
+    }
+}
+
+void behavior_profiler_object_created(const BehaviorScript *behavior) {
+    struct ProfileEntry *entry = get_entry(PROFILE_BEHAVIOR, behavior);
+
+    if (entry != NULL) {
+        entry->created++;
+    }
+
+    // Objects created outside of object updates, like those in the level scripts, only count
+    // as created.
+    if (sUpdateDepth > 0 && sUpdateDepth <= MAX_UPDATE_DEPTH
+        && (entry = sUpdateEntries[sUpdateDepth - 1]) != NULL) {
+        entry->total.spawned++;
+        entry->window.spawned++;
+    }
+}
+
+#ifdef __linux__
+#if UINTPTR_MAX > 0xFFFFFFFF
+typedef Elf64_Ehdr ElfHeader;
+typedef Elf64_Shdr ElfSectionHeader;
+typedef Elf64_Sym ElfSymbol;
+#define ELF_SYMBOL_TYPE ELF64_ST_TYPE
+#else
+typedef Elf32_Ehdr ElfHeader;
+typedef Elf32_Shdr ElfSectionHeader;
+typedef Elf32_Sym ElfSymbol;
+#define ELF_SYMBOL_TYPE ELF32_ST_TYPE
+#endif
+
+static char *sElfImage;
+static ElfSymbol *sSymbols;
+static size_t sNumSymbols;
+static const char *sSymbolNames;
+static uintptr_t sLoadBias;
+
+/**
+ * Read the symbol table of the running executable, if it has one. Symbol values are offset by
+ * where the executable was loaded, which is found from the address of a function in it.
+ */
+static void load_symbols(void) {
+    ElfHeader *header;
+    ElfSectionHeader *sections;
+    FILE *file;
+    long size;
+    size_t i;
+
+    if ((file = fopen("/proc/self/exe", "rb")) == NULL) {
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= (long) sizeof(ElfHeader) || (sElfImage = malloc(size)) == NULL
+        || fread(sElfImage, size, 1, file) != 1) {
+        fclose(file);
+        return;
+    }
+    fclose(file);
+
+    header = (ElfHeader *) sElfImage;
+    if (memcmp(header->e_ident, ELFMAG, SELFMAG) != 0
+        || header->e_shoff + (size_t) header->e_shnum * sizeof(ElfSectionHeader) > (size_t) size) {
+        return;
+    }
+    sections = (ElfSectionHeader *) (sElfImage + header->e_shoff);
+    for (i = 0; i < header->e_shnum; i++) {
+        if (sections[i].sh_type == SHT_SYMTAB && sections[i].sh_link < header->e_shnum) {
+            sSymbols = (ElfSymbol *) (sElfImage + sections[i].sh_offset);
+            sNumSymbols = sections[i].sh_size / sizeof(ElfSymbol);
+            sSymbolNames = sElfImage + sections[sections[i].sh_link].sh_offset;
+            break;
+        }
+    }
+
+    for (i = 0; i < sNumSymbols; i++) {
+        if (strcmp(sSymbolNames + sSymbols[i].st_name, "behavior_profiler_get_time_ns") == 0) {
+            sLoadBias = (uintptr_t) behavior_profiler_get_time_ns - sSymbols[i].st_value;
+            return;
+        }
+    }
+    // Without a known function, the names can't be matched to addresses.
+    sNumSymbols = 0;
+}
+
+static const char *find_symbol_name(const void *addr) {
+    uintptr_t value = (uintptr_t) addr - sLoadBias;
+    size_t i;
+
+    for (i = 0; i < sNumSymbols; i++) {
+        if (sSymbols[i].st_value == value
+            && (ELF_SYMBOL_TYPE(sSymbols[i].st_info) == STT_FUNC
+                || ELF_SYMBOL_TYPE(sSymbols[i].st_info) == STT_OBJECT)) {
+            return sSymbolNames + sSymbols[i].st_name;
+        }
+    }
+    return NULL;
+}
+#endif
+
+static const char *get_entry_name(struct ProfileEntry *entry) {
+#ifdef __linux__
+    if (entry->name == NULL) {
+        entry->name = find_symbol_name(entry->addr);
+    }
+#endif
+    return entry->name;
+}
+
+/**
+ * Find the count entries of the given type that took the most total or window time, most
+ * expensive first.
+ */
+static s32 find_top_entries(struct ProfileEntry **top, s32 count, s32 type, s32 window) {
+    s32 numTop = 0;
+    s32 i, j;
+
+    for (i = 0; i < MAX_ENTRIES; i++) {
+        struct ProfileEntry *entry = &sEntries[i];
+        uint64_t ns = window ? entry->window.ns : entry->total.ns;
+
+        if (!entry->used || entry->type != type
+            || (window ? entry->window.calls : entry->total.calls + entry->created) == 0) {
+            continue;
+        }
+        for (j = numTop; j > 0 && ns > (window ? top[j - 1]->window.ns : top[j - 1]->total.ns); j--) {
+            if (j < count) {
+                top[j] = top[j - 1];
+            }
+        }
+        if (j < count) {
+            top[j] = entry;
+            if (numTop < count) {
+                numTop++;
+            }
+        }
+    }
+    return numTop;
+}
+
+static void print_entry(struct ProfileEntry *entry) {
+    const char *name = get_entry_name(entry);
+    uint64_t ns = entry->total.ns;
+    u32 calls = entry->total.calls;
+
+    fprintf(sReport, "  %10.3f ms %8.2f%% %8.1f us/frame %10u %s %8.0f ns/%s",
+            ns / 1000000.0, sObjectsNs != 0 ? ns * 100.0 / sObjectsNs : 0.0,
+            ns / 1000.0 / sFrames, calls, entry->type == PROFILE_BEHAVIOR ? "updates" : "calls  ",
+            calls != 0 ? (double) ns / calls : 0.0, entry->type == PROFILE_BEHAVIOR ? "update" : "call  ");
+    if (entry->type == PROFILE_BEHAVIOR) {
+        fprintf(sReport, " %8u spawned %8u created", entry->total.spawned, entry->created);
+    }
+    if (name != NULL) {
+        fprintf(sReport, "  %s\n", name);
+    } else {
+        fprintf(sReport, "  %p\n", entry->addr);
+    }
+}
+
+static void write_report(void) {
+    struct ProfileEntry **top;
+    s32 numTop, i;
+
+    if (sFrames == 0 || (top = malloc(MAX_ENTRIES * sizeof(*top))) == NULL) {
+        return;
+    }
+    // The report covers the whole run so far, so it replaces the last one.
+    if (sReport != NULL) {
+        fclose(sReport);
+    }
+    if ((sReport = fopen(PROFILE_FILE, "w")) == NULL) {
+        free(top);
+        return;
+    }
+
+    fprintf(sReport, "%u frames, %.3f ms updating objects (%.1f us/frame)\n", sFrames,
+            sObjectsNs / 1000000.0, sObjectsNs / 1000.0 / sFrames);
+    if (sDroppedCalls != 0) {
+        fprintf(sReport, "(%u calls from behaviors and functions that didn't fit in the table)\n",
+                sDroppedCalls);
+    }
+    fprintf(sReport, "\nphases of update_objects:\n");
+    for (i = 0; i < NUM_PHASES; i++) {
+        fprintf(sReport, "  %10.3f ms %8.2f%% %8.1f us/frame  %s\n", sPhaseNs[i] / 1000000.0,
+                sObjectsNs != 0 ? sPhaseNs[i] * 100.0 / sObjectsNs : 0.0,
+                sPhaseNs[i] / 1000.0 / sFrames, sPhaseNames[i]);
+    }
+
+    // Percentages are of the time spent in update_objects. A behavior's time includes the native
+    // functions it calls and the objects it updates itself, if any.
+    fprintf(sReport, "\nbehaviors by time:\n");
+    numTop = find_top_entries(top, MAX_ENTRIES, PROFILE_BEHAVIOR, FALSE);
+    for (i = 0; i < numTop; i++) {
+        print_entry(top[i]);
+    }
+    fprintf(sReport, "\nnative functions by time:\n");
+    numTop = find_top_entries(top, MAX_ENTRIES, PROFILE_NATIVE, FALSE);
+    for (i = 0; i < numTop; i++) {
+        print_entry(top[i]);
+    }
+    fflush(sReport);
+    free(top);
+}
+
+static void update_overlay(void) {
+    s32 i;
+
+    sNumOverlayEntries = find_top_entries(sOverlayEntries, OVERLAY_ENTRIES, PROFILE_BEHAVIOR, TRUE);
+    for (i = 0; i < sNumOverlayEntries; i++) {
+        sOverlayNs[i] = sOverlayEntries[i]->window.ns / sWindowFrames;
+        sOverlayCalls[i] = sOverlayEntries[i]->window.calls / sWindowFrames;
+    }
+    sOverlayObjectsNs = sWindowObjectsNs / sWindowFrames;
+
+    for (i = 0; i < MAX_ENTRIES; i++) {
+        memset(&sEntries[i].window, 0, sizeof(sEntries[i].window));
+    }
+    sWindowFrames = 0;
+    sWindowObjectsNs = 0;
+}
+
+/**
+ * One line per behavior, with its time and updates per frame. The HUD font has no punctuation
+ * to speak of, so times are in whole microseconds.
+ */
+static void print_overlay(void) {
+    char line[50];
+    const char *name;
+    s32 i;
+
+    sprintf(line, "OBJECTS %6u", (u32) (sOverlayObjectsNs / 1000));
+    print_text(10, 200, line);
+    for (i = 0; i < sNumOverlayEntries; i++) {
+        char shortName[OVERLAY_NAME_LENGTH + 1];
+
+        if ((name = get_entry_name(sOverlayEntries[i])) != NULL) {
+            if (strncmp(name, "bhv", 3) == 0) {
+                name += 3;
+            }
+            snprintf(shortName, sizeof(shortName), "%s", name);
+        } else {
+            snprintf(shortName, sizeof(shortName), "%X",
+                     (u32) ((uintptr_t) sOverlayEntries[i]->addr & 0xFFFFFF));
+        }
+        sprintf(line, "%-*s%5u %3u", OVERLAY_NAME_LENGTH, shortName,
+                (u32) (sOverlayNs[i] / 1000), sOverlayCalls[i]);
+        print_text(10, 182 - i * 16, line);
+    }
+}
+
+void behavior_profiler_end_frame(s64 *cycleCounts) {
+    s32 i;
+
+    if (!sInitialized) {
+        sInitialized = TRUE;
+#ifdef __linux__
+        load_symbols();
+#endif
+        atexit(write_report);
+    }
+
+    for (i = 0; i < NUM_PHASES; i++) {
+        sPhaseNs[i] += cycleCounts[i + 2] - cycleCounts[i + 1];
+    }
+    sObjectsNs += cycleCounts[NUM_PHASES + 1];
+    sWindowObjectsNs += cycleCounts[NUM_PHASES + 1];
+    sFrames++;
+
+    if (++sWindowFrames == OVERLAY_FRAMES) {
+        update_overlay();
+    }
+    if (sShowOverlay) {
+        print_overlay();
+    }
+}
+
+s32 behavior_profiler_on_key_down(s32 scancode) {
+    switch (scancode) {
+        case REPORT_KEY:
+            write_report();
+            return TRUE;
+        case OVERLAY_KEY:
+            sShowOverlay ^= 1;
+            return TRUE;
+    }
+    return FALSE;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef BEHAVIOR_PROFILER_H
+#define BEHAVIOR_PROFILER_H
+
+#include <PR/ultratypes.h>
+
+#include "types.h"
+
+// Behavior profiling, enabled with BEHAVIOR_PROFILER in config.h. Every object update is timed
+// and charged to the object's behavior script, and every CALL_NATIVE to the function it calls.
+// Objects spawned during an update are counted against the behavior doing the update. The totals
+// are kept for the whole run, along with the time spent in each phase of update_objects.
+//
+// The report, sorted by time, is written to behavior_profile.txt when the game exits and when F9
+// is pressed. F10 toggles an overlay of the behaviors that took the most time in the last half
+// second. On Linux, names are read from the executable's symbol table, elsewhere the report has
+// addresses that can be turned into names with addr2line -f -e <executable>.
+
+u64 behavior_profiler_get_time_ns(void);
+
+// Updates may nest, each one is charged to its own behavior.
+void behavior_profiler_begin_update(const BehaviorScript *behavior);
+void behavior_profiler_end_update(void);
+void behavior_profiler_call_native(void (*func)(void));
+void behavior_profiler_object_created(const BehaviorScript *behavior);
+
+// Called at the end of update_objects with the clock readings taken between its phases.
+void behavior_profiler_end_frame(s64 *cycleCounts);
+// Returns TRUE if the key was one of the profiler's.
+s32 behavior_profiler_on_key_down(s32 scancode);
+
+#endif
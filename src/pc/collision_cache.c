@@ -0,0 +1,143 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if defined(_WIN32)
+#include <direct.h>
+#elif !defined(TARGET_WEB)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "collision_cache.h"
+#include "configfile.h"
+
+// The web build has no persistent file system, so it always builds the partitions itself.
+
+int collision_cache_enabled(void) {
+#ifdef TARGET_WEB
+    return 0;
+#else
+    return configCollisionCacheDir[0] != '\0' && strcmp(configCollisionCacheDir, "none") != 0;
+#endif
+}
+
+#ifndef TARGET_WEB
+static void get_cache_path(char *path, size_t size, uint64_t key, const char *suffix) {
+    snprintf(path, size, "%s/%016" PRIx64 ".bin%s", configCollisionCacheDir, key, suffix);
+}
+#endif
+
+void *collision_cache_map(uint64_t key, size_t *size) {
+#if defined(TARGET_WEB)
+    (void)key;
+    (void)size;
+    return NULL;
+#elif defined(_WIN32)
+    char path[1024];
+    FILE *fp;
+    long len;
+    void *data;
+
+    if (!collision_cache_enabled()) {
+        return NULL;
+    }
+    get_cache_path(path, sizeof(path), key, "");
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    data = NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        data = malloc(len);
+        if (data != NULL && fread(data, 1, len, fp) != (size_t)len) {
+            free(data);
+            data = NULL;
+        }
+        *size = len;
+    }
+    fclose(fp);
+    return data;
+#else
+    char path[1024];
+    struct stat st;
+    void *data;
+    int fd;
+
+    if (!collision_cache_enabled()) {
+        return NULL;
+    }
+    get_cache_path(path, sizeof(path), key, "");
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            data = NULL;
+        }
+        *size = st.st_size;
+    }
+    close(fd);
+    return data;
+#endif
+}
+
+void collision_cache_unmap(void *data, size_t size) {
+#if defined(TARGET_WEB)
+    (void)data;
+    (void)size;
+#elif defined(_WIN32)
+    (void)size;
+    free(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+void collision_cache_store(uint64_t key, const void *data, size_t size) {
+#ifdef TARGET_WEB
+    (void)key;
+    (void)data;
+    (void)size;
+#else
+    char path[1024];
+    char tempPath[1024];
+    FILE *fp;
+    int ok;
+
+    if (!collision_cache_enabled()) {
+        return;
+    }
+#ifdef _WIN32
+    _mkdir(configCollisionCacheDir);
+#else
+    mkdir(configCollisionCacheDir, 0755);
+#endif
+
+    // Write to a temporary file first so that an interrupted write never leaves a truncated blob.
+    get_cache_path(path, sizeof(path), key, "");
+    get_cache_path(tempPath, sizeof(tempPath), key, ".tmp");
+    fp = fopen(tempPath, "wb");
+    if (fp == NULL) {
+        return;
+    }
+    ok = fwrite(data, 1, size, fp) == size;
+    ok = fclose(fp) == 0 && ok;
+    if (ok) {
+#ifdef _WIN32
+        remove(path);
+#endif
+        ok = rename(tempPath, path) == 0;
+    }
+    if (!ok) {
+        remove(tempPath);
+    }
+#endif
+}
@@ -0,0 +1,18 @@
+#ifndef COLLISION_CACHE_H
+#define COLLISION_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Files holding prebuilt static collision partitions, one per area, named after a hash of the
+// area's terrain. The contents are up to the caller; the mapping is private, so the caller may
+// write to it (e.g. to fix up offsets into pointers) without touching the file.
+
+int collision_cache_enabled(void);
+// Map the cached blob for key, returning NULL if there is none or caching is disabled.
+void *collision_cache_map(uint64_t key, size_t *size);
+void collision_cache_unmap(void *data, size_t size);
+// Write a blob for key. Failures are ignored, the partition is simply rebuilt next time.
+void collision_cache_store(uint64_t key, const void *data, size_t size);
+
+#endif
@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "sm64.h"
+#include "engine/surface_load.h"
+#include "game/area.h"
+#include "game/game_init.h"
+#include "game/object_list_processor.h"
+
+#include "collision_profiler.h"
+
+#ifdef COLLISION_PROFILER
+
+#define PROFILE_FILE "collision_profile.txt"
+
+// Distinct (query type, caller, behavior) triples that are tracked per area.
+#define MAX_CALL_SITES 2048
+
+#define FRAME_REPORT_SITES 5
+#define AREA_REPORT_SITES 32
+#define AREA_REPORT_CELLS 16
+
+struct CallSiteStats {
+    u32 calls;
+    u32 scanned;
+    uint64_t ns;
+};
+
+struct CallSite {
+    void *caller;
+    const BehaviorScript *behavior;
+    s32 type;
+    s32 used;
+    struct CallSiteStats frame;
+    struct CallSiteStats area;
+};
+
+struct CellStats {
+    u32 calls;
+    u32 scanned;
+    uint64_t ns;
+};
+
+u32 gCollisionProfilerScanned;
+
+static const char *sQueryTypeNames[COLLISION_QUERY_TYPES] = { "floor", "ceil", "wall", "ray" };
+
+static FILE *sReport;
+static struct CallSite sCallSites[MAX_CALL_SITES];
+static s32 sNumCallSites;
+static u32 sDroppedCalls;
+static struct CellStats sCells[NUM_CELLS][NUM_CELLS];
+static struct CallSiteStats sFrameTypes[COLLISION_QUERY_TYPES];
+static struct CallSiteStats sAreaTypes[COLLISION_QUERY_TYPES];
+static u32 sAreaFrames;
+static s16 sAreaLevel = -1;
+static s16 sAreaIndex;
+static s32 sInObjectUpdates;
+
+// The query in progress.
+static s32 sDepth;
+static s32 sQueryType;
+static void *sQueryCaller;
+static const BehaviorScript *sQueryBehavior;
+static uint64_t sQueryStart;
+static u32 sQueryScannedStart;
+static s32 sQueryCellX, sQueryCellZ;
+static s32 sCurCellX, sCurCellZ;
+static u32 sCellScannedStart;
+
+static uint64_t get_time_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&count);
+    return (uint64_t) (count.QuadPart / freq.QuadPart) * 1000000000
+           + (uint64_t) (count.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void add_stats(struct CallSiteStats *stats, u32 scanned, uint64_t ns) {
+    stats->calls++;
+    stats->scanned += scanned;
+    stats->ns += ns;
+}
+
+static struct CallSite *get_call_site(s32 type, void *caller, const BehaviorScript *behavior) {
+    uintptr_t hash = ((uintptr_t) caller >> 2) ^ ((uintptr_t) behavior >> 2) * 31 ^ type;
+    s32 i = hash % MAX_CALL_SITES;
+
+    // Open addressing, the table is only emptied when an area is loaded.
+    while (sCallSites[i].used) {
+        if (sCallSites[i].caller == caller && sCallSites[i].behavior == behavior
+            && sCallSites[i].type == type) {
+            return &sCallSites[i];
+        }
+        i = (i + 1) % MAX_CALL_SITES;
+    }
+    if (sNumCallSites >= MAX_CALL_SITES * 3 / 4) {
+        return NULL;
+    }
+    sNumCallSites++;
+    sCallSites[i].used = TRUE;
+    sCallSites[i].caller = caller;
+    sCallSites[i].behavior = behavior;
+    sCallSites[i].type = type;
+    return &sCallSites[i];
+}
+
+void collision_profiler_begin(s32 type, void *caller) {
+    if (sDepth++ != 0) {
+        return;
+    }
+    sQueryType = type;
+    sQueryCaller = caller;
+    sQueryBehavior = sInObjectUpdates && gCurrentObject != NULL ? gCurrentObject->behavior : NULL;
+    sQueryCellX = sCurCellX = -1;
+    sQueryScannedStart = sCellScannedStart = gCollisionProfilerScanned;
+    sQueryStart = get_time_ns();
+}
+
+static void finish_cell(void) {
+    if (sCurCellX >= 0) {
+        sCells[sCurCellZ][sCurCellX].scanned += gCollisionProfilerScanned - sCellScannedStart;
+    }
+    sCellScannedStart = gCollisionProfilerScanned;
+}
+
+void collision_profiler_cell(s32 cellX, s32 cellZ) {
+    if (sDepth == 0) {
+        return;
+    }
+    finish_cell();
+    if (sQueryCellX < 0) {
+        sQueryCellX = cellX;
+        sQueryCellZ = cellZ;
+    }
+    sCurCellX = cellX;
+    sCurCellZ = cellZ;
+}
+
+void collision_profiler_end(void) {
+    struct CallSite *site;
+    uint64_t ns;
+    u32 scanned;
+
+    if (--sDepth != 0) {
+        return;
+    }
+    ns = get_time_ns() - sQueryStart;
+    finish_cell();
+    scanned = gCollisionProfilerScanned - sQueryScannedStart;
+
+    add_stats(&sFrameTypes[sQueryType], scanned, ns);
+
+    // The whole query is charged to the cell it started in.
+    if (sQueryCellX >= 0) {
+        sCells[sQueryCellZ][sQueryCellX].calls++;
+        sCells[sQueryCellZ][sQueryCellX].ns += ns;
+    }
+
+    site = get_call_site(sQueryType, sQueryCaller, sQueryBehavior);
+    if (site != NULL) {
+        add_stats(&site->frame, scanned, ns);
+    } else {
+        sDroppedCalls++;
+    }
+}
+
+void collision_profiler_set_object_updates(s32 active) {
+    sInObjectUpdates = active;
+}
+
+static void open_report(void) {
+    if (sReport == NULL) {
+        sReport = fopen(PROFILE_FILE, "w");
+        atexit(collision_profiler_area_loaded);
+    }
+}
+
+static void print_call_site(struct CallSite *site, struct CallSiteStats *stats) {
+    fprintf(sReport, "  %8.3f ms %6u %-5s %8u surfaces  caller %p", stats->ns / 1000000.0, stats->calls,
+            sQueryTypeNames[site->type], stats->scanned, site->caller);
+    if (site->behavior != NULL) {
+        fprintf(sReport, "  behavior %p", (void *) site->behavior);
+    }
+    fprintf(sReport, "\n");
+}
+
+/**
+ * Find the count most expensive call sites by frame or area time, most expensive first.
+ */
+static s32 find_top_call_sites(struct CallSite **top, s32 count, s32 area) {
+    s32 numTop = 0;
+    s32 i, j;
+
+    for (i = 0; i < MAX_CALL_SITES; i++) {
+        struct CallSite *site = &sCallSites[i];
+        uint64_t ns = area ? site->area.ns : site->frame.ns;
+
+        if (!site->used || (area ? site->area.calls : site->frame.calls) == 0) {
+            continue;
+        }
+        for (j = numTop; j > 0 && ns > (area ? top[j - 1]->area.ns : top[j - 1]->frame.ns); j--) {
+            if (j < count) {
+                top[j] = top[j - 1];
+            }
+        }
+        if (j < count) {
+            top[j] = site;
+            if (numTop < count) {
+                numTop++;
+            }
+        }
+    }
+    return numTop;
+}
+
+static void print_totals(struct CallSiteStats *types) {
+    struct CallSiteStats total;
+    s32 i;
+
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < COLLISION_QUERY_TYPES; i++) {
+        total.calls += types[i].calls;
+        total.scanned += types[i].scanned;
+        total.ns += types[i].ns;
+    }
+    fprintf(sReport, "%u queries (", total.calls);
+    for (i = 0; i < COLLISION_QUERY_TYPES; i++) {
+        fprintf(sReport, "%s%s %u", i != 0 ? ", " : "", sQueryTypeNames[i], types[i].calls);
+    }
+    fprintf(sReport, "), %u surfaces, %.3f ms", total.scanned, total.ns / 1000000.0);
+}
+
+void collision_profiler_end_frame(void) {
+    struct CallSite *top[FRAME_REPORT_SITES];
+    s32 numTop, i;
+
+    sAreaFrames++;
+
+    for (i = 0; i < COLLISION_QUERY_TYPES; i++) {
+        if (sFrameTypes[i].calls != 0) {
+            break;
+        }
+    }
+    if (i == COLLISION_QUERY_TYPES) {
+        return;
+    }
+
+    open_report();
+    if (sReport != NULL) {
+        fprintf(sReport, "frame %u: ", gGlobalTimer);
+        print_totals(sFrameTypes);
+        fprintf(sReport, "\n");
+        numTop = find_top_call_sites(top, FRAME_REPORT_SITES, FALSE);
+        for (i = 0; i < numTop; i++) {
+            print_call_site(top[i], &top[i]->frame);
+        }
+    }
+
+    for (i = 0; i < COLLISION_QUERY_TYPES; i++) {
+        sAreaTypes[i].calls += sFrameTypes[i].calls;
+        sAreaTypes[i].scanned += sFrameTypes[i].scanned;
+        sAreaTypes[i].ns += sFrameTypes[i].ns;
+    }
+    memset(sFrameTypes, 0, sizeof(sFrameTypes));
+    for (i = 0; i < MAX_CALL_SITES; i++) {
+        if (sCallSites[i].used) {
+            sCallSites[i].area.calls += sCallSites[i].frame.calls;
+            sCallSites[i].area.scanned += sCallSites[i].frame.scanned;
+            sCallSites[i].area.ns += sCallSites[i].frame.ns;
+            memset(&sCallSites[i].frame, 0, sizeof(sCallSites[i].frame));
+        }
+    }
+}
+
+static void print_cells(void) {
+    struct CellStats *top[AREA_REPORT_CELLS];
+    uint64_t maxNs = 0;
+    s32 numTop = 0;
+    s32 cellX, cellZ, minX, minZ, i, j;
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            struct CellStats *cell = &sCells[cellZ][cellX];
+
+            if (cell->calls == 0) {
+                continue;
+            }
+            if (cell->ns > maxNs) {
+                maxNs = cell->ns;
+            }
+            for (j = numTop; j > 0 && cell->ns > top[j - 1]->ns; j--) {
+                if (j < AREA_REPORT_CELLS) {
+                    top[j] = top[j - 1];
+                }
+            }
+            if (j < AREA_REPORT_CELLS) {
+                top[j] = cell;
+                if (numTop < AREA_REPORT_CELLS) {
+                    numTop++;
+                }
+            }
+        }
+    }
+
+    fprintf(sReport, "cells by time (x, z ranges in level units):\n");
+    for (i = 0; i < numTop; i++) {
+        cellX = (top[i] - &sCells[0][0]) % NUM_CELLS;
+        cellZ = (top[i] - &sCells[0][0]) / NUM_CELLS;
+        minX = cellX * CELL_SIZE - LEVEL_BOUNDARY_MAX;
+        minZ = cellZ * CELL_SIZE - LEVEL_BOUNDARY_MAX;
+        fprintf(sReport, "  %8.3f ms %6u queries %8u surfaces  cell %2d,%2d  x %6d..%6d  z %6d..%6d\n",
+                top[i]->ns / 1000000.0, top[i]->calls, top[i]->scanned, cellX, cellZ,
+                minX, minX + CELL_SIZE, minZ, minZ + CELL_SIZE);
+    }
+
+    // One character per cell, x to the right and z down. 1-9 is the time relative to the
+    // hottest cell, '.' is a cell that was never queried.
+    fprintf(sReport, "heat map:\n");
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        fprintf(sReport, "  ");
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            struct CellStats *cell = &sCells[cellZ][cellX];
+
+            if (cell->calls == 0) {
+                fputc('.', sReport);
+            } else {
+                fputc('0' + (s32) ((cell->ns * 9 + maxNs - 1) / maxNs), sReport);
+            }
+        }
+        fputc('\n', sReport);
+    }
+}
+
+void collision_profiler_area_loaded(void) {
+    struct CallSite *top[AREA_REPORT_SITES];
+    s32 numTop, i;
+
+    if (sAreaLevel != -1 && sAreaFrames != 0) {
+        open_report();
+    }
+    if (sReport != NULL && sAreaLevel != -1 && sAreaFrames != 0) {
+        fprintf(sReport, "\n== level %d area %d, %u frames: ", sAreaLevel, sAreaIndex, sAreaFrames);
+        print_totals(sAreaTypes);
+        fprintf(sReport, " ==\n");
+        if (sDroppedCalls != 0) {
+            fprintf(sReport, "(%u queries from call sites that didn't fit in the table)\n", sDroppedCalls);
+        }
+        fprintf(sReport, "call sites by time:\n");
+        numTop = find_top_call_sites(top, AREA_REPORT_SITES, TRUE);
+        for (i = 0; i < numTop; i++) {
+            print_call_site(top[i], &top[i]->area);
+        }
+        print_cells();
+        fprintf(sReport, "\n");
+        fflush(sReport);
+    }
+
+    // Queries made before the first area was loaded aren't reported.
+    memset(sCallSites, 0, sizeof(sCallSites));
+    sNumCallSites = 0;
+    sDroppedCalls = 0;
+    memset(sCells, 0, sizeof(sCells));
+    memset(sFrameTypes, 0, sizeof(sFrameTypes));
+    memset(sAreaTypes, 0, sizeof(sAreaTypes));
+    sAreaFrames = 0;
+    sAreaLevel = gCurrLevelNum;
+    sAreaIndex = gCurrAreaIndex;
+}
+
+#endif
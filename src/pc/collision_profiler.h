@@ -0,0 +1,38 @@
+#ifndef COLLISION_PROFILER_H
+#define COLLISION_PROFILER_H
+
+#include <PR/ultratypes.h>
+
+// Collision query profiling, enabled with COLLISION_PROFILER in config.h. Each query is timed
+// and charged to its call site: the return address of the outermost collision function that was
+// called, and the behavior of the object being updated, if any. Addresses can be turned into
+// function names with addr2line -f -e <executable>.
+//
+// Every frame, a line with the frame's totals and its most expensive call sites is written to
+// collision_profile.txt. When an area is left or the game exits, the area's totals follow: its
+// most expensive call sites and cells, and a heat map of the time spent in each cell.
+
+enum CollisionQueryType {
+    COLLISION_QUERY_FLOOR,
+    COLLISION_QUERY_CEIL,
+    COLLISION_QUERY_WALL,
+    COLLISION_QUERY_RAY,
+    COLLISION_QUERY_TYPES
+};
+
+// Surfaces looked at by the collision functions, they add to it directly.
+extern u32 gCollisionProfilerScanned;
+
+// Queries may nest (find_floor_height calls find_floor), only the outermost one is recorded.
+void collision_profiler_begin(s32 type, void *caller);
+// The query moved on to another cell, surfaces scanned from now on are counted against it.
+void collision_profiler_cell(s32 cellX, s32 cellZ);
+void collision_profiler_end(void);
+
+// Queries are only charged to gCurrentObject's behavior while objects are being updated.
+void collision_profiler_set_object_updates(s32 active);
+void collision_profiler_end_frame(void);
+// Write the report for the area being left, if any, and start on the one being loaded.
+void collision_profiler_area_loaded(void);
+
+#endif
@@ -14,6 +14,7 @@ enum ConfigOptionType {
     CONFIG_TYPE_BOOL,
     CONFIG_TYPE_UINT,
     CONFIG_TYPE_FLOAT,
+    CONFIG_TYPE_STRING,
 };
 
 struct ConfigOption {
@@ -23,6 +24,7 @@ struct ConfigOption {
         bool *boolValue;
         unsigned int *uintValue;
         float *floatValue;
+        const char **stringValue;
     };
 };
 
@@ -44,6 +46,18 @@ unsigned int configKeyStickUp    = 0x11;
 unsigned int configKeyStickDown  = 0x1F;
 unsigned int configKeyStickLeft  = 0x1E;
 unsigned int configKeyStickRight = 0x20;
+// Audio
+unsigned int configAudioVoices   = 0; // 0 = use the session preset's voice count
+const char *configAudioAlsaDevice = "default";
+bool configAudioAlsaMmap         = false;
+unsigned int configAudioPeriodSize = 0; // in sample frames, 0 = let the backend decide
+unsigned int configAudioBufferSize = 0; // in sample frames, 0 = backend default
+unsigned int configAudioLatency  = 0; // target queued frames, 0 = backend default
+bool configAudioForceNull        = false;
+float configAudioNullSpeed       = 1.0f; // 0 = advance one game frame per submitted buffer
+const char *configAudioNullDump  = "none"; // raw 32 kHz stereo s16 output
+const char *configCollisionCacheDir = "collision_cache"; // "none" = always build the partitions
+unsigned int configWorkerThreads    = 0; // threads for parallel object updates, 0 = one less than the CPU count
 
 
 static const struct ConfigOption options[] = {
@@ -61,6 +75,17 @@ static const struct ConfigOption options[] = {
     {.name = "key_stickdown",  .type = CONFIG_TYPE_UINT, .uintValue = &configKeyStickDown},
     {.name = "key_stickleft",  .type = CONFIG_TYPE_UINT, .uintValue = &configKeyStickLeft},
     {.name = "key_stickright", .type = CONFIG_TYPE_UINT, .uintValue = &configKeyStickRight},
+    {.name = "audio_voices",   .type = CONFIG_TYPE_UINT, .uintValue = &configAudioVoices},
+    {.name = "audio_alsa_device", .type = CONFIG_TYPE_STRING, .stringValue = &configAudioAlsaDevice},
+    {.name = "audio_alsa_mmap",   .type = CONFIG_TYPE_BOOL, .boolValue = &configAudioAlsaMmap},
+    {.name = "audio_period_size", .type = CONFIG_TYPE_UINT, .uintValue = &configAudioPeriodSize},
+    {.name = "audio_buffer_size", .type = CONFIG_TYPE_UINT, .uintValue = &configAudioBufferSize},
+    {.name = "audio_latency",     .type = CONFIG_TYPE_UINT, .uintValue = &configAudioLatency},
+    {.name = "audio_force_null",  .type = CONFIG_TYPE_BOOL, .boolValue = &configAudioForceNull},
+    {.name = "audio_null_speed",  .type = CONFIG_TYPE_FLOAT, .floatValue = &configAudioNullSpeed},
+    {.name = "audio_null_dump",   .type = CONFIG_TYPE_STRING, .stringValue = &configAudioNullDump},
+    {.name = "collision_cache_dir", .type = CONFIG_TYPE_STRING, .stringValue = &configCollisionCacheDir},
+    {.name = "worker_threads",      .type = CONFIG_TYPE_UINT, .uintValue = &configWorkerThreads},
 };
 
 // Reads an entire line from a file (excluding the newline character) and returns an allocated string
@@ -188,6 +213,9 @@ void configfile_load(const char *filename) {
                         case CONFIG_TYPE_FLOAT:
                             sscanf(tokens[1], "%f", option->floatValue);
                             break;
+                        case CONFIG_TYPE_STRING:
+                            *option->stringValue = strdup(tokens[1]);
+                            break;
                         default:
                             assert(0); // bad type
                     }
@@ -227,6 +255,9 @@ void configfile_save(const char *filename) {
             case CONFIG_TYPE_FLOAT:
                 fprintf(file, "%s %f\n", option->name, *option->floatValue);
                 break;
+            case CONFIG_TYPE_STRING:
+                fprintf(file, "%s %s\n", option->name, *option->stringValue);
+                break;
             default:
                 assert(0); // unknown type
         }
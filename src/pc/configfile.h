@@ -15,6 +15,17 @@ extern unsigned int configKeyStickUp;
 extern unsigned int configKeyStickDown;
 extern unsigned int configKeyStickLeft;
 extern unsigned int configKeyStickRight;
+extern unsigned int configAudioVoices;
+extern const char  *configAudioAlsaDevice;
+extern bool         configAudioAlsaMmap;
+extern unsigned int configAudioPeriodSize;
+extern unsigned int configAudioBufferSize;
+extern unsigned int configAudioLatency;
+extern bool         configAudioForceNull;
+extern float        configAudioNullSpeed;
+extern const char  *configAudioNullDump;
+extern const char  *configCollisionCacheDir;
+extern unsigned int configWorkerThreads;
 
 void configfile_load(const char *filename);
 void configfile_save(const char *filename);
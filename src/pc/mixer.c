@@ -989,6 +989,105 @@ void aMixImpl(int16_t gain, uint16_t in_addr, uint16_t out_addr) {
     }
 }
 
+#if HAS_SSE41
+static inline __m128i reverb_mix_vec(__m128i out, __m128i in, int16_t gain, __m128i gain_vec) {
+    return gain == -0x8000 ? _mm_subs_epi16(out, in) : _mm_adds_epi16(out, _mm_mulhrs_epi16(in, gain_vec));
+}
+#elif !HAS_NEON
+static inline int16_t reverb_mix_sample(int16_t out, int16_t in, int16_t gain) {
+    if (gain == -0x8000) {
+        return clamp16(out - in);
+    }
+    return clamp16(((out * 0x7fff + in * gain) + 0x4000) >> 15);
+}
+#endif
+
+void aReverbMixImpl(int16_t gain, uint16_t wet_addr, uint16_t dry_addr, enum ReverbMixMode mode, int nbytes) {
+    int16_t *wet = BUF_S16(wet_addr);
+    int16_t *dry = BUF_S16(dry_addr);
+#if HAS_SSE41
+    __m128i gain_vec = _mm_set1_epi16(gain);
+    __m128i one_vec = _mm_set1_epi16(0x7fff);
+    __m128i w, d;
+#elif HAS_NEON
+    int16x8_t w, d;
+#else
+    int i;
+    int16_t w, d;
+#endif
+
+    nbytes = ROUND_UP_32(nbytes);
+    while (nbytes > 0) {
+#if HAS_SSE41
+        w = _mm_loadu_si128((const __m128i *)wet);
+        switch (mode) {
+            case REVERB_MIX_COPY_TO_DRY:
+                _mm_storeu_si128((__m128i *)dry, w);
+                _mm_storeu_si128((__m128i *)wet, reverb_mix_vec(w, w, gain, gain_vec));
+                break;
+            case REVERB_MIX_ADD_TO_DRY:
+                d = _mm_loadu_si128((const __m128i *)dry);
+                _mm_storeu_si128((__m128i *)dry, reverb_mix_vec(d, w, 0x7fff, one_vec));
+                _mm_storeu_si128((__m128i *)wet, reverb_mix_vec(w, w, gain, gain_vec));
+                break;
+            case REVERB_MIX_COPY_FROM_DRY:
+                d = _mm_loadu_si128((const __m128i *)dry);
+                d = reverb_mix_vec(d, d, gain, gain_vec);
+                _mm_storeu_si128((__m128i *)dry, d);
+                _mm_storeu_si128((__m128i *)wet, d);
+                break;
+        }
+        wet += 8;
+        dry += 8;
+        nbytes -= 8 * sizeof(int16_t);
+#elif HAS_NEON
+        w = vld1q_s16(wet);
+        switch (mode) {
+            case REVERB_MIX_COPY_TO_DRY:
+                vst1q_s16(dry, w);
+                vst1q_s16(wet, vqaddq_s16(w, vqrdmulhq_n_s16(w, gain)));
+                break;
+            case REVERB_MIX_ADD_TO_DRY:
+                d = vld1q_s16(dry);
+                vst1q_s16(dry, vqaddq_s16(d, vqrdmulhq_n_s16(w, 0x7fff)));
+                vst1q_s16(wet, vqaddq_s16(w, vqrdmulhq_n_s16(w, gain)));
+                break;
+            case REVERB_MIX_COPY_FROM_DRY:
+                d = vld1q_s16(dry);
+                d = vqaddq_s16(d, vqrdmulhq_n_s16(d, gain));
+                vst1q_s16(dry, d);
+                vst1q_s16(wet, d);
+                break;
+        }
+        wet += 8;
+        dry += 8;
+        nbytes -= 8 * sizeof(int16_t);
+#else
+        for (i = 0; i < 8; i++) {
+            w = *wet;
+            switch (mode) {
+                case REVERB_MIX_COPY_TO_DRY:
+                    *dry = w;
+                    *wet = reverb_mix_sample(w, w, gain);
+                    break;
+                case REVERB_MIX_ADD_TO_DRY:
+                    *dry = reverb_mix_sample(*dry, w, 0x7fff);
+                    *wet = reverb_mix_sample(w, w, gain);
+                    break;
+                case REVERB_MIX_COPY_FROM_DRY:
+                    d = reverb_mix_sample(*dry, *dry, gain);
+                    *dry = d;
+                    *wet = d;
+                    break;
+            }
+            wet++;
+            dry++;
+        }
+        nbytes -= 8 * sizeof(int16_t);
+#endif
+    }
+}
+
 #ifdef NEW_AUDIO_UCODE
 void aS8DecImpl(uint8_t flags, ADPCM_STATE state) {
     uint8_t *in = BUF_U8(rspa.in);
@@ -44,6 +44,15 @@ void aSetLoopImpl(ADPCM_STATE *adpcm_loop_state);
 void aADPCMdecImpl(uint8_t flags, ADPCM_STATE state);
 void aResampleImpl(uint8_t flags, uint16_t pitch, RESAMPLE_STATE state);
 
+// Modes for aReverbMixImpl, which does the work of the aDMEMMove/aMix sequences the
+// reverb code emits in a single pass. "mix" has the same rounding as aMix.
+enum ReverbMixMode {
+    REVERB_MIX_COPY_TO_DRY,   // dry = wet, then wet = mix(wet, wet, gain)
+    REVERB_MIX_ADD_TO_DRY,    // dry = mix(dry, wet, 0x7fff), then wet = mix(wet, wet, gain)
+    REVERB_MIX_COPY_FROM_DRY, // dry = mix(dry, dry, gain), then wet = dry
+};
+void aReverbMixImpl(int16_t gain, uint16_t wet_addr, uint16_t dry_addr, enum ReverbMixMode mode, int nbytes);
+
 #ifndef NEW_AUDIO_UCODE
 void aSetVolumeImpl(uint8_t flags, int16_t v, int16_t t, int16_t r);
 void aLoadBufferImpl(const void *source_addr);
@@ -81,6 +90,7 @@ void aUnknown25Impl(uint8_t f, uint16_t count, uint16_t out_addr, uint16_t in_ad
 #define aSetLoop(pkt, a) aSetLoopImpl(a)
 #define aADPCMdec(pkt, f, s) aADPCMdecImpl(f, s)
 #define aResample(pkt, f, p, s) aResampleImpl(f, p, s)
+#define aReverbMix(pkt, g, w, d, m, c) aReverbMixImpl(g, w, d, m, c)
 
 #ifndef NEW_AUDIO_UCODE
 #define aSetVolume(pkt, f, v, t, r) aSetVolumeImpl(f, v, t, r)
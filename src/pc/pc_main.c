@@ -29,6 +29,12 @@
 #include "controller/controller_keyboard.h"
 
 #include "configfile.h"
+#ifdef COLLISION_PROFILER
+#include "collision_profiler.h"
+#endif
+#ifdef BEHAVIOR_PROFILER
+#include "behavior_profiler.h"
+#endif
 
 #include "compat.h"
 
@@ -85,6 +91,9 @@ void exec_display_list(struct SPTask *spTask) {
 void produce_one_frame(void) {
     gfx_start_frame();
     game_loop_one_iteration();
+#ifdef COLLISION_PROFILER
+    collision_profiler_end_frame();
+#endif
     
     int samples_left = audio_api->buffered();
     u32 num_audio_samples = samples_left < audio_api->get_desired_buffered() ? SAMPLES_HIGH : SAMPLES_LOW;
@@ -144,6 +153,15 @@ static void on_fullscreen_changed(bool is_now_fullscreen) {
     configFullscreen = is_now_fullscreen;
 }
 
+#ifdef BEHAVIOR_PROFILER
+static bool on_key_down(int scancode) {
+    if (behavior_profiler_on_key_down(scancode)) {
+        return true;
+    }
+    return keyboard_on_key_down(scancode);
+}
+#endif
+
 void main_func(void) {
 #ifdef USE_SYSTEM_MALLOC
     main_pool_init();
@@ -183,8 +201,15 @@ void main_func(void) {
     gfx_init(wm_api, rendering_api, "Super Mario 64 PC-Port", configFullscreen);
     
     wm_api->set_fullscreen_changed_callback(on_fullscreen_changed);
+#ifdef BEHAVIOR_PROFILER
+    wm_api->set_keyboard_callbacks(on_key_down, keyboard_on_key_up, keyboard_on_all_keys_up);
+#else
     wm_api->set_keyboard_callbacks(keyboard_on_key_down, keyboard_on_key_up, keyboard_on_all_keys_up);
+#endif
     
+    if (configAudioForceNull && audio_null.init()) {
+        audio_api = &audio_null;
+    }
 #if HAVE_WASAPI
     if (audio_api == NULL && audio_wasapi.init()) {
         audio_api = &audio_wasapi;
@@ -206,9 +231,11 @@ void main_func(void) {
     }
 #endif
     if (audio_api == NULL) {
+        audio_null.init();
         audio_api = &audio_null;
     }
 
+    gAudioVoiceCount = configAudioVoices;
     audio_init();
     sound_init();
 
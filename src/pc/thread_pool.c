@@ -0,0 +1,174 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(TARGET_WEB)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "thread_pool.h"
+#include "configfile.h"
+
+// The web build has no threads, so it always runs the job on the calling thread.
+
+#define MAX_WORKERS 7
+
+#ifndef TARGET_WEB
+#ifdef _WIN32
+static CRITICAL_SECTION sLock;
+static CONDITION_VARIABLE sWorkCond;
+static CONDITION_VARIABLE sDoneCond;
+#define LOCK() EnterCriticalSection(&sLock)
+#define UNLOCK() LeaveCriticalSection(&sLock)
+#define WAIT(cond) SleepConditionVariableCS(&cond, &sLock, INFINITE)
+#define WAKE_ALL(cond) WakeAllConditionVariable(&cond)
+#else
+static pthread_mutex_t sLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sWorkCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sDoneCond = PTHREAD_COND_INITIALIZER;
+#define LOCK() pthread_mutex_lock(&sLock)
+#define UNLOCK() pthread_mutex_unlock(&sLock)
+#define WAIT(cond) pthread_cond_wait(&cond, &sLock)
+#define WAKE_ALL(cond) pthread_cond_broadcast(&cond)
+#endif
+
+static int sNumWorkers = -1;
+
+// The current job. sGeneration changes for every job so the workers can tell a new one apart.
+static ThreadPoolJob sJob;
+static void *sJobArg;
+static int sJobCount;
+static int sJobChunk;
+static int sNextStart;
+static unsigned int sGeneration;
+static int sBusyWorkers;
+
+/**
+ * Take the next range of the current job, or return false if there is none left.
+ */
+static bool take_range(int *start, int *end) {
+    *start = __atomic_fetch_add(&sNextStart, sJobChunk, __ATOMIC_RELAXED);
+    if (*start >= sJobCount) {
+        return false;
+    }
+    *end = *start + sJobChunk < sJobCount ? *start + sJobChunk : sJobCount;
+    return true;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID unused) {
+#else
+static void *worker_main(void *unused) {
+#endif
+    unsigned int generation = 0;
+    int start, end;
+
+    (void)unused;
+    LOCK();
+    while (true) {
+        while (sGeneration == generation) {
+            WAIT(sWorkCond);
+        }
+        generation = sGeneration;
+        UNLOCK();
+
+        while (take_range(&start, &end)) {
+            sJob(sJobArg, start, end);
+        }
+
+        LOCK();
+        if (--sBusyWorkers == 0) {
+            WAKE_ALL(sDoneCond);
+        }
+    }
+    return 0;
+}
+
+static int get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? count : 1;
+#endif
+}
+
+static void start_workers(void) {
+    int i;
+
+    sNumWorkers = configWorkerThreads != 0 ? (int) configWorkerThreads - 1 : get_cpu_count() - 1;
+    if (sNumWorkers > MAX_WORKERS) {
+        sNumWorkers = MAX_WORKERS;
+    }
+#ifdef _WIN32
+    InitializeCriticalSection(&sLock);
+    InitializeConditionVariable(&sWorkCond);
+    InitializeConditionVariable(&sDoneCond);
+#endif
+    for (i = 0; i < sNumWorkers; i++) {
+#ifdef _WIN32
+        HANDLE thread = CreateThread(NULL, 0, worker_main, NULL, 0, NULL);
+
+        if (thread == NULL) {
+            break;
+        }
+        CloseHandle(thread);
+#else
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, worker_main, NULL) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+#endif
+    }
+    sNumWorkers = i;
+}
+#endif
+
+void thread_pool_run(ThreadPoolJob job, void *arg, int count, int minPerThread) {
+#ifndef TARGET_WEB
+    int numRanges, start, end;
+
+    if (sNumWorkers < 0) {
+        start_workers();
+    }
+
+    numRanges = minPerThread > 0 ? count / minPerThread : count;
+    if (numRanges > sNumWorkers + 1) {
+        numRanges = sNumWorkers + 1;
+    }
+    if (numRanges > 1) {
+        LOCK();
+        sJob = job;
+        sJobArg = arg;
+        sJobCount = count;
+        sJobChunk = (count + numRanges - 1) / numRanges;
+        sNextStart = 0;
+        sBusyWorkers = sNumWorkers;
+        sGeneration++;
+        WAKE_ALL(sWorkCond);
+        UNLOCK();
+
+        while (take_range(&start, &end)) {
+            job(arg, start, end);
+        }
+
+        LOCK();
+        while (sBusyWorkers != 0) {
+            WAIT(sDoneCond);
+        }
+        UNLOCK();
+        return;
+    }
+#endif
+    if (count > 0) {
+        job(arg, 0, count);
+    }
+}
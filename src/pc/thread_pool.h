@@ -0,0 +1,14 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// A few persistent worker threads for splitting a loop over independent items. The threads are
+// started on first use, and configWorkerThreads sets how many there are.
+
+typedef void (*ThreadPoolJob)(void *arg, int start, int end);
+
+// Call job on consecutive ranges covering [0, count), spread over the workers and the calling
+// thread, and return once all of them are done. Ranges hold at least minPerThread items, so
+// small loops run on the calling thread alone. Must only be called from one thread.
+void thread_pool_run(ThreadPoolJob job, void *arg, int count, int minPerThread);
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ * Replays random frames of objects loading their collision, and checks after each frame that
+ * the dynamic partition, which keeps object surfaces between frames, holds the same surfaces
+ * in the same order as the partition the original code rebuilds every frame. The objects
+ * stand still, move, turn, jump around, disappear by scaling to zero, change rooms, go out of
+ * range, load twice in a frame, swap their update order, get deleted and have their slots
+ * reused. Time stop and area reloads happen in between.
+ *
+ * usage: dynamic_surface_test [seed] [frames]
+ */
+#include "engine/surface_load.c"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "object_fields.h"
+#include "random_area.h"
+#include "reference.h"
+
+#define NUM_OBJECTS 80
+#define NUM_MODELS 14
+
+enum ObjectMotion {
+    MOTION_STILL,
+    MOTION_SLIDE,
+    MOTION_JITTER,
+    MOTION_TURN,
+    MOTION_TELEPORT,
+    MOTION_COUNT
+};
+
+static struct Object sObjects[NUM_OBJECTS];
+static s32 sObjectMotion[NUM_OBJECTS];
+static f32 sObjectYaw[NUM_OBJECTS];
+static s32 sUpdateOrder[NUM_OBJECTS];
+static s32 sNumUpdated;
+static s32 sFreeSlots[NUM_OBJECTS];
+static s32 sNumFreeSlots;
+static s32 sNumSlotsUsed;
+static s16 sModels[NUM_MODELS][2000];
+static SpatialPartitionCell sRefPartition[NUM_CELLS][NUM_CELLS];
+
+static s16 sTerrain[] = {
+    TERRAIN_LOAD_VERTICES, 4,
+    -8000, 0, -8000, 8000, 0, -8000, 8000, 0, 8000, -8000, 0, 8000,
+    SURFACE_DEFAULT, 2,
+    0, 2, 1, 0, 3, 2,
+    TERRAIN_LOAD_CONTINUE,
+    TERRAIN_LOAD_END,
+};
+
+/**
+ * Build the collision of a random model: a few groups of triangles between random vertices,
+ * some of them flat, some degenerate.
+ */
+static void build_model(s16 *data, s32 size) {
+    static const s16 types[] = {
+        SURFACE_DEFAULT, SURFACE_DEFAULT, SURFACE_DEFAULT, SURFACE_FLOWING_WATER,
+        SURFACE_NO_CAM_COLLISION, SURFACE_CAMERA_BOUNDARY,
+    };
+    s32 numVertices = random_range(3, 40);
+    s32 numGroups = random_range(1, 4);
+    s32 i, group;
+
+    *data++ = TERRAIN_LOAD_VERTICES;
+    *data++ = numVertices;
+    for (i = 0; i < numVertices; i++) {
+        *data++ = random_range(-size, size);
+        *data++ = random_range(0, 2) == 0 ? 0 : random_range(-size / 2, size / 2);
+        *data++ = random_range(-size, size);
+    }
+
+    for (group = 0; group < numGroups; group++) {
+        s16 type = types[random_range(0, ARRAY_COUNT(types) - 1)];
+        s32 numSurfaces = random_range(1, 20);
+
+        *data++ = type;
+        *data++ = numSurfaces;
+        for (i = 0; i < numSurfaces; i++) {
+            *data++ = random_range(0, numVertices - 1);
+            *data++ = random_range(0, numVertices - 1);
+            *data++ = random_range(0, numVertices - 1);
+            if (type == SURFACE_FLOWING_WATER) {
+                *data++ = random_range(0, 255);
+            }
+        }
+    }
+
+    *data++ = TERRAIN_LOAD_CONTINUE;
+    *data++ = TERRAIN_LOAD_END;
+}
+
+static void update_transform(s32 i) {
+    struct Object *obj = &sObjects[i];
+    f32 c = cosf(sObjectYaw[i]);
+    f32 s = sinf(sObjectYaw[i]);
+
+    bzero(obj->transform, sizeof(Mat4));
+    obj->transform[0][0] = c;
+    obj->transform[0][2] = -s;
+    obj->transform[1][1] = 1.0f;
+    obj->transform[2][0] = s;
+    obj->transform[2][2] = c;
+    obj->transform[3][0] = obj->oPosX;
+    obj->transform[3][1] = obj->oPosY;
+    obj->transform[3][2] = obj->oPosZ;
+    obj->transform[3][3] = 1.0f;
+    obj->header.gfx.throwMatrix = &obj->transform;
+}
+
+static void spawn_test_object(void) {
+    struct Object *obj;
+    s32 i;
+
+    if (sNumFreeSlots != 0) {
+        i = sFreeSlots[--sNumFreeSlots];
+    } else if (sNumSlotsUsed < NUM_OBJECTS) {
+        i = sNumSlotsUsed++;
+    } else {
+        return;
+    }
+
+    obj = &sObjects[i];
+    bzero(obj, sizeof(struct Object));
+    obj->activeFlags = ACTIVE_FLAG_ACTIVE;
+    obj->collisionData = sModels[random_range(0, NUM_MODELS - 1)];
+    obj->behavior = random_range(0, 10) == 0 ? bhvDddWarp : NULL;
+    obj->oPosX = random_range(-7000, 7000);
+    obj->oPosY = random_range(0, 3) * 500;
+    obj->oPosZ = random_range(-7000, 7000);
+    obj->oCollisionDistance = 10000.0f;
+    obj->header.gfx.scale[0] = obj->header.gfx.scale[1] = obj->header.gfx.scale[2] =
+        random_range(0, 20) == 0 ? 0.0f : 1.0f;
+    sObjectMotion[i] = random_range(0, MOTION_COUNT - 1);
+    sObjectYaw[i] = 0.0f;
+    sUpdateOrder[sNumUpdated++] = i;
+}
+
+static void move_object(s32 i) {
+    struct Object *obj = &sObjects[i];
+
+    switch (sObjectMotion[i]) {
+        case MOTION_SLIDE:
+            obj->oPosX += 0.3f;
+            break;
+        case MOTION_JITTER:
+            if (random_range(0, 3) == 0) {
+                obj->oPosX += random_range(-40, 40);
+                obj->oPosY += random_range(-20, 20);
+            }
+            break;
+        case MOTION_TURN:
+            sObjectYaw[i] += 0.02f;
+            break;
+        case MOTION_TELEPORT:
+            if (random_range(0, 10) == 0) {
+                obj->oPosX = random_range(-7000, 7000);
+                obj->oPosZ = random_range(-7000, 7000);
+            }
+            break;
+    }
+
+    if (random_range(0, 200) == 0) {
+        obj->header.gfx.scale[1] = obj->header.gfx.scale[0] = obj->header.gfx.scale[2] =
+            obj->header.gfx.scale[0] == 0.0f ? 1.0f : 0.0f;
+    }
+    update_transform(i);
+}
+
+/**
+ * Load the current object's collision in the game and, if the game loads it, in the reference.
+ */
+static void load_collision(void) {
+    if (!(gTimeStopState & TIME_STOP_ACTIVE) && gCurrentObject->oDistanceToMario < gCurrentObject->oCollisionDistance
+        && !(gCurrentObject->activeFlags & ACTIVE_FLAG_IN_DIFFERENT_ROOM)) {
+        ref_load_object_collision(&sRefPartition[0][0], gCurrentObject);
+    }
+    load_object_collision_model();
+}
+
+/**
+ * Compare every list of the dynamic partition, skipping the surfaces that weren't loaded this
+ * frame, with the reference one. Returns the number of lists that differ.
+ */
+static s32 compare_partitions(void) {
+    struct SurfaceNode *node, *refNode;
+    s32 cellX, cellZ, listIndex;
+    s32 numFailed = 0;
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                node = gDynamicSurfacePartition[cellZ][cellX][listIndex].next;
+                refNode = sRefPartition[cellZ][cellX][listIndex].next;
+
+                while (TRUE) {
+                    while (node != NULL && !DYNAMIC_SURFACE_NODE_LOADED(node)) {
+                        node = node->next;
+                    }
+                    if (node == NULL || refNode == NULL || node->surface->object != refNode->surface->object
+                        || !ref_surfaces_equal(node->surface, refNode->surface)) {
+                        break;
+                    }
+                    node = node->next;
+                    refNode = refNode->next;
+                }
+
+                if (node != NULL || refNode != NULL) {
+                    numFailed++;
+                }
+            }
+        }
+    }
+
+    if (gSurfacesAllocated - gNumStaticSurfaces != gRefNumSurfaces
+        || gSurfaceNodesAllocated - gNumStaticSurfaceNodes != gRefNumNodes) {
+        numFailed++;
+    }
+
+    return numFailed;
+}
+
+int main(int argc, char **argv) {
+    s32 numFrames = argc > 2 ? atoi(argv[2]) : 5000;
+    s32 timeStop = 0;
+    s32 numFailed = 0;
+    s32 numReused = 0;
+    s32 numRebuilt = 0;
+    s32 frame, i, j, k;
+
+    gRandomSeed = argc > 1 ? (u32) atoi(argv[1]) : 12345;
+    for (i = 0; i < NUM_MODELS; i++) {
+        build_model(sModels[i], i < 4 ? 100 : (i < 10 ? 600 : 1500));
+    }
+
+    alloc_surface_pools();
+    load_area_terrain(0, sTerrain, NULL, NULL);
+    ref_clear_partition(&sRefPartition[0][0]);
+    for (i = 0; i < 40; i++) {
+        spawn_test_object();
+    }
+
+    for (frame = 0; frame < numFrames; frame++) {
+        if (timeStop > 0) {
+            timeStop--;
+            gTimeStopState = timeStop != 0 ? TIME_STOP_ACTIVE : 0;
+        } else if (random_range(0, 60) == 0) {
+            timeStop = random_range(1, 4);
+            gTimeStopState = TIME_STOP_ACTIVE;
+        }
+
+        clear_dynamic_surfaces();
+        if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
+            ref_clear_partition(&sRefPartition[0][0]);
+        }
+
+        for (j = 0; j < sNumUpdated; j++) {
+            i = sUpdateOrder[j];
+            move_object(i);
+
+            gCurrentObject = &sObjects[i];
+            gCurrentObject->oDistanceToMario = random_range(0, 30) == 0 ? 20000.0f : 0.0f;
+            gCurrentObject->activeFlags = ACTIVE_FLAG_ACTIVE;
+            if (random_range(0, 40) == 0) {
+                gCurrentObject->activeFlags |= ACTIVE_FLAG_IN_DIFFERENT_ROOM;
+            }
+
+            load_collision();
+            if (random_range(0, 50) == 0) {
+                load_collision();
+            }
+            gCurrentObject->activeFlags = ACTIVE_FLAG_ACTIVE;
+        }
+
+        numFailed += compare_partitions();
+        numReused += gDynamicSurfacesReused;
+        numRebuilt += gDynamicSurfacesRebuilt;
+
+        // Delete an object, spawn one in the first free slot, and swap two objects' update order.
+        if (sNumUpdated > 5 && random_range(0, 4) == 0) {
+            j = random_range(0, sNumUpdated - 1);
+            i = sUpdateOrder[j];
+            sObjects[i].activeFlags = ACTIVE_FLAG_DEACTIVATED;
+            memmove(&sUpdateOrder[j], &sUpdateOrder[j + 1], sizeof(s32) * (sNumUpdated - j - 1));
+            sNumUpdated--;
+            sFreeSlots[sNumFreeSlots++] = i;
+        }
+        if (random_range(0, 4) == 0) {
+            spawn_test_object();
+        }
+        if (sNumUpdated > 2 && random_range(0, 30) == 0) {
+            i = random_range(0, sNumUpdated - 1);
+            j = random_range(0, sNumUpdated - 1);
+            k = sUpdateOrder[i];
+            sUpdateOrder[i] = sUpdateOrder[j];
+            sUpdateOrder[j] = k;
+        }
+
+        // Reload the area now and then, with a different floor.
+        if (random_range(0, 300) == 0 && !(gTimeStopState & TIME_STOP_ACTIVE)) {
+            for (i = 0; i < 4; i++) {
+                sTerrain[3 + 3 * i] = random_range(0, 1) ? 0 : 300;
+            }
+            sTerrain[14] = random_range(0, 1) ? SURFACE_DEFAULT : SURFACE_INTANGIBLE;
+            load_area_terrain(0, sTerrain, NULL, NULL);
+            ref_clear_partition(&sRefPartition[0][0]);
+        }
+    }
+
+    printf("%d frames, %d surfaces reused, %d rebuilt, %d mismatched lists\n", numFrames, numReused,
+           numRebuilt, numFailed);
+    return numFailed != 0;
+}
@@ -0,0 +1,156 @@
+#include <string.h>
+
+#include "types.h"
+#include "surface_terrains.h"
+#include "special_preset_names.h"
+#include "level_misc_macros.h"
+#include "macro_preset_names.h"
+#include "level_collision.h"
+
+/*
+ * The terrain of every area in the game.
+ */
+
+#include "levels/bbh/areas/1/collision.inc.c"
+#include "levels/bitdw/areas/1/collision.inc.c"
+#include "levels/bitfs/areas/1/collision.inc.c"
+#include "levels/bits/areas/1/collision.inc.c"
+#include "levels/bob/areas/1/collision.inc.c"
+#include "levels/bowser_1/areas/1/collision.inc.c"
+#include "levels/bowser_2/areas/1/collision.inc.c"
+#include "levels/bowser_3/areas/1/collision.inc.c"
+#include "levels/castle_courtyard/areas/1/collision.inc.c"
+#include "levels/castle_grounds/areas/1/collision.inc.c"
+#include "levels/castle_inside/areas/1/collision.inc.c"
+#include "levels/castle_inside/areas/2/collision.inc.c"
+#include "levels/castle_inside/areas/3/collision.inc.c"
+#include "levels/ccm/areas/1/collision.inc.c"
+#include "levels/ccm/areas/2/collision.inc.c"
+#include "levels/cotmc/areas/1/collision.inc.c"
+#include "levels/ddd/areas/1/collision.inc.c"
+#include "levels/ddd/areas/2/collision.inc.c"
+#include "levels/hmc/areas/1/collision.inc.c"
+#include "levels/jrb/areas/1/collision.inc.c"
+#include "levels/jrb/areas/2/collision.inc.c"
+#include "levels/lll/areas/1/collision.inc.c"
+#include "levels/lll/areas/2/collision.inc.c"
+#include "levels/pss/areas/1/collision.inc.c"
+#include "levels/rr/areas/1/collision.inc.c"
+#include "levels/sa/areas/1/collision.inc.c"
+#include "levels/sl/areas/1/collision.inc.c"
+#include "levels/sl/areas/2/collision.inc.c"
+#include "levels/ssl/areas/1/collision.inc.c"
+#include "levels/ssl/areas/2/collision.inc.c"
+#include "levels/ssl/areas/3/collision.inc.c"
+#include "levels/thi/areas/1/collision.inc.c"
+#include "levels/thi/areas/2/collision.inc.c"
+#include "levels/thi/areas/3/collision.inc.c"
+#include "levels/totwc/areas/1/collision.inc.c"
+#include "levels/ttc/areas/1/collision.inc.c"
+#include "levels/ttm/areas/1/collision.inc.c"
+#include "levels/ttm/areas/2/collision.inc.c"
+#include "levels/ttm/areas/3/collision.inc.c"
+#include "levels/ttm/areas/4/collision.inc.c"
+#include "levels/vcutm/areas/1/collision.inc.c"
+#include "levels/wdw/areas/1/collision.inc.c"
+#include "levels/wdw/areas/2/collision.inc.c"
+#include "levels/wf/areas/1/collision.inc.c"
+#include "levels/wmotr/areas/1/collision.inc.c"
+
+struct LevelCollision gLevelCollision[] = {
+    { "bbh area 1", bbh_seg7_collision_level },
+    { "bitdw area 1", bitdw_seg7_collision_level },
+    { "bitfs area 1", bitfs_seg7_collision_level },
+    { "bits area 1", bits_seg7_collision_level },
+    { "bob area 1", bob_seg7_collision_level },
+    { "bowser_1 area 1", bowser_1_seg7_collision_level },
+    { "bowser_2 area 1", bowser_2_seg7_collision_lava },
+    { "bowser_3 area 1", bowser_3_seg7_collision_level },
+    { "castle_courtyard area 1", castle_courtyard_seg7_collision },
+    { "castle_grounds area 1", castle_grounds_seg7_collision_level },
+    { "castle_inside area 1", inside_castle_seg7_area_1_collision },
+    { "castle_inside area 2", inside_castle_seg7_area_2_collision },
+    { "castle_inside area 3", inside_castle_seg7_area_3_collision },
+    { "ccm area 1", ccm_seg7_area_1_collision },
+    { "ccm area 2", ccm_seg7_area_2_collision },
+    { "cotmc area 1", cotmc_seg7_collision_level },
+    { "ddd area 1", ddd_seg7_area_1_collision },
+    { "ddd area 2", ddd_seg7_area_2_collision },
+    { "hmc area 1", hmc_seg7_collision_level },
+    { "jrb area 1", jrb_seg7_area_1_collision },
+    { "jrb area 2", jrb_seg7_area_2_collision },
+    { "lll area 1", lll_seg7_area_1_collision },
+    { "lll area 2", lll_seg7_area_2_collision },
+    { "pss area 1", pss_seg7_collision },
+    { "rr area 1", rr_seg7_collision_level },
+    { "sa area 1", sa_seg7_collision },
+    { "sl area 1", sl_seg7_area_1_collision },
+    { "sl area 2", sl_seg7_area_2_collision },
+    { "ssl area 1", ssl_seg7_area_1_collision },
+    { "ssl area 2", ssl_seg7_area_2_collision },
+    { "ssl area 3", ssl_seg7_area_3_collision },
+    { "thi area 1", thi_seg7_area_1_collision },
+    { "thi area 2", thi_seg7_area_2_collision },
+    { "thi area 3", thi_seg7_area_3_collision },
+    { "totwc area 1", totwc_seg7_collision },
+    { "ttc area 1", ttc_seg7_collision_level },
+    { "ttm area 1", ttm_seg7_area_1_collision },
+    { "ttm area 2", ttm_seg7_area_2_collision },
+    { "ttm area 3", ttm_seg7_area_3_collision },
+    { "ttm area 4", ttm_seg7_area_4_collision },
+    { "vcutm area 1", vcutm_seg7_collision },
+    { "wdw area 1", wdw_seg7_area_1_collision },
+    { "wdw area 2", wdw_seg7_area_2_collision },
+    { "wf area 1", wf_seg7_collision_070102D8 },
+    { "wmotr area 1", wmotr_seg7_collision },
+    { NULL, NULL },
+};
+
+static s32 surface_has_force(s16 surfaceType) {
+    switch (surfaceType) {
+        case SURFACE_0004:
+        case SURFACE_FLOWING_WATER:
+        case SURFACE_DEEP_MOVING_QUICKSAND:
+        case SURFACE_SHALLOW_MOVING_QUICKSAND:
+        case SURFACE_MOVING_QUICKSAND:
+        case SURFACE_HORIZONTAL_WIND:
+        case SURFACE_INSTANT_MOVING_QUICKSAND:
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * Copy an area's terrain up to its special objects, which the tests can't spawn, and end it
+ * there. Returns the copy.
+ */
+s16 *copy_level_surfaces(const Collision *terrain, s16 *dest) {
+    s16 *data = dest;
+    s16 terrainLoadType;
+    s32 count;
+
+    while (TRUE) {
+        terrainLoadType = *terrain++;
+        *data++ = terrainLoadType;
+
+        if (terrainLoadType == TERRAIN_LOAD_VERTICES) {
+            count = 1 + 3 * terrain[0];
+        } else if (TERRAIN_LOAD_IS_SURFACE_TYPE_LOW(terrainLoadType)
+                   || TERRAIN_LOAD_IS_SURFACE_TYPE_HIGH(terrainLoadType)) {
+            count = 1 + (surface_has_force(terrainLoadType) ? 4 : 3) * terrain[0];
+        } else if (terrainLoadType == TERRAIN_LOAD_CONTINUE) {
+            continue;
+        } else {
+            data[-1] = TERRAIN_LOAD_END;
+            break;
+        }
+
+        memcpy(data, terrain, count * sizeof(s16));
+        data += count;
+        terrain += count;
+    }
+
+    return dest;
+}
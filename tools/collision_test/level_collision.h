@@ -0,0 +1,15 @@
+#ifndef LEVEL_COLLISION_H
+#define LEVEL_COLLISION_H
+
+#include "types.h"
+
+struct LevelCollision {
+    const char *name;
+    const Collision *terrain;
+};
+
+extern struct LevelCollision gLevelCollision[];
+
+s16 *copy_level_surfaces(const Collision *terrain, s16 *dest);
+
+#endif // LEVEL_COLLISION_H
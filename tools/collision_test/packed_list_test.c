@@ -0,0 +1,87 @@
+/*
+ * Checks the packed static surface lists against the original list walkers. Random areas are
+ * loaded through load_area_terrain, and random floor, ceiling and wall queries are run on both
+ * the packed list of their cell and its linked list. The surface found, its height and the
+ * pushed wall data must be identical.
+ *
+ * usage: packed_list_test [seed] [areas] [queries per area]
+ */
+#include "engine/surface_load.c"
+#include "engine/surface_collision.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "random_area.h"
+#include "reference.h"
+
+int main(int argc, char **argv) {
+    static struct Object object;
+    s32 numAreas = argc > 2 ? atoi(argv[2]) : 40;
+    s32 numQueries = argc > 3 ? atoi(argv[3]) : 100000;
+    s32 area, i;
+    s32 x, y, z;
+    s16 cellX, cellZ;
+    s32 numFailed = 0;
+    s32 numHits = 0;
+
+    gRandomSeed = argc > 1 ? (u32) atoi(argv[1]) : 1;
+    alloc_surface_pools();
+
+    for (area = 0; area < numAreas; area++) {
+        load_area_terrain(0, build_random_area(), NULL, NULL);
+
+        for (i = 0; i < numQueries; i++) {
+            struct Surface *listSurf, *packedSurf;
+            struct WallCollisionData listData, packedData;
+            f32 listHeight, packedHeight;
+            s32 listCols, packedCols;
+
+            random_point_in_area(&x, &y, &z);
+            cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+            cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+
+            gCheckingSurfaceCollisionsForCamera = random_range(0, 3) == 0;
+            object.activeFlags = random_range(0, 1) ? ACTIVE_FLAG_MOVE_THROUGH_GRATE : 0;
+            gCurrentObject = random_range(0, 1) ? &object : NULL;
+
+            listSurf = ref_find_floor_from_list(
+                gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next, x, y, z, &listHeight);
+            packedSurf = find_floor_from_packed(
+                get_static_packed_list(cellX, cellZ, SPATIAL_PARTITION_FLOORS, x, z), x, y, z, &packedHeight);
+            if (listSurf != packedSurf || memcmp(&listHeight, &packedHeight, sizeof(f32)) != 0) {
+                numFailed++;
+            }
+            numHits += listSurf != NULL;
+
+            listSurf = ref_find_ceil_from_list(
+                gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next, x, y, z, &listHeight);
+            packedSurf = find_ceil_from_packed(
+                get_static_packed_list(cellX, cellZ, SPATIAL_PARTITION_CEILS, x, z), x, y, z, &packedHeight);
+            if (listSurf != packedSurf || memcmp(&listHeight, &packedHeight, sizeof(f32)) != 0) {
+                numFailed++;
+            }
+            numHits += listSurf != NULL;
+
+            bzero(&listData, sizeof(listData));
+            listData.x = x + random_range(0, 999) / 1000.0f;
+            listData.y = y;
+            listData.z = z;
+            listData.offsetY = random_range(0, 150);
+            listData.radius = random_range(0, 260);
+            packedData = listData;
+            listCols = ref_find_wall_collisions_from_list(
+                gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next, &listData);
+            packedCols = find_wall_collisions_from_packed(
+                &gStaticPackedPartition[cellZ][cellX][SPATIAL_PARTITION_WALLS], &packedData);
+            if (listCols != packedCols || memcmp(&listData, &packedData, sizeof(listData)) != 0) {
+                numFailed++;
+            }
+            numHits += listCols != 0;
+        }
+    }
+
+    printf("%d lanes, %d areas, %d queries each, %d hits, %d mismatches\n", PACKED_LANES, numAreas,
+           3 * numQueries, numHits, numFailed);
+    return numFailed != 0;
+}
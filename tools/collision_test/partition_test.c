@@ -0,0 +1,99 @@
+/*
+ * Checks the static partition built in bulk by load_area_terrain against the partition that
+ * the original add_surface builds one surface at a time. Every cell's floor, ceiling and wall
+ * list must hold the same surfaces in the same order, and its packed list must match it.
+ * With a cache directory, each area is loaded a second time from the cached partition and
+ * checked again.
+ *
+ * usage: partition_test [seed] [areas] [cache directory]
+ */
+#include "engine/surface_load.c"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pc/configfile.h"
+#include "random_area.h"
+#include "reference.h"
+
+static SpatialPartitionCell sRefPartition[NUM_CELLS][NUM_CELLS];
+static s8 sSurfaceRooms[100000];
+
+/**
+ * Compare every list of the loaded static partition with the reference one. Returns the number
+ * of lists that differ.
+ */
+static s32 compare_partitions(s32 *numNodes) {
+    struct SurfaceNode *node, *refNode;
+    struct PackedSurfaceList *packed;
+    s32 cellX, cellZ, listIndex, i;
+    s32 numFailed = 0;
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                node = gStaticSurfacePartition[cellZ][cellX][listIndex].next;
+                refNode = sRefPartition[cellZ][cellX][listIndex].next;
+                packed = &gStaticPackedPartition[cellZ][cellX][listIndex];
+
+                for (i = 0; node != NULL && refNode != NULL; i++) {
+                    if (node->surface->object != NULL || !ref_surfaces_equal(node->surface, refNode->surface)
+                        || i >= packed->count || packed->surfaces[i] != node->surface) {
+                        break;
+                    }
+                    node = node->next;
+                    refNode = refNode->next;
+                }
+                *numNodes += i;
+
+                if (node != NULL || refNode != NULL || i != packed->count) {
+                    numFailed++;
+                }
+            }
+        }
+    }
+
+    return numFailed;
+}
+
+int main(int argc, char **argv) {
+    s32 numAreas = argc > 2 ? atoi(argv[2]) : 30;
+    s32 area, pass, i;
+    s32 numFailed = 0;
+    s32 numNodes;
+    s16 *terrain;
+    s8 *surfaceRooms;
+
+    gRandomSeed = argc > 1 ? (u32) atoi(argv[1]) : 1;
+    configCollisionCacheDir = argc > 3 ? argv[3] : "none";
+    alloc_surface_pools();
+
+    for (area = 0; area < numAreas; area++) {
+        terrain = build_random_area();
+        surfaceRooms = NULL;
+        if (area & 1) {
+            for (i = 0; i < (s32) ARRAY_COUNT(sSurfaceRooms); i++) {
+                sSurfaceRooms[i] = random_range(0, 5);
+            }
+            surfaceRooms = sSurfaceRooms;
+        }
+
+        ref_load_area_terrain(&sRefPartition[0][0], terrain, surfaceRooms);
+
+        for (pass = 0; pass < (collision_cache_enabled() ? 2 : 1); pass++) {
+            load_area_terrain(0, terrain, surfaceRooms, NULL);
+
+            numNodes = 0;
+            numFailed += compare_partitions(&numNodes);
+            if (numNodes != gNumStaticSurfaceNodes) {
+                numFailed++;
+            }
+        }
+    }
+
+    ref_clear_partition(&sRefPartition[0][0]);
+
+    printf("%d areas, %d mismatched lists\n", numAreas, numFailed);
+    return numFailed != 0;
+}
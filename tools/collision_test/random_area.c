@@ -0,0 +1,111 @@
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "surface_terrains.h"
+#include "engine/surface_load.h"
+#include "random_area.h"
+
+/*
+ * Random terrain for the tests, in the format of the levels' collision.inc.c files.
+ */
+
+u32 gRandomSeed = 1;
+
+static s16 sTerrain[400000];
+
+u32 random_u32(void) {
+    gRandomSeed ^= gRandomSeed << 13;
+    gRandomSeed ^= gRandomSeed >> 17;
+    gRandomSeed ^= gRandomSeed << 5;
+    return gRandomSeed;
+}
+
+s32 random_range(s32 lo, s32 hi) {
+    return lo + (s32)(random_u32() % (u32)(hi - lo + 1));
+}
+
+f32 random_f32(f32 lo, f32 hi) {
+    return lo + (hi - lo) * (random_u32() % 1000001) / 1000000.0f;
+}
+
+s32 clamp_coord(s32 coord) {
+    if (coord > LEVEL_BOUNDARY_MAX - 1) {
+        return LEVEL_BOUNDARY_MAX - 1;
+    }
+    if (coord < -LEVEL_BOUNDARY_MAX + 1) {
+        return -LEVEL_BOUNDARY_MAX + 1;
+    }
+    return coord;
+}
+
+/**
+ * Build the terrain of a random area: vertices along a random walk with some flat stretches,
+ * and a few groups of triangles between nearby vertices, with the surface types that change
+ * how the queries filter them.
+ */
+s16 *build_random_area(void) {
+    static const s16 types[] = {
+        SURFACE_DEFAULT, SURFACE_DEFAULT, SURFACE_FLOWING_WATER, SURFACE_NO_CAM_COLLISION,
+        SURFACE_CAMERA_BOUNDARY, SURFACE_VANISH_CAP_WALLS, SURFACE_INTANGIBLE,
+    };
+    s16 *data = sTerrain;
+    s32 numVertices = random_range(3, 8000);
+    s32 numGroups = random_range(1, 8);
+    s32 x = 0, z = 0;
+    s32 i, group;
+
+    *data++ = TERRAIN_LOAD_VERTICES;
+    *data++ = numVertices;
+    for (i = 0; i < numVertices; i++) {
+        if (random_range(0, 200) == 0) {
+            x = random_range(-LEVEL_BOUNDARY_MAX, LEVEL_BOUNDARY_MAX);
+            z = random_range(-LEVEL_BOUNDARY_MAX, LEVEL_BOUNDARY_MAX);
+        }
+        x = clamp_coord(x + random_range(-150, 150));
+        z = clamp_coord(z + random_range(-150, 150));
+        *data++ = x;
+        *data++ = random_range(0, 2) ? random_range(-3, 3) * 100 : random_range(-2000, 2000);
+        *data++ = z;
+    }
+
+    for (group = 0; group < numGroups; group++) {
+        s16 type = types[random_range(0, ARRAY_COUNT(types) - 1)];
+        s32 numSurfaces = random_range(1, 4000);
+        s32 span = random_range(0, 30) ? 12 : numVertices;
+
+        *data++ = type;
+        *data++ = numSurfaces;
+        for (i = 0; i < numSurfaces; i++) {
+            s32 base = random_range(0, numVertices - 1);
+
+            *data++ = base;
+            *data++ = (base + random_range(0, span)) % numVertices;
+            *data++ = (base + random_range(0, span)) % numVertices;
+            if (type == SURFACE_FLOWING_WATER) {
+                *data++ = random_range(0, 255);
+            }
+        }
+    }
+
+    *data++ = TERRAIN_LOAD_CONTINUE;
+    *data++ = TERRAIN_LOAD_END;
+    return sTerrain;
+}
+
+/**
+ * Pick a query point in the last area built, mostly close to one of its vertices so that the
+ * queries hit something.
+ */
+void random_point_in_area(s32 *x, s32 *y, s32 *z) {
+    s16 *vertex = &sTerrain[2 + 3 * random_range(0, sTerrain[1] - 1)];
+
+    if (random_range(0, 3) == 0) {
+        *x = random_range(-LEVEL_BOUNDARY_MAX + 1, LEVEL_BOUNDARY_MAX - 1);
+        *y = random_range(-3000, 3000);
+        *z = random_range(-LEVEL_BOUNDARY_MAX + 1, LEVEL_BOUNDARY_MAX - 1);
+    } else {
+        *x = clamp_coord(vertex[0] + random_range(-300, 300));
+        *y = vertex[1] + random_range(-300, 300);
+        *z = clamp_coord(vertex[2] + random_range(-300, 300));
+    }
+}
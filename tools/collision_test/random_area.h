@@ -0,0 +1,15 @@
+#ifndef RANDOM_AREA_H
+#define RANDOM_AREA_H
+
+#include <PR/ultratypes.h>
+
+extern u32 gRandomSeed;
+
+u32 random_u32(void);
+s32 random_range(s32 lo, s32 hi);
+f32 random_f32(f32 lo, f32 hi);
+s32 clamp_coord(s32 coord);
+s16 *build_random_area(void);
+void random_point_in_area(s32 *x, s32 *y, s32 *z);
+
+#endif // RANDOM_AREA_H
@@ -0,0 +1,765 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "behavior_data.h"
+#include "object_fields.h"
+#include "game/level_update.h"
+#include "game/mario.h"
+#include "game/memory.h"
+#include "game/object_helpers.h"
+#include "game/object_list_processor.h"
+#include "surface_terrains.h"
+#include "engine/surface_collision.h"
+#include "reference.h"
+
+/*
+ * The list walkers and partition building of the original surface_collision.c and
+ * surface_load.c, which the tests check the PC collision code against. The functions are
+ * unchanged apart from their names and the partition they work on.
+ */
+
+/**
+ * Iterate through the list of walls until all walls are checked and
+ * have given their wall push.
+ */
+s32 ref_find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
+                                       struct WallCollisionData *data) {
+    register struct Surface *surf;
+    register f32 offset;
+    register f32 radius = data->radius;
+    register f32 x = data->x;
+    register f32 y = data->y + data->offsetY;
+    register f32 z = data->z;
+    register f32 px, pz;
+    register f32 w1, w2, w3;
+    register f32 y1, y2, y3;
+    s32 numCols = 0;
+
+    // Max collision radius = 200
+    if (radius > 200.0f) {
+        radius = 200.0f;
+    }
+
+    // Stay in this loop until out of walls.
+    while (surfaceNode != NULL) {
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+
+        // Exclude a large number of walls immediately to optimize.
+        if (y < surf->lowerY || y > surf->upperY) {
+            continue;
+        }
+
+        offset = surf->normal.x * x + surf->normal.y * y + surf->normal.z * z + surf->originOffset;
+
+        if (offset < -radius || offset > radius) {
+            continue;
+        }
+
+        px = x;
+        pz = z;
+
+        //! (Quantum Tunneling) Due to issues with the vertices walls choose and
+        //  the fact they are floating point, certain floating point positions
+        //  along the seam of two walls may collide with neither wall or both walls.
+        if (surf->flags & SURFACE_FLAG_X_PROJECTION) {
+            w1 = -surf->vertex1[2];            w2 = -surf->vertex2[2];            w3 = -surf->vertex3[2];
+            y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+
+            if (surf->normal.x > 0.0f) {
+                if ((y1 - y) * (w2 - w1) - (w1 - -pz) * (y2 - y1) > 0.0f) {
+                    continue;
+                }
+                if ((y2 - y) * (w3 - w2) - (w2 - -pz) * (y3 - y2) > 0.0f) {
+                    continue;
+                }
+                if ((y3 - y) * (w1 - w3) - (w3 - -pz) * (y1 - y3) > 0.0f) {
+                    continue;
+                }
+            } else {
+                if ((y1 - y) * (w2 - w1) - (w1 - -pz) * (y2 - y1) < 0.0f) {
+                    continue;
+                }
+                if ((y2 - y) * (w3 - w2) - (w2 - -pz) * (y3 - y2) < 0.0f) {
+                    continue;
+                }
+                if ((y3 - y) * (w1 - w3) - (w3 - -pz) * (y1 - y3) < 0.0f) {
+                    continue;
+                }
+            }
+        } else {
+            w1 = surf->vertex1[0];            w2 = surf->vertex2[0];            w3 = surf->vertex3[0];
+            y1 = surf->vertex1[1];            y2 = surf->vertex2[1];            y3 = surf->vertex3[1];
+
+            if (surf->normal.z > 0.0f) {
+                if ((y1 - y) * (w2 - w1) - (w1 - px) * (y2 - y1) > 0.0f) {
+                    continue;
+                }
+                if ((y2 - y) * (w3 - w2) - (w2 - px) * (y3 - y2) > 0.0f) {
+                    continue;
+                }
+                if ((y3 - y) * (w1 - w3) - (w3 - px) * (y1 - y3) > 0.0f) {
+                    continue;
+                }
+            } else {
+                if ((y1 - y) * (w2 - w1) - (w1 - px) * (y2 - y1) < 0.0f) {
+                    continue;
+                }
+                if ((y2 - y) * (w3 - w2) - (w2 - px) * (y3 - y2) < 0.0f) {
+                    continue;
+                }
+                if ((y3 - y) * (w1 - w3) - (w3 - px) * (y1 - y3) < 0.0f) {
+                    continue;
+                }
+            }
+        }
+
+        // Determine if checking for the camera or not.
+        if (gCheckingSurfaceCollisionsForCamera) {
+            if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+                continue;
+            }
+        } else {
+            // Ignore camera only surfaces.
+            if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+                continue;
+            }
+
+            // If an object can pass through a vanish cap wall, pass through.
+            if (surf->type == SURFACE_VANISH_CAP_WALLS) {
+                // If an object can pass through a vanish cap wall, pass through.
+                if (gCurrentObject != NULL
+                    && (gCurrentObject->activeFlags & ACTIVE_FLAG_MOVE_THROUGH_GRATE)) {
+                    continue;
+                }
+
+                // If Mario has a vanish cap, pass through the vanish cap wall.
+                if (gCurrentObject != NULL && gCurrentObject == gMarioObject
+                    && (gMarioState->flags & MARIO_VANISH_CAP)) {
+                    continue;
+                }
+            }
+        }
+
+        //! (Wall Overlaps) Because this doesn't update the x and z local variables,
+        //  multiple walls can push mario more than is required.
+        data->x += surf->normal.x * (radius - offset);
+        data->z += surf->normal.z * (radius - offset);
+
+        //! (Unreferenced Walls) Since this only returns the first four walls,
+        //  this can lead to wall interaction being missed. Typically unreferenced walls
+        //  come from only using one wall, however.
+        if (data->numWalls < 4) {
+            data->walls[data->numWalls++] = surf;
+        }
+
+        numCols++;
+    }
+
+    return numCols;
+}
+
+/**
+ * Iterate through the list of ceilings and find the first ceiling over a given point.
+ */
+struct Surface *ref_find_ceil_from_list(struct SurfaceNode *surfaceNode, s32 x, s32 y, s32 z, f32 *pheight) {
+    register struct Surface *surf;
+    register s32 x1, z1, x2, z2, x3, z3;
+    f32 nx, ny, nz, oo, height;
+    struct Surface *ceil = NULL;
+    *pheight = CELL_HEIGHT_LIMIT;
+    // Stay in this loop until out of ceilings.
+    while (surfaceNode != NULL) {
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+        x1 = surf->vertex1[0];
+        z1 = surf->vertex1[2];
+        z2 = surf->vertex2[2];
+        x2 = surf->vertex2[0];
+        // Checking if point is in bounds of the triangle laterally.
+        if ((z1 - z) * (x2 - x1) - (x1 - x) * (z2 - z1) > 0) {
+            continue;
+        }
+        // Slight optimization by checking these later.
+        x3 = surf->vertex3[0];
+        z3 = surf->vertex3[2];
+        if ((z2 - z) * (x3 - x2) - (x2 - x) * (z3 - z2) > 0) {
+            continue;
+        }
+        if ((z3 - z) * (x1 - x3) - (x3 - x) * (z1 - z3) > 0) {
+            continue;
+        }
+        // Determine if checking for the camera or not.
+        if (gCheckingSurfaceCollisionsForCamera != 0) {
+            if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+                continue;
+            }
+        }
+        // Ignore camera only surfaces.
+        else if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+            continue;
+        }
+		nx = surf->normal.x;
+		ny = surf->normal.y;
+		nz = surf->normal.z;
+		oo = surf->originOffset;
+		// If a wall, ignore it. Likely a remnant, should never occur.
+		if (ny == 0.0f) {
+			continue;
+		}
+		// Find the ceil height at the specific point.
+		height = -(x * nx + nz * z + oo) / ny;
+		if (height > *pheight) {
+			continue;
+		}
+		// Checks for ceiling interaction
+		if (y > height) {
+			continue;
+		}
+		if (y >= surf->upperY) {
+			continue;
+		}
+		*pheight = height;
+		ceil = surf;
+		if (height == y) {
+			break;
+		}
+    }
+    return ceil;
+}
+
+/**
+ * Iterate through the list of floors and find the first floor under a given point.
+ */
+struct Surface *ref_find_floor_from_list(struct SurfaceNode *surfaceNode, s32 x, s32 y, s32 z, f32 *pheight) {
+    register struct Surface *surf;
+    register s32 x1, z1, x2, z2, x3, z3;
+    f32 nx, ny, nz, oo, height;
+    struct Surface *floor = NULL;
+    *pheight = FLOOR_LOWER_LIMIT;
+    // Iterate through the list of floors until there are no more floors.
+    while (surfaceNode != NULL) {
+        surf = surfaceNode->surface;
+        surfaceNode = surfaceNode->next;
+        x1 = surf->vertex1[0];
+        z1 = surf->vertex1[2];
+        x2 = surf->vertex2[0];
+        z2 = surf->vertex2[2];
+        // Check that the point is within the triangle bounds.
+        if ((z1 - z) * (x2 - x1) - (x1 - x) * (z2 - z1) < 0) {
+            continue;
+        }
+        // To slightly save on computation time, set this later.
+        x3 = surf->vertex3[0];
+        z3 = surf->vertex3[2];
+        if ((z2 - z) * (x3 - x2) - (x2 - x) * (z3 - z2) < 0) {
+            continue;
+        }
+        if ((z3 - z) * (x1 - x3) - (x3 - x) * (z1 - z3) < 0) {
+            continue;
+        }
+        // Determine if we are checking for the camera or not.
+        if (gCheckingSurfaceCollisionsForCamera != 0) {
+            if (surf->flags & SURFACE_FLAG_NO_CAM_COLLISION) {
+                continue;
+            }
+        }
+        // If we are not checking for the camera, ignore camera only floors.
+        else if (surf->type == SURFACE_CAMERA_BOUNDARY) {
+            continue;
+        }
+        nx = surf->normal.x;
+        ny = surf->normal.y;
+        nz = surf->normal.z;
+        oo = surf->originOffset;
+		// If a wall, ignore it. Likely a remnant, should never occur.
+		if (ny == 0.0f) {
+			continue;
+		}
+        // Find the height of the floor at a given location.
+        height = -(x * nx + nz * z + oo) / ny;
+        if (height < *pheight) {
+            continue;
+        }
+        // Checks for floor interaction with a 78 unit buffer.
+        if (y < (height - 78.0f)) {
+            continue;
+        }
+        *pheight = height;
+        floor = surf;
+        if (height - 78.0f == y) {
+            break;
+        }
+    }
+    return floor;
+}
+/**
+ * Returns the lowest of three values.
+ */
+static s16 min_3(s16 a0, s16 a1, s16 a2) {
+    if (a1 < a0) {
+        a0 = a1;
+    }
+
+    if (a2 < a0) {
+        a0 = a2;
+    }
+
+    return a0;
+}
+
+/**
+ * Returns the highest of three values.
+ */
+static s16 max_3(s16 a0, s16 a1, s16 a2) {
+    if (a1 > a0) {
+        a0 = a1;
+    }
+
+    if (a2 > a0) {
+        a0 = a2;
+    }
+
+    return a0;
+}
+
+/**
+ * Every level is split into 16 * 16 cells of surfaces (to limit computing
+ * time). This function determines the lower cell for a given x/z position.
+ * @param coord The coordinate to test
+ */
+static s16 lower_cell_index(s32 coord) {
+    s16 index;
+
+    // Move from range [-0x2000, 0x2000) to [0, 0x4000)
+    coord += LEVEL_BOUNDARY_MAX;
+    if (coord < 0) {
+        coord = 0;
+    }
+
+    // [0, 16)
+    index = coord / CELL_SIZE;
+
+    // Include extra cell if close to boundary
+    //! Some wall checks are larger than the buffer, meaning wall checks can
+    //  miss walls that are near a cell border.
+    if (coord % CELL_SIZE < 50) {
+        index -= 1;
+    }
+
+    if (index < 0) {
+        index = 0;
+    }
+
+    // Potentially > 15, but since the upper index is <= 15, not exploitable
+    return index;
+}
+
+/**
+ * Every level is split into 16 * 16 cells of surfaces (to limit computing
+ * time). This function determines the upper cell for a given x/z position.
+ * @param coord The coordinate to test
+ */
+static s16 upper_cell_index(s32 coord) {
+    s16 index;
+
+    // Move from range [-0x2000, 0x2000) to [0, 0x4000)
+    coord += LEVEL_BOUNDARY_MAX;
+    if (coord < 0) {
+        coord = 0;
+    }
+
+    // [0, 16)
+    index = coord / CELL_SIZE;
+
+    // Include extra cell if close to boundary
+    //! Some wall checks are larger than the buffer, meaning wall checks can
+    //  miss walls that are near a cell border.
+    if (coord % CELL_SIZE > CELL_SIZE - 50) {
+        index += 1;
+    }
+
+    if (index > NUM_CELLS_INDEX) {
+        index = NUM_CELLS_INDEX;
+    }
+
+    // Potentially < 0, but since lower index is >= 0, not exploitable
+    return index;
+}
+
+/**
+ * Returns whether a surface has exertion/moves Mario
+ * based on the surface type.
+ */
+static s32 surface_has_force(s16 surfaceType) {
+    s32 hasForce = FALSE;
+
+    switch (surfaceType) {
+        case SURFACE_0004: // Unused
+        case SURFACE_FLOWING_WATER:
+        case SURFACE_DEEP_MOVING_QUICKSAND:
+        case SURFACE_SHALLOW_MOVING_QUICKSAND:
+        case SURFACE_MOVING_QUICKSAND:
+        case SURFACE_HORIZONTAL_WIND:
+        case SURFACE_INSTANT_MOVING_QUICKSAND:
+            hasForce = TRUE;
+            break;
+
+        default:
+            break;
+    }
+    return hasForce;
+}
+
+/**
+ * Returns whether a surface should have the
+ * SURFACE_FLAG_NO_CAM_COLLISION flag.
+ */
+static s32 surf_has_no_cam_collision(s16 surfaceType) {
+    s32 flags = 0;
+
+    switch (surfaceType) {
+        case SURFACE_NO_CAM_COLLISION:
+        case SURFACE_NO_CAM_COLLISION_77: // Unused
+        case SURFACE_NO_CAM_COL_VERY_SLIPPERY:
+        case SURFACE_SWITCH:
+            flags = SURFACE_FLAG_NO_CAM_COLLISION;
+            break;
+
+        default:
+            break;
+    }
+
+    return flags;
+}
+
+static void **sRefBlocks;
+static s32 sNumRefBlocks;
+
+s32 gRefNumSurfaces;
+s32 gRefNumNodes;
+
+static void *ref_alloc(size_t size) {
+    sRefBlocks = realloc(sRefBlocks, sizeof(void *) * (sNumRefBlocks + 1));
+    return sRefBlocks[sNumRefBlocks++] = calloc(1, size);
+}
+
+/**
+ * Free the surfaces and nodes that the reference functions allocated, and empty the partition
+ * they were added to.
+ */
+void ref_clear_partition(SpatialPartitionCell *cells) {
+    s32 i;
+
+    for (i = 0; i < sNumRefBlocks; i++) {
+        free(sRefBlocks[i]);
+    }
+    sNumRefBlocks = 0;
+    gRefNumSurfaces = 0;
+    gRefNumNodes = 0;
+    memset(cells, 0, sizeof(SpatialPartitionCell) * NUM_CELLS * NUM_CELLS);
+}
+
+/**
+ * The original read_surface_data, filling in the given surface instead of allocating one.
+ * Returns FALSE for a degenerate triangle.
+ */
+s32 ref_read_surface_data(struct Surface *surface, s16 *vertexData, s16 *vertexIndices) {
+    register s32 x1, y1, z1;
+    register s32 x2, y2, z2;
+    register s32 x3, y3, z3;
+    s32 maxY, minY;
+    f32 nx, ny, nz;
+    f32 mag;
+    s16 offset1, offset2, offset3;
+
+    offset1 = 3 * vertexIndices[0];
+    offset2 = 3 * vertexIndices[1];
+    offset3 = 3 * vertexIndices[2];
+
+    x1 = *(vertexData + offset1 + 0);
+    y1 = *(vertexData + offset1 + 1);
+    z1 = *(vertexData + offset1 + 2);
+
+    x2 = *(vertexData + offset2 + 0);
+    y2 = *(vertexData + offset2 + 1);
+    z2 = *(vertexData + offset2 + 2);
+
+    x3 = *(vertexData + offset3 + 0);
+    y3 = *(vertexData + offset3 + 1);
+    z3 = *(vertexData + offset3 + 2);
+
+    // (v2 - v1) x (v3 - v2)
+    nx = (y2 - y1) * (z3 - z2) - (z2 - z1) * (y3 - y2);
+    ny = (z2 - z1) * (x3 - x2) - (x2 - x1) * (z3 - z2);
+    nz = (x2 - x1) * (y3 - y2) - (y2 - y1) * (x3 - x2);
+    mag = sqrtf(nx * nx + ny * ny + nz * nz);
+
+    // Could have used min_3 and max_3 for this...
+    minY = y1;
+    if (y2 < minY) {
+        minY = y2;
+    }
+    if (y3 < minY) {
+        minY = y3;
+    }
+
+    maxY = y1;
+    if (y2 > maxY) {
+        maxY = y2;
+    }
+    if (y3 > maxY) {
+        maxY = y3;
+    }
+
+    // Checking to make sure no DIV/0
+    if (mag < 0.0001) {
+        return FALSE;
+    }
+    mag = (f32)(1.0 / mag);
+    nx *= mag;
+    ny *= mag;
+    nz *= mag;
+
+    surface->vertex1[0] = x1;
+    surface->vertex2[0] = x2;
+    surface->vertex3[0] = x3;
+
+    surface->vertex1[1] = y1;
+    surface->vertex2[1] = y2;
+    surface->vertex3[1] = y3;
+
+    surface->vertex1[2] = z1;
+    surface->vertex2[2] = z2;
+    surface->vertex3[2] = z3;
+
+    surface->normal.x = nx;
+    surface->normal.y = ny;
+    surface->normal.z = nz;
+
+    surface->originOffset = -(nx * x1 + ny * y1 + nz * z1);
+
+    surface->lowerY = minY - 5;
+    surface->upperY = maxY + 5;
+
+    return TRUE;
+}
+
+/**
+ * The original add_surface_to_cell, on the given partition.
+ */
+static void ref_add_surface_to_cell(SpatialPartitionCell *cells, s16 cellX, s16 cellZ, struct Surface *surface) {
+    struct SurfaceNode *newNode = ref_alloc(sizeof(struct SurfaceNode));
+    struct SurfaceNode *list;
+    s16 surfacePriority;
+    s16 priority;
+    s16 sortDir;
+    s16 listIndex;
+
+    if (surface->normal.y > 0.01) {
+        listIndex = SPATIAL_PARTITION_FLOORS;
+        sortDir = 1; // highest to lowest, then insertion order
+    } else if (surface->normal.y < -0.01) {
+        listIndex = SPATIAL_PARTITION_CEILS;
+        sortDir = -1; // lowest to highest, then insertion order
+    } else {
+        listIndex = SPATIAL_PARTITION_WALLS;
+        sortDir = 0; // insertion order
+
+        if (surface->normal.x < -0.707 || surface->normal.x > 0.707) {
+            surface->flags |= SURFACE_FLAG_X_PROJECTION;
+        }
+    }
+
+    surfacePriority = surface->vertex1[1] * sortDir;
+
+    newNode->surface = surface;
+    gRefNumNodes++;
+    list = &cells[cellZ * NUM_CELLS + cellX][listIndex];
+
+    // Loop until we find the appropriate place for the surface in the list.
+    while (list->next != NULL) {
+        priority = list->next->surface->vertex1[1] * sortDir;
+
+        if (surfacePriority > priority) {
+            break;
+        }
+
+        list = list->next;
+    }
+
+    newNode->next = list->next;
+    list->next = newNode;
+}
+
+/**
+ * The original add_surface: add a copy of the surface to every cell it may touch.
+ */
+void ref_add_surface(SpatialPartitionCell *cells, struct Surface *surface) {
+    struct Surface *copy = ref_alloc(sizeof(struct Surface));
+    s16 minX, minZ, maxX, maxZ;
+    s16 minCellX, minCellZ, maxCellX, maxCellZ;
+    s16 cellZ, cellX;
+
+    *copy = *surface;
+    gRefNumSurfaces++;
+
+    minX = min_3(copy->vertex1[0], copy->vertex2[0], copy->vertex3[0]);
+    minZ = min_3(copy->vertex1[2], copy->vertex2[2], copy->vertex3[2]);
+    maxX = max_3(copy->vertex1[0], copy->vertex2[0], copy->vertex3[0]);
+    maxZ = max_3(copy->vertex1[2], copy->vertex2[2], copy->vertex3[2]);
+
+    minCellX = lower_cell_index(minX);
+    maxCellX = upper_cell_index(maxX);
+    minCellZ = lower_cell_index(minZ);
+    maxCellZ = upper_cell_index(maxZ);
+
+    for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
+        for (cellX = minCellX; cellX <= maxCellX; cellX++) {
+            ref_add_surface_to_cell(cells, cellX, cellZ, copy);
+        }
+    }
+}
+
+/**
+ * The surface loading part of the original load_area_terrain, into the given partition.
+ * Special objects are not supported.
+ */
+void ref_load_area_terrain(SpatialPartitionCell *cells, s16 *data, s8 *surfaceRooms) {
+    struct Surface surface;
+    s16 *vertexData = NULL;
+    s16 terrainLoadType;
+    s32 numSurfaces;
+    s16 hasForce;
+    s8 room = 0;
+    s32 i;
+
+    ref_clear_partition(cells);
+
+    while (TRUE) {
+        terrainLoadType = *data++;
+
+        if (TERRAIN_LOAD_IS_SURFACE_TYPE_LOW(terrainLoadType)
+            || TERRAIN_LOAD_IS_SURFACE_TYPE_HIGH(terrainLoadType)) {
+            hasForce = surface_has_force(terrainLoadType);
+            numSurfaces = *data++;
+
+            for (i = 0; i < numSurfaces; i++) {
+                if (surfaceRooms != NULL) {
+                    room = *surfaceRooms++;
+                }
+
+                bzero(&surface, sizeof(surface));
+                if (ref_read_surface_data(&surface, vertexData, data)) {
+                    surface.room = room;
+                    surface.type = terrainLoadType;
+                    surface.flags = (s8) surf_has_no_cam_collision(terrainLoadType);
+                    surface.force = hasForce ? data[3] : 0;
+                    ref_add_surface(cells, &surface);
+                }
+
+                data += hasForce ? 4 : 3;
+            }
+        } else if (terrainLoadType == TERRAIN_LOAD_VERTICES) {
+            vertexData = data + 1;
+            data += 1 + 3 * data[0];
+        } else if (terrainLoadType == TERRAIN_LOAD_ENVIRONMENT) {
+            data += 1 + 6 * data[0];
+        } else if (terrainLoadType == TERRAIN_LOAD_CONTINUE) {
+            continue;
+        } else {
+            break;
+        }
+    }
+}
+
+/**
+ * Whether two surfaces have the same contents, apart from the object they belong to.
+ */
+s32 ref_surfaces_equal(struct Surface *a, struct Surface *b) {
+    return a->type == b->type && a->force == b->force && a->flags == b->flags && a->room == b->room
+           && a->lowerY == b->lowerY && a->upperY == b->upperY
+           && memcmp(a->vertex1, b->vertex1, sizeof(Vec3s)) == 0
+           && memcmp(a->vertex2, b->vertex2, sizeof(Vec3s)) == 0
+           && memcmp(a->vertex3, b->vertex3, sizeof(Vec3s)) == 0
+           && memcmp(&a->normal, &b->normal, sizeof(a->normal)) == 0
+           && memcmp(&a->originOffset, &b->originOffset, sizeof(f32)) == 0;
+}
+
+/**
+ * The original load_object_collision_model for an object whose collision is loaded, without
+ * the distance and room checks, into the given partition.
+ */
+void ref_load_object_collision(SpatialPartitionCell *cells, struct Object *obj) {
+    s16 vertexData[600];
+    struct Surface surface;
+    s16 *data = (s16 *) obj->collisionData + 1;
+    Mat4 *objectTransform = &obj->transform;
+    s16 *vertices;
+    f32 vx, vy, vz;
+    s32 numVertices;
+    s32 numSurfaces;
+    s16 surfaceType;
+    s16 hasForce;
+    s16 flags;
+    s16 room;
+    s16 *out;
+    Mat4 m;
+    s32 i;
+
+    numVertices = *data++;
+    vertices = data;
+
+    if (obj->header.gfx.throwMatrix == NULL) {
+        obj->header.gfx.throwMatrix = objectTransform;
+        obj_build_transform_from_pos_and_angle(obj, O_POS_INDEX, O_FACE_ANGLE_INDEX);
+    }
+
+    obj_apply_scale_to_matrix(obj, m, *objectTransform);
+
+    out = vertexData;
+    while (numVertices--) {
+        vx = *(vertices++);
+        vy = *(vertices++);
+        vz = *(vertices++);
+
+        *out++ = (s16)(vx * m[0][0] + vy * m[1][0] + vz * m[2][0] + m[3][0]);
+        *out++ = (s16)(vx * m[0][1] + vy * m[1][1] + vz * m[2][1] + m[3][1]);
+        *out++ = (s16)(vx * m[0][2] + vy * m[1][2] + vz * m[2][2] + m[3][2]);
+    }
+    data = vertices;
+
+    // The DDD warp is initially loaded at the origin and moved to the proper
+    // position in paintings.c and doesn't update its room, so set it here.
+    if (obj->behavior == segmented_to_virtual(bhvDddWarp)) {
+        room = 5;
+    } else {
+        room = 0;
+    }
+
+    // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
+    while (*data != TERRAIN_LOAD_CONTINUE) {
+        surfaceType = *data++;
+        numSurfaces = *data++;
+        hasForce = surface_has_force(surfaceType);
+        flags = surf_has_no_cam_collision(surfaceType) | SURFACE_FLAG_DYNAMIC;
+
+        for (i = 0; i < numSurfaces; i++) {
+            bzero(&surface, sizeof(surface));
+            if (ref_read_surface_data(&surface, vertexData, data)) {
+                surface.object = obj;
+                surface.type = surfaceType;
+                surface.force = hasForce ? data[3] : 0;
+                surface.flags |= flags;
+                surface.room = (s8) room;
+                ref_add_surface(cells, &surface);
+            }
+
+            data += hasForce ? 4 : 3;
+        }
+    }
+}
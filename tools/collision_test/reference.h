@@ -0,0 +1,25 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <PR/ultratypes.h>
+
+#include "types.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+
+s32 ref_find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
+                                       struct WallCollisionData *data);
+struct Surface *ref_find_ceil_from_list(struct SurfaceNode *surfaceNode, s32 x, s32 y, s32 z, f32 *pheight);
+struct Surface *ref_find_floor_from_list(struct SurfaceNode *surfaceNode, s32 x, s32 y, s32 z, f32 *pheight);
+
+extern s32 gRefNumSurfaces;
+extern s32 gRefNumNodes;
+
+void ref_clear_partition(SpatialPartitionCell *cells);
+s32 ref_read_surface_data(struct Surface *surface, s16 *vertexData, s16 *vertexIndices);
+void ref_add_surface(SpatialPartitionCell *cells, struct Surface *surface);
+void ref_load_area_terrain(SpatialPartitionCell *cells, s16 *data, s8 *surfaceRooms);
+s32 ref_surfaces_equal(struct Surface *a, struct Surface *b);
+void ref_load_object_collision(SpatialPartitionCell *cells, struct Object *obj);
+
+#endif // REFERENCE_H
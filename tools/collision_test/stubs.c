@@ -0,0 +1,113 @@
+#include <stdlib.h>
+
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "behavior_data.h"
+#include "game/level_update.h"
+#include "game/memory.h"
+#include "game/object_list_processor.h"
+
+/*
+ * The parts of the game that the collision code reaches, reduced to what the tests need.
+ * Alloc-only pools hand out separate blocks so that a use after clearing shows up under
+ * the address sanitizer.
+ */
+
+struct AllocOnlyPool {
+    void **blocks;
+    s32 numBlocks;
+};
+
+const BehaviorScript bhvDddWarp[1];
+
+s16 gCCMEnteredSlide;
+s16 gCheckingSurfaceCollisionsForCamera;
+struct Object *gCurrentObject;
+s32 gEnvironmentLevels[20];
+s16 *gEnvironmentRegions;
+s16 gFindFloorIncludeSurfaceIntangible;
+struct Object *gMarioObject;
+struct MarioState *gMarioState;
+struct NumTimesCalled gNumCalls;
+s32 gNumFindFloorMisses;
+s32 gNumStaticSurfaceNodes;
+s32 gNumStaticSurfaces;
+s32 gSurfaceNodesAllocated;
+s32 gSurfacesAllocated;
+u32 gTimeStopState;
+
+const char *configCollisionCacheDir = "none";
+
+struct AllocOnlyPool *alloc_only_pool_init(void) {
+    return calloc(1, sizeof(struct AllocOnlyPool));
+}
+
+void *alloc_only_pool_alloc(struct AllocOnlyPool *pool, s32 size) {
+    pool->blocks = realloc(pool->blocks, sizeof(void *) * (pool->numBlocks + 1));
+    return pool->blocks[pool->numBlocks++] = malloc(size);
+}
+
+void alloc_only_pool_clear(struct AllocOnlyPool *pool) {
+    s32 i;
+
+    for (i = 0; i < pool->numBlocks; i++) {
+        free(pool->blocks[i]);
+    }
+    pool->numBlocks = 0;
+}
+
+void *segmented_to_virtual(const void *addr) {
+    return (void *) addr;
+}
+
+void *vec3s_copy(Vec3s dest, Vec3s src) {
+    dest[0] = src[0];
+    dest[1] = src[1];
+    dest[2] = src[2];
+    return dest;
+}
+
+void obj_apply_scale_to_matrix(struct Object *obj, Mat4 dst, Mat4 src) {
+    s32 i;
+
+    for (i = 0; i < 3; i++) {
+        dst[0][i] = src[0][i] * obj->header.gfx.scale[0];
+        dst[1][i] = src[1][i] * obj->header.gfx.scale[1];
+        dst[2][i] = src[2][i] * obj->header.gfx.scale[2];
+        dst[3][i] = src[3][i];
+    }
+    for (i = 0; i < 4; i++) {
+        dst[i][3] = src[i][3];
+    }
+}
+
+f32 dist_between_objects(UNUSED struct Object *obj1, UNUSED struct Object *obj2) {
+    return 0.0f;
+}
+
+u32 get_special_objects_size(UNUSED s16 *specialObjList) {
+    return 0;
+}
+
+void obj_build_transform_from_pos_and_angle(UNUSED struct Object *obj, UNUSED s16 posIndex,
+                                            UNUSED s16 angleIndex) {
+}
+
+void print_debug_top_down_mapinfo(UNUSED const char *str, UNUSED s32 number) {
+}
+
+void reset_red_coins_collected(void) {
+}
+
+void set_text_array_x_y(UNUSED s32 xOffset, UNUSED s32 yOffset) {
+}
+
+void spawn_macro_objects(UNUSED s16 areaIndex, UNUSED s16 *macroObjList) {
+}
+
+void spawn_macro_objects_hardcoded(UNUSED s16 areaIndex, UNUSED s16 *macroObjList) {
+}
+
+void spawn_special_objects(UNUSED s16 areaIndex, UNUSED s16 **specialObjList) {
+}
@@ -0,0 +1,122 @@
+/*
+ * Checks that the packed wall search, which rejects walls by their padded xz bounds before the
+ * exact test, finds the same walls as the original list walker over the terrain of every area
+ * in the game. The query points are spread around random walls, mostly just inside and
+ * outside the padded bounds, with the radii the game uses and random ones.
+ *
+ * usage: wall_mask_test [seed] [queries per area]
+ */
+#include "engine/surface_load.c"
+#include "engine/surface_collision.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "level_collision.h"
+#include "random_area.h"
+#include "reference.h"
+
+#define MAX_WALLS 20000
+
+static s16 sTerrain[200000];
+static struct Surface *sWalls[MAX_WALLS];
+
+int main(int argc, char **argv) {
+    static const f32 radii[] = { 0.0f, 1.0f, 5.0f, 10.0f, 25.0f, 37.5f, 50.0f, 60.0f, 100.0f, 150.0f, 200.0f, 250.0f };
+    s32 numQueries = argc > 2 ? atoi(argv[2]) : 200000;
+    s32 numFailed = 0;
+    s32 numHits = 0;
+    s32 level, numWalls, i, k;
+    s16 cellX, cellZ;
+
+    gRandomSeed = argc > 1 ? (u32) atoi(argv[1]) : 1;
+    alloc_surface_pools();
+
+    for (level = 0; gLevelCollision[level].name != NULL; level++) {
+        load_area_terrain(0, copy_level_surfaces(gLevelCollision[level].terrain, sTerrain), NULL, NULL);
+
+        numWalls = 0;
+        for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+            for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+                struct SurfaceNode *node = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next;
+
+                for (; node != NULL && numWalls < MAX_WALLS; node = node->next) {
+                    sWalls[numWalls++] = node->surface;
+                }
+            }
+        }
+        if (numWalls == 0) {
+            continue;
+        }
+
+        for (i = 0; i < numQueries; i++) {
+            struct Surface *wall = sWalls[random_u32() % numWalls];
+            struct WallCollisionData packed, list;
+            f32 radius = random_range(0, 3) ? radii[random_u32() % ARRAY_COUNT(radii)] : random_f32(0.0f, 260.0f);
+            f32 span = 1.5f * MIN(radius, 200.0f) + 3.0f;
+            f32 minX = MIN(MIN(wall->vertex1[0], wall->vertex2[0]), wall->vertex3[0]) - span;
+            f32 maxX = MAX(MAX(wall->vertex1[0], wall->vertex2[0]), wall->vertex3[0]) + span;
+            f32 minZ = MIN(MIN(wall->vertex1[2], wall->vertex2[2]), wall->vertex3[2]) - span;
+            f32 maxZ = MAX(MAX(wall->vertex1[2], wall->vertex2[2]), wall->vertex3[2]) + span;
+            s32 packedCols, listCols;
+            s16 x, z;
+
+            bzero(&packed, sizeof(packed));
+            switch (random_range(0, 2)) {
+                case 0:
+                    packed.x = random_f32(minX, maxX);
+                    packed.z = random_f32(minZ, maxZ);
+                    break;
+                case 1:
+                    packed.x = random_range(0, 1) ? minX + random_f32(0.0f, span) : maxX - random_f32(0.0f, span);
+                    packed.z = random_f32(minZ, maxZ);
+                    break;
+                default:
+                    packed.x = random_f32(minX, maxX);
+                    packed.z = random_range(0, 1) ? minZ + random_f32(0.0f, span) : maxZ - random_f32(0.0f, span);
+                    break;
+            }
+            if (random_range(0, 7) == 0) {
+                packed.x = (s32) packed.x;
+                packed.z = (s32) packed.z;
+            }
+            packed.offsetY = random_range(0, 1) ? 0.0f : random_f32(0.0f, 150.0f);
+            packed.y = random_f32(wall->lowerY - 200, wall->upperY + 50);
+            packed.radius = radius;
+            list = packed;
+
+            gCheckingSurfaceCollisionsForCamera = random_range(0, 3) == 0;
+            packedCols = find_wall_collisions(&packed);
+
+            listCols = 0;
+            x = list.x;
+            z = list.z;
+            if (x > -LEVEL_BOUNDARY_MAX && x < LEVEL_BOUNDARY_MAX && z > -LEVEL_BOUNDARY_MAX
+                && z < LEVEL_BOUNDARY_MAX) {
+                cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+                cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+                listCols = ref_find_wall_collisions_from_list(
+                    gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next, &list);
+            }
+
+            numHits += packedCols != 0;
+            if (packedCols != listCols || packed.x != list.x || packed.z != list.z
+                || packed.numWalls != list.numWalls) {
+                if (numFailed++ < 10) {
+                    printf("%s: radius %g, %d walls instead of %d\n", gLevelCollision[level].name, radius,
+                           packedCols, listCols);
+                }
+                continue;
+            }
+            for (k = 0; k < packed.numWalls; k++) {
+                if (packed.walls[k] != list.walls[k]) {
+                    numFailed++;
+                    break;
+                }
+            }
+        }
+    }
+
+    printf("%d areas, %d queries each, %d colliding, %d mismatches\n", level, numQueries, numHits, numFailed);
+    return numFailed != 0;
+}
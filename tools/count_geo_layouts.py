@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# Counts the graph nodes that entering each level builds from geo layouts, with and without
+# MODEL_GRAPH_CACHE. The models a level loads are the LOAD_MODEL_FROM_GEO commands of its script
+# and of the script_func_global groups it jumps to. With the cache, a (model, geo layout) pair is
+# only parsed the first time it is loaded, after the boot script's models, and the levels are
+# entered in the order given. Area geo layouts are parsed on every entry either way.
+#
+# usage: tools/count_geo_layouts.py [level]...    e.g. tools/count_geo_layouts.py bob wf castle_inside
+#        (all levels in alphabetical order by default)
+import glob
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+# Commands that don't build a graph node
+NON_NODE_COMMANDS = {
+    "GEO_END", "GEO_RETURN", "GEO_OPEN_NODE", "GEO_CLOSE_NODE", "GEO_BRANCH", "GEO_BRANCH_AND_LINK",
+    "GEO_NOP_1A", "GEO_NOP_1E", "GEO_NOP_1F", "GEO_ASSIGN_AS_VIEW", "GEO_UPDATE_NODE_FLAGS",
+    "GEO_SET_RENDER_RANGE",
+}
+
+
+def read(path):
+    with open(os.path.join(ROOT, path), errors="ignore") as f:
+        return f.read()
+
+
+def geo_layouts():
+    """The nodes each geo layout builds itself, and the layouts it branches to."""
+    layouts = {}
+    for pattern in ("actors/**/*.c", "levels/**/*.c", "bin/**/*.c"):
+        for path in glob.glob(os.path.join(ROOT, pattern), recursive=True):
+            for m in re.finditer(r"const GeoLayout (\w+)\[\]\s*=\s*\{(.*?)\n\};", read(path), re.S):
+                commands = re.findall(r"\b(GEO_\w+)\(([^()]*(?:\([^()]*\)[^()]*)*)\)", m.group(2))
+                nodes = sum(1 for name, _ in commands if name not in NON_NODE_COMMANDS)
+                branches = [args.split(",")[-1].strip() for name, args in commands
+                            if name in ("GEO_BRANCH", "GEO_BRANCH_AND_LINK")]
+                layouts[m.group(1)] = (nodes, branches)
+    return layouts
+
+
+LAYOUTS = geo_layouts()
+
+
+def layout_nodes(name):
+    """The nodes process_geo_layout builds for a layout, including the layouts it branches to."""
+    if name not in LAYOUTS:
+        return 0
+    nodes, branches = LAYOUTS[name]
+    return nodes + sum(layout_nodes(branch) for branch in branches)
+
+
+def model_loads(script):
+    return re.findall(r"LOAD_MODEL_FROM_GEO\(\s*(\w+),\s*(\w+)\)", script)
+
+
+def main():
+    scripts = read("levels/scripts.c")
+    global_funcs = dict(re.findall(r"const LevelScript (script_func_global_\d+)\[\] = \{(.*?)\};", scripts, re.S))
+    boot = model_loads(re.search(r"level_main_scripts_entry\[\] = \{(.*?)\};", scripts, re.S).group(1))
+
+    levels = sys.argv[1:] or sorted(d for d in os.listdir(os.path.join(ROOT, "levels"))
+                                    if os.path.exists(os.path.join(ROOT, "levels", d, "script.c")))
+    cached = set(boot)
+    print("boot: %d models, %d nodes" % (len(boot), sum(layout_nodes(g) for _, g in boot)))
+    print("%-17s %14s | %14s | %5s" % ("", "without cache", "with cache", "area"))
+    print("%-17s %6s %7s | %6s %7s | %5s" % ("level", "models", "nodes", "parsed", "nodes", "nodes"))
+
+    totals = [0] * 5
+    for level in levels:
+        script = read("levels/%s/script.c" % level)
+        loads = model_loads(script)
+        for func in re.findall(r"JUMP_LINK\((script_func_global_\d+)\)", script):
+            loads += model_loads(global_funcs[func])
+        # A pair loaded twice in one level is only parsed once with the cache
+        parsed = list(dict.fromkeys(load for load in loads if load not in cached))
+        cached.update(parsed)
+        areas = re.findall(r"AREA\(/\*index\*/\s*\d+,\s*(\w+)\)", script)
+
+        row = (len(loads), sum(layout_nodes(g) for _, g in loads), len(parsed),
+               sum(layout_nodes(g) for _, g in parsed), sum(layout_nodes(g) for g in areas))
+        totals = [a + b for a, b in zip(totals, row)]
+        print("%-17s %6d %7d | %6d %7d | %5d" % ((level,) + row))
+    print("%-17s %6d %7d | %6d %7d | %5d" % (("all %d levels" % len(levels),) + tuple(totals)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# Counts how many object updates OBJECT_UPDATE_LOD skips in the areas of a level, from the objects
+# placed in its macro, special and script object lists. Mario is put at the level's start and then
+# at every placed object in turn. Objects spawned at run time (coins of coin formations, goombas of
+# triplet spawners...) are not counted, and objects of every act are.
+#
+# usage: tools/count_lod_updates.py <level>...    e.g. tools/count_lod_updates.py bob wf thi
+import math
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+
+def read(path):
+    with open(os.path.join(ROOT, path)) as f:
+        return f.read()
+
+
+def read_config_float(name):
+    return float(re.search(r"#define " + name + r"\s+([\d.]+)f", read("include/config.h")).group(1))
+
+
+HALF_RATE_DIST = read_config_float("OBJECT_UPDATE_LOD_HALF_RATE_DIST")
+QUARTER_RATE_DIST = read_config_float("OBJECT_UPDATE_LOD_QUARTER_RATE_DIST")
+SUSPEND_DIST = read_config_float("OBJECT_UPDATE_LOD_SUSPEND_DIST")
+# oDrawingDistance as spawn_object sets it outside TTC
+DRAWING_DIST = 4000.0
+
+
+def lod_behaviors():
+    """Behaviors that set OBJ_FLAG_ALLOW_UPDATE_LOD, and those that jump into one of them."""
+    scripts = dict(re.findall(r"const BehaviorScript (\w+)\[\] = \{(.*?)\n\};", read("data/behavior_data.c"), re.S))
+    lod = {name for name, body in scripts.items() if "OBJ_FLAG_ALLOW_UPDATE_LOD" in body}
+    for name, body in scripts.items():
+        jump = re.search(r"GOTO\((\w+) \+ 1\)", body)
+        if jump is not None and jump.group(1) in lod:
+            lod.add(name)
+    return lod
+
+
+def macro_behaviors():
+    names = re.findall(r"^\s*(macro_\w+)", read("include/macro_preset_names.h"), re.M)
+    table = read("include/macro_presets.h").split("MacroObjectPresets[] = {")[1]
+    return dict(zip(names, re.findall(r"^\s*\{(\w+),", table, re.M)))
+
+
+def special_behaviors():
+    ids = {}
+    value = -1
+    for m in re.finditer(r"^\s*(special_\w+)(?:\s*=\s*(0x[0-9A-Fa-f]+|\d+))?\s*,", read("include/special_preset_names.h"), re.M):
+        value = int(m.group(2), 0) if m.group(2) else value + 1
+        ids[m.group(1)] = value
+    behaviors = {int(m.group(1), 16): m.group(2)
+                 for m in re.finditer(r"\{(0x[0-9A-Fa-f]+),[^}]*,\s*(\w+)\}", read("include/special_presets.h"))}
+    return {name: behaviors.get(preset) for name, preset in ids.items()}
+
+
+MACROS = macro_behaviors()
+SPECIALS = special_behaviors()
+
+
+def area_objects(level, area):
+    """The (behavior, x, y, z) of every object placed in the area, and Mario's start or None."""
+    objects = []
+    area_dir = "levels/%s/areas/%d/" % (level, area)
+    if os.path.exists(os.path.join(ROOT, area_dir + "macro.inc.c")):
+        for m in re.finditer(r"MACRO_OBJECT\w*\(/\*preset\*/\s*(\w+),\s*/\*yaw\*/\s*-?\d+,\s*/\*pos\*/\s*(-?\d+),\s*(-?\d+),\s*(-?\d+)",
+                             read(area_dir + "macro.inc.c")):
+            objects.append((MACROS[m.group(1)],) + tuple(map(int, m.group(2, 3, 4))))
+    for m in re.finditer(r"SPECIAL_OBJECT\w*\(/\*preset\*/\s*(\w+),\s*/\*pos\*/\s*(-?\d+),\s*(-?\d+),\s*(-?\d+)",
+                         read(area_dir + "collision.inc.c")):
+        objects.append((SPECIALS[m.group(1)],) + tuple(map(int, m.group(2, 3, 4))))
+
+    script = read("levels/%s/script.c" % level)
+    body = re.search(r"AREA\(/\*index\*/ %d,.*?END_AREA" % area, script, re.S).group(0)
+    for func in re.findall(r"JUMP_LINK\((script_func_local_\d+)\)", body):
+        body += re.search(r"%s\[\] = \{(.*?)\};" % func, script, re.S).group(1)
+    for m in re.finditer(r"OBJECT\w*\(/\*model\*/\s*\w+,\s*/\*pos\*/\s*(-?\d+),\s*(-?\d+),\s*(-?\d+),.*?/\*beh\*/\s*(\w+)", body):
+        objects.append((m.group(4),) + tuple(map(int, m.group(1, 2, 3))))
+
+    start = re.search(r"MARIO_POS\(/\*area\*/ %d, /\*yaw\*/ -?\d+, /\*pos\*/ (-?\d+),\s*(-?\d+),\s*(-?\d+)\)" % area, script)
+    return objects, tuple(map(int, start.group(1, 2, 3))) if start else None
+
+
+def skipped_updates(objects, lod, mario):
+    """The number of updates skipped per frame, on average, with Mario at the given point."""
+    skipped = 0.0
+    for behavior, x, y, z in objects:
+        if behavior not in lod:
+            continue
+        dist = math.dist((x, y, z), mario)
+        if dist < DRAWING_DIST or dist < HALF_RATE_DIST:
+            continue
+        skipped += 0.5 if dist < QUARTER_RATE_DIST else 0.75 if dist < SUSPEND_DIST else 1.0
+    return skipped
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: {} <level>...".format(sys.argv[0]))
+        sys.exit(1)
+
+    lod = lod_behaviors()
+    print("%-10s %6s %4s %9s %9s %6s" % ("area", "placed", "lod", "at start", "average", "share"))
+    for level in sys.argv[1:]:
+        script = read("levels/%s/script.c" % level)
+        for area in map(int, re.findall(r"AREA\(/\*index\*/ (\d+),", script)):
+            objects, start = area_objects(level, area)
+            if len(objects) == 0:
+                continue
+            num_lod = sum(1 for o in objects if o[0] in lod)
+            at_start = "%.1f" % skipped_updates(objects, lod, start) if start else "-"
+            average = sum(skipped_updates(objects, lod, o[1:]) for o in objects) / len(objects)
+            print("%-10s %6d %4d %9s %9.1f %5.0f%%" % ("%s %d" % (level, area), len(objects), num_lod, at_start,
+                                                     average, 100.0 * average / len(objects)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,13 @@
+# Flags shared by the host programs under tools/, which build parts of the game for the machine
+# they run on to test or time them. Each Makefile includes this and adds its own to CFLAGS.
+#
+# ARCH picks the instruction set they're built for, e.g. x86-64 (scalar), x86-64-v2 (SSE4.1),
+# x86-64-v3 (AVX2) or native. -fno-strict-aliasing and -fwrapv match the game's own build, some
+# of the engine code misbehaves at -O2 without them.
+
+CC      := gcc
+ARCH    ?= native
+CFLAGS  := -O2 -march=$(ARCH) -fwrapv -fno-strict-aliasing -fsigned-char -D_LANGUAGE_C \
+           -DVERSION_US=1 -DF3DEX_GBI_2E=1 -DNON_MATCHING=1 -DAVOID_UB=1 -DTARGET_LINUX \
+           -I../../include -I../../src -I../.. -Wall -Wno-unused-parameter -Wno-unused-function
+LDFLAGS := -lm
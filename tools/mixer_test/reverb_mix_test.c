@@ -0,0 +1,132 @@
+/*
+ * Checks aReverbMixImpl against the aDMEMMove and aMix sequences it replaces in the reverb
+ * code. Each mode is run from the same random DMEM contents both ways, with random gains
+ * (always including -0x8000, which aMix treats specially), buffer lengths and wet and dry
+ * addresses, and the whole DMEM must come out identical. Both random samples and quiet ones
+ * are used, so that the saturation and the rounding are checked.
+ *
+ * usage: reverb_mix_test [seed] [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ultra64.h>
+
+#include "pc/mixer.h"
+
+#define DMEM_SIZE 2512
+
+static int16_t sInitial[DMEM_SIZE / sizeof(int16_t)];
+static int16_t sExpected[DMEM_SIZE / sizeof(int16_t)];
+static int16_t sFused[DMEM_SIZE / sizeof(int16_t)];
+static uint32_t sRandomSeed;
+
+static uint32_t random_u32(void) {
+    sRandomSeed ^= sRandomSeed << 13;
+    sRandomSeed ^= sRandomSeed >> 17;
+    sRandomSeed ^= sRandomSeed << 5;
+    return sRandomSeed;
+}
+
+static void load_dmem(void) {
+    aSetBufferImpl(0, 0, 0, DMEM_SIZE);
+    aLoadBufferImpl(sInitial);
+}
+
+static void save_dmem(int16_t *dest) {
+    aSetBufferImpl(0, 0, 0, DMEM_SIZE);
+    aSaveBufferImpl(dest);
+}
+
+/**
+ * Run the commands the N64 build emits for this mode.
+ */
+static void run_original(int16_t gain, uint16_t wet, uint16_t dry, enum ReverbMixMode mode, int nbytes) {
+    switch (mode) {
+        case REVERB_MIX_COPY_TO_DRY:
+            aDMEMMoveImpl(wet, dry, nbytes);
+            aSetBufferImpl(0, 0, 0, nbytes);
+            aMixImpl(gain, wet, wet);
+            break;
+        case REVERB_MIX_ADD_TO_DRY:
+            aSetBufferImpl(0, 0, 0, nbytes);
+            aMixImpl(0x7fff, wet, dry);
+            aMixImpl(gain, wet, wet);
+            break;
+        case REVERB_MIX_COPY_FROM_DRY:
+            aSetBufferImpl(0, 0, 0, nbytes);
+            aMixImpl(gain, dry, dry);
+            aDMEMMoveImpl(dry, wet, nbytes);
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    static const char *modeNames[] = { "copy to dry", "add to dry", "copy from dry" };
+    int numIterations = argc > 2 ? atoi(argv[2]) : 60000;
+    int numFailed = 0;
+    int it, i, nbytes;
+    uint16_t wet, dry;
+    int16_t gain;
+    enum ReverbMixMode mode;
+
+    sRandomSeed = argc > 1 ? (uint32_t) atoi(argv[1]) : 1;
+    if (sRandomSeed == 0) {
+        sRandomSeed = 1;
+    }
+
+    for (it = 0; it < numIterations; it++) {
+        for (i = 0; i < DMEM_SIZE / (int) sizeof(int16_t); i++) {
+            sInitial[i] = (it & 1) ? (int16_t) random_u32() : (int16_t) (random_u32() % 2001 - 1000);
+        }
+        gain = (it % 5 == 0) ? (int16_t) 0x8000 : (int16_t) (0x8000 + (random_u32() & 0x7fff));
+        mode = it % 3;
+
+        // The game's lengths (0x280 on US/JP, 0x300 on EU) and others that fit in DMEM twice.
+        switch (random_u32() % 3) {
+            case 0:
+                nbytes = 0x280;
+                break;
+            case 1:
+                nbytes = 0x300;
+                break;
+            default:
+                nbytes = 0x20 * (1 + random_u32() % (DMEM_SIZE / 2 / 0x20));
+                break;
+        }
+        wet = 0x10 * (random_u32() % ((DMEM_SIZE - 2 * nbytes) / 0x10 + 1));
+        dry = wet + nbytes + 0x10 * (random_u32() % ((DMEM_SIZE - wet - 2 * nbytes) / 0x10 + 1));
+        if (random_u32() & 1) {
+            i = wet;
+            wet = dry;
+            dry = i;
+        }
+
+        load_dmem();
+        run_original(gain, wet, dry, mode, nbytes);
+        save_dmem(sExpected);
+
+        load_dmem();
+        aSetBufferImpl(0, 0, 0, nbytes);
+        aReverbMixImpl(gain, wet, dry, mode, nbytes);
+        save_dmem(sFused);
+
+        if (memcmp(sExpected, sFused, sizeof(sFused)) != 0) {
+            if (numFailed++ < 10) {
+                printf("%s: gain %d, wet 0x%x, dry 0x%x, length 0x%x differs\n", modeNames[mode], gain, wet,
+                       dry, nbytes);
+            }
+        }
+    }
+
+    printf("%s, %d iterations, %d mismatches\n",
+#if defined(__SSE4_1__)
+           "SSE4.1",
+#elif defined(__ARM_NEON)
+           "NEON",
+#else
+           "scalar",
+#endif
+           numIterations, numFailed);
+    return numFailed != 0;
+}
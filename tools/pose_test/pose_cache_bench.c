@@ -0,0 +1,217 @@
+/*
+ * Times geo_process_object on a crowd of Goombas playing the Goomba walk, and with
+ * ANIMATION_POSE_CACHE, prints the number of poses decoded per frame and the percentage of
+ * Goombas that reused one. The Goombas are laid out in rows in front of the camera, so they are
+ * all drawn, and walk either in step, spread evenly over the walk cycle, or each at its own
+ * speed like Goombas chasing Mario.
+ *
+ * usage: pose_cache_bench [goombas] [in step: 0, spread: 1, own speed: 2] [frames]
+ */
+#include "game/rendering_graph_node.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_GOOMBAS 512
+#define ALIGN8(val) (((val) + 0x7) & ~0x7)
+
+// What rendering_graph_node.c needs from the rest of the game.
+struct GraphNode gObjParentGraphNode;
+struct AllocOnlyPool *gGfxAllocOnlyPool;
+Gfx *gDisplayListHeadInChunk;
+Gfx *gDisplayListEndInChunk;
+struct MarioState *gMarioState;
+struct Object *gMarioObject;
+struct PlayerCameraState gPlayerCameraState[2];
+u16 gAreaUpdateCounter;
+s8 gShowDebugText;
+s8 gShadowAboveWaterOrLava;
+s8 gMarioOnIceOrCarpet;
+
+static u8 sDisplayListHeap[1 << 22];
+static u32 sDisplayListHeapUsed;
+static Gfx sDisplayList[1 << 18];
+
+void *alloc_display_list(u32 size) {
+    void *ptr = &sDisplayListHeap[sDisplayListHeapUsed];
+
+    sDisplayListHeapUsed += ALIGN8(size);
+    return ptr;
+}
+
+struct AllocOnlyPool *alloc_only_pool_init(void) {
+    return NULL;
+}
+
+void *alloc_only_pool_alloc(struct AllocOnlyPool *pool, s32 size) {
+    return alloc_display_list(size);
+}
+
+u32 main_pool_free(void *addr) {
+    return 0;
+}
+
+Gfx **alloc_next_dl(void) {
+    fprintf(stderr, "display list full\n");
+    exit(1);
+}
+
+void *segmented_to_virtual(const void *addr) {
+    return (void *) addr;
+}
+
+struct Surface *find_floor(f32 x, f32 y, f32 z, struct Surface **floor) {
+    return NULL;
+}
+
+Gfx *create_shadow_below_xyz(f32 x, f32 y, f32 z, s16 scale, u8 solidity, s8 type) {
+    return NULL;
+}
+
+void print_text_fmt_int(s32 x, s32 y, const char *str, s32 n) {
+}
+
+void clear_frame_buffer(s32 color) {
+}
+
+void make_viewport_clip_rect(Vp *viewport) {
+}
+
+void guPerspective(Mtx *m, u16 *perspNorm, float fovy, float aspect, float near, float far,
+                   float scale) {
+    *perspNorm = 0xFFFF;
+}
+
+void guOrtho(Mtx *m, float left, float right, float bottom, float top, float near, float far,
+             float scale) {
+}
+
+void guLookAtReflect(Mtx *m, LookAt *l, float xEye, float yEye, float zEye, float xAt, float yAt,
+                     float zAt, float xUp, float yUp, float zUp) {
+}
+
+#include "actors/goomba/anims/data.inc.c"
+
+static Gfx sPartDisplayList[1];
+static struct Object sGoombas[MAX_GOOMBAS];
+static struct GraphNodeScale sScale;
+static struct GraphNodeAnimatedPart sParts[7];
+static struct GraphNodeBillboard sBillboard;
+static struct GraphNodeDisplayList sBillboardDisplayList;
+static struct GraphNodeRoot sRoot;
+static struct GraphNodeMasterList sMasterList;
+static struct GraphNodePerspective sPerspective;
+static struct GraphNodeCamera sCamera;
+
+/**
+ * Build the part of goomba_geo below its shadow, with one of the two eye cases.
+ */
+static void build_goomba(void) {
+    Vec3s zero = { 0, 0, 0 };
+    Vec3s eyes = { 48, 0, 0 };
+    Vec3s leftFoot = { -60, -16, 45 };
+    Vec3s rightFoot = { -60, -16, -45 };
+
+    init_graph_node_scale(NULL, &sScale, 0, NULL, 1.0f);
+    init_graph_node_animated_part(NULL, &sParts[0], LAYER_OPAQUE, sPartDisplayList, zero);
+    init_graph_node_animated_part(NULL, &sParts[1], LAYER_OPAQUE, NULL, zero);
+    init_graph_node_billboard(NULL, &sBillboard, 0, NULL, zero);
+    init_graph_node_display_list(NULL, &sBillboardDisplayList, LAYER_ALPHA, sPartDisplayList);
+    init_graph_node_animated_part(NULL, &sParts[2], LAYER_OPAQUE, sPartDisplayList, eyes);
+    init_graph_node_animated_part(NULL, &sParts[3], LAYER_OPAQUE, NULL, leftFoot);
+    init_graph_node_animated_part(NULL, &sParts[4], LAYER_OPAQUE, sPartDisplayList, zero);
+    init_graph_node_animated_part(NULL, &sParts[5], LAYER_OPAQUE, NULL, rightFoot);
+    init_graph_node_animated_part(NULL, &sParts[6], LAYER_OPAQUE, sPartDisplayList, zero);
+
+    geo_add_child(&sScale.node, &sParts[0].node);
+    geo_add_child(&sParts[0].node, &sParts[1].node);
+    geo_add_child(&sParts[1].node, &sBillboard.node);
+    geo_add_child(&sBillboard.node, &sBillboardDisplayList.node);
+    geo_add_child(&sParts[1].node, &sParts[2].node);
+    geo_add_child(&sParts[1].node, &sParts[3].node);
+    geo_add_child(&sParts[3].node, &sParts[4].node);
+    geo_add_child(&sParts[1].node, &sParts[5].node);
+    geo_add_child(&sParts[5].node, &sParts[6].node);
+}
+
+static void spawn_goomba(struct Object *obj, s32 index, s32 mode) {
+    struct Animation *anim = (struct Animation *) &goomba_seg8_anim_0801DA34;
+    struct AnimInfo *animInfo = &obj->header.gfx.animInfo;
+
+    obj->header.gfx.node.flags = GRAPH_RENDER_ACTIVE | GRAPH_RENDER_HAS_ANIMATION;
+    obj->header.gfx.sharedChild = &sScale.node;
+    vec3f_set(obj->header.gfx.pos, (index % 16) * 150.0f - 1200.0f, (index / 16) * 100.0f - 600.0f,
+              -3000.0f);
+    vec3f_set(obj->header.gfx.scale, 1.0f, 1.0f, 1.0f);
+
+    animInfo->curAnim = anim;
+    animInfo->animFrame = mode == 0 ? 0 : (index * 7) % anim->loopEnd;
+    animInfo->animFrameAccelAssist = animInfo->animFrame << 16;
+    // Goombas play their walk at a speed that follows their forward velocity
+    animInfo->animAccel = mode == 2 ? 0x10000 * (0.5f + (index % 7) * 0.13f) : 0;
+}
+
+int main(int argc, char **argv) {
+    s32 numGoombas = argc > 1 ? atoi(argv[1]) : 20;
+    s32 mode = argc > 2 ? atoi(argv[2]) : 0;
+    s32 numFrames = argc > 3 ? atoi(argv[3]) : 5000;
+    struct timespec start, end;
+    f64 best = 1e30;
+    f64 total = 0.0;
+    s64 numHits = 0;
+    s64 numMisses = 0;
+    s32 frame, i;
+
+    numGoombas = MIN(numGoombas, MAX_GOOMBAS);
+    build_goomba();
+    for (i = 0; i < numGoombas; i++) {
+        spawn_goomba(&sGoombas[i], i, mode);
+    }
+
+    sPerspective.fov = 45.0f;
+    gCurGraphNodeRoot = &sRoot;
+    gCurGraphNodeMasterList = &sMasterList;
+    gCurGraphNodeCamFrustum = &sPerspective;
+    gCurGraphNodeCamera = &sCamera;
+
+    for (frame = 0; frame < numFrames; frame++) {
+        f64 time;
+
+        sDisplayListHeapUsed = 0;
+        gDisplayListHeadInChunk = sDisplayList;
+        gDisplayListEndInChunk = sDisplayList + ARRAY_COUNT(sDisplayList);
+        bzero(sMasterList.listHeads, sizeof(sMasterList.listHeads));
+        gAreaUpdateCounter++;
+        gMatStackIndex = 0;
+        mtxf_identity(gMatStack[0]);
+#ifdef ANIMATION_POSE_CACHE
+        sPoseRenderFrame++;
+        sPoseHits = 0;
+        sPoseMisses = 0;
+#endif
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (i = 0; i < numGoombas; i++) {
+            geo_process_object(&sGoombas[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        time = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+        total += time;
+        best = MIN(best, time);
+#ifdef ANIMATION_POSE_CACHE
+        numHits += sPoseHits;
+        numMisses += sPoseMisses;
+#endif
+    }
+
+    printf("%d goombas: %.2f us per frame (best), %.2f (mean)", numGoombas, best / 1000.0,
+           total / numFrames / 1000.0);
+    if (numHits + numMisses != 0) {
+        printf(", %.1f poses per frame, %.1f%% reused", (f64) numMisses / numFrames,
+               100.0 * numHits / (numHits + numMisses));
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Times update_game_sound with hundreds of sound requests a frame from hundreds of moving
+ * sources, each playing a few sounds in a few banks, some discrete and some continuous, with
+ * stop_sound and stop_sounds_from_source in between. It prints the time per frame and a hash
+ * of the sounds in use and what they set on the channels, which must come out the same when
+ * it is built against another version of external.c (see the Makefile).
+ *
+ * usage: sound_bank_bench [requests per frame] [frames]
+ */
+#ifndef EXTERNAL_C
+#define EXTERNAL_C "audio/external.c"
+#endif
+#include EXTERNAL_C
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_SOURCES 300
+
+// What external.c needs from the rest of the game and the audio driver.
+struct SequencePlayer gSequencePlayers[SEQUENCE_PLAYERS];
+struct SequenceChannel gSequenceChannelNone;
+struct AudioSessionSettings gAudioSessionPresets[18];
+u64 *gAudioCmdBuffers[2];
+volatile s32 gAudioFrameCount;
+u32 gAudioRandom;
+s8 gSoundMode;
+struct MarioState gMarioStates[1];
+s16 gCurrLevelNum;
+s16 gCurrAreaIndex;
+s16 gMarioCurrentRoom;
+
+void audio_reset_session(struct AudioSessionSettings *preset) {
+}
+
+void decrease_sample_dma_ttls(void) {
+}
+
+void load_sequence(u32 player, u32 seqId, s32 loadAsync) {
+}
+
+void preload_sequence(u32 seqId, u8 preloadMask) {
+}
+
+void sequence_player_disable(struct SequencePlayer *seqPlayer) {
+}
+
+u64 *synthesis_execute(u64 *cmdBuf, s32 *writtenCmds, s16 *aiBuf, s32 bufLen) {
+    return cmdBuf;
+}
+
+void osWritebackDCacheAll(void) {
+}
+
+static f32 sSources[NUM_SOURCES][3];
+static struct SequenceChannel sChannels[CHANNELS_MAX];
+static u32 sRandomSeed = 1;
+static u64 sHash = 1469598103934665603ULL;
+
+static u32 random_u32(void) {
+    sRandomSeed = sRandomSeed * 1103515245 + 12345;
+    return sRandomSeed >> 8;
+}
+
+static void hash(const void *data, size_t size) {
+    const u8 *bytes = data;
+
+    while (size-- != 0) {
+        sHash = (sHash ^ *bytes++) * 1099511628211ULL;
+    }
+}
+
+/**
+ * Hash the sounds in use and the channels. The slots that aren't in use keep whatever they last
+ * held, and source positions are hashed by index since the arrays move between builds.
+ */
+static s32 hash_sounds(void) {
+    struct SoundCharacteristics *sound;
+    s32 numLive = 0;
+    s32 bank, i, source;
+
+    for (bank = 0; bank < SOUND_BANK_COUNT; bank++) {
+        for (i = 0; i < 40; i++) {
+            sound = &sSoundBanks[bank][i];
+            if (i != 0 && sound->soundStatus == SOUND_STATUS_STOPPED) {
+                continue;
+            }
+            numLive += i != 0;
+            source = sound->x != NULL ? (f32 (*)[3]) sound->x - sSources : -1;
+            hash(&source, sizeof(source));
+            hash(&sound->soundBits, sizeof(sound->soundBits));
+            hash(&sound->distance, sizeof(sound->distance));
+            hash(&sound->priority, sizeof(sound->priority));
+            hash(&sound->soundStatus, sizeof(sound->soundStatus));
+            hash(&sound->freshness, sizeof(sound->freshness));
+            hash(&sound->prev, sizeof(sound->prev));
+            hash(&sound->next, sizeof(sound->next));
+        }
+        hash(sCurrentSound[bank], sizeof(sCurrentSound[bank]));
+        hash(&sNumSoundsInBank[bank], sizeof(sNumSoundsInBank[bank]));
+    }
+
+    for (i = 0; i < CHANNELS_MAX; i++) {
+        hash(&sChannels[i].volume, sizeof(sChannels[i].volume));
+        hash(&sChannels[i].pan, sizeof(sChannels[i].pan));
+        hash(&sChannels[i].freqScale, sizeof(sChannels[i].freqScale));
+        hash(&sChannels[i].reverbVol, sizeof(sChannels[i].reverbVol));
+        hash(sChannels[i].soundScriptIO, sizeof(sChannels[i].soundScriptIO));
+    }
+
+    return numLive;
+}
+
+int main(int argc, char **argv) {
+    s32 numRequests = argc > 1 ? atoi(argv[1]) : 200;
+    s32 numFrames = argc > 2 ? atoi(argv[2]) : 20000;
+    struct timespec start, end;
+    double totalTime = 0.0;
+    double totalLive = 0.0;
+    s32 frame, i, j;
+    u32 source, sound, bank, flags;
+
+    for (i = 0; i < CHANNELS_MAX; i++) {
+        gSequencePlayers[SEQ_PLAYER_SFX].channels[i] = &sChannels[i];
+    }
+    sound_init();
+    for (i = 0; i < NUM_SOURCES; i++) {
+        sSources[i][0] = (f32) (random_u32() % 8000) - 4000.0f;
+        sSources[i][1] = (f32) (random_u32() % 2000) - 1000.0f;
+        sSources[i][2] = (f32) (random_u32() % 8000) - 4000.0f;
+    }
+
+    for (frame = 0; frame < numFrames; frame++) {
+        for (i = 0; i < NUM_SOURCES; i++) {
+            for (j = 0; j < 3; j++) {
+                sSources[i][j] += (f32) (random_u32() % 21) - 10.0f;
+            }
+        }
+
+        // Like an object, each source plays one of a few sounds, each in its own bank.
+        for (i = 0; i < numRequests; i++) {
+            source = random_u32() % NUM_SOURCES;
+            sound = random_u32() % 3;
+            bank = (source * 7 + sound * 3) % SOUND_BANK_COUNT;
+            flags = (random_u32() % 4 == 0 ? SOUND_DISCRETE : 0)
+                    | (random_u32() % 8 == 0 ? SOUND_NO_VOLUME_LOSS : 0);
+            play_sound(SOUND_ARG_LOAD(bank, (source + sound) % 0x40, 0x40 + (source * 13 + sound) % 0xC0, flags),
+                       sSources[source]);
+        }
+        if (random_u32() % 4 == 0) {
+            stop_sounds_from_source(sSources[random_u32() % NUM_SOURCES]);
+        }
+        if (random_u32() % 4 == 0) {
+            source = random_u32() % NUM_SOURCES;
+            sound = random_u32() % 3;
+            stop_sound(SOUND_ARG_LOAD((source * 7 + sound * 3) % SOUND_BANK_COUNT, (source + sound) % 0x40, 0, 0),
+                       sSources[source]);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        update_game_sound();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        totalTime += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+
+        totalLive += hash_sounds();
+    }
+
+    printf("%d requests a frame, %.0f sounds in use: %.0f ns a frame, hash %016llx\n", numRequests,
+           totalLive / numFrames, totalTime / numFrames, (unsigned long long) sHash);
+    return 0;
+}